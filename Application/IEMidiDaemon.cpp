@@ -0,0 +1,317 @@
+// SPDX-License-Identifier: GPL-2.0-only
+// Copyright © Interactive Echoes. All rights reserved.
+// Author: mozahzah
+
+#include "IEMidiDaemon.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+
+#include "qstandardpaths.h"
+#include "qtimer.h"
+#include "ryml.hpp"
+#include "ryml_std.hpp"
+
+static constexpr char IEMIDI_DAEMON_CONFIG_FILENAME[] = "daemon.yaml";
+static constexpr char DAEMON_DEVICES_NODE_NAME[] = "Devices";
+static constexpr int TERMINATION_POLL_INTERVAL_MS = 250;
+
+static std::atomic<bool> bTerminationRequested = false;
+
+IEMidiDaemon::IEMidiDaemon(int& Argc, char** Argv) :
+    QCoreApplication(Argc, Argv),
+    m_MidiProcessor(std::make_unique<IEMidiProcessor>())
+{
+    // Shares the profiles of the GUI build, which derives its data location from the application name
+    setApplicationName("IEMidi");
+    m_MidiProfileManager = std::make_unique<IEMidiProfileManager>();
+
+    const std::string ConfigFlag = std::string("--config");
+    const std::string VirtualFlag = std::string("--virtual");
+    const std::string StatsFlag = std::string("--stats");
+    const std::string CommandConcurrencyFlag = std::string("--command-concurrency");
+    const std::string CommandQueueFlag = std::string("--command-queue");
+    const std::string CommandOverflowFlag = std::string("--command-overflow");
+    const std::string CaptureFlag = std::string("--capture");
+    const std::string CaptureMaxSizeFlag = std::string("--capture-max-size");
+    const std::string CaptureMaxFilesFlag = std::string("--capture-max-files");
+    int StatsIntervalSeconds = 0;
+    IEMidiCommandRunnerConfig CommandRunnerConfig;
+    IEMidiCaptureConfig CaptureConfig;
+    for (int i = 1; i < Argc; i++)
+    {
+        const std::string Arg = Argv[i];
+        if (Arg == ConfigFlag && i + 1 < Argc)
+        {
+            m_ConfigFilePath = std::filesystem::path(Argv[++i]);
+        }
+        else if (Arg == VirtualFlag && i + 1 < Argc)
+        {
+            m_VirtualMidiDeviceNames.emplace_back(Argv[++i]);
+        }
+        else if (Arg == StatsFlag && i + 1 < Argc)
+        {
+            StatsIntervalSeconds = std::atoi(Argv[++i]);
+        }
+        else if (Arg == CommandConcurrencyFlag && i + 1 < Argc)
+        {
+            CommandRunnerConfig.MaxConcurrentCommandCount = static_cast<uint32_t>(std::max(std::atoi(Argv[++i]), 1));
+        }
+        else if (Arg == CommandQueueFlag && i + 1 < Argc)
+        {
+            CommandRunnerConfig.MaxQueuedCommandCount = static_cast<uint32_t>(std::max(std::atoi(Argv[++i]), 1));
+        }
+        else if (Arg == CommandOverflowFlag && i + 1 < Argc)
+        {
+            const std::string OverflowPolicy = Argv[++i];
+            if (OverflowPolicy == "drop-newest")
+            {
+                CommandRunnerConfig.OverflowPolicy = IEMidiCommandOverflowPolicy::DropNewest;
+            }
+            else if (OverflowPolicy == "drop-oldest")
+            {
+                CommandRunnerConfig.OverflowPolicy = IEMidiCommandOverflowPolicy::DropOldest;
+            }
+            else if (OverflowPolicy == "replace")
+            {
+                CommandRunnerConfig.OverflowPolicy = IEMidiCommandOverflowPolicy::ReplacePending;
+            }
+            else
+            {
+                IELOG_ERROR("Unknown command overflow policy %s, expected drop-newest, drop-oldest or replace", OverflowPolicy.c_str());
+            }
+        }
+        else if (Arg == CaptureFlag && i + 1 < Argc)
+        {
+            CaptureConfig.FolderPath = std::filesystem::path(Argv[++i]);
+        }
+        else if (Arg == CaptureMaxSizeFlag && i + 1 < Argc)
+        {
+            CaptureConfig.MaxFileSize = static_cast<uint64_t>(std::max(std::atoi(Argv[++i]), 1)) * 1024 * 1024;
+        }
+        else if (Arg == CaptureMaxFilesFlag && i + 1 < Argc)
+        {
+            CaptureConfig.MaxFileCount = static_cast<uint32_t>(std::max(std::atoi(Argv[++i]), 0));
+        }
+        else
+        {
+            m_MidiDeviceNames.emplace_back(Arg);
+        }
+    }
+
+    m_MidiProcessor->SetCommandRunnerConfig(CommandRunnerConfig);
+
+    if (!CaptureConfig.FolderPath.empty())
+    {
+        const IEResult Result = m_MidiProcessor->StartMidiCapture(CaptureConfig);
+        if (Result)
+        {
+            IELOG_SUCCESS("%s", Result.Message.c_str());
+        }
+        else
+        {
+            IELOG_ERROR("%s", Result.Message.c_str());
+        }
+    }
+
+    if (m_ConfigFilePath.empty())
+    {
+        const std::filesystem::path IEMidiConfigFolderPath = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation).toStdString();
+        m_ConfigFilePath = IEMidiConfigFolderPath / IEMIDI_DAEMON_CONFIG_FILENAME;
+    }
+
+    if (m_MidiDeviceNames.empty() && m_VirtualMidiDeviceNames.empty())
+    {
+        m_MidiDeviceNames = GetConfiguredMidiDeviceNames();
+    }
+
+    for (const std::string& MidiDeviceName : m_MidiDeviceNames)
+    {
+        const IEResult Result = ActivateMidiDeviceProfile(MidiDeviceName, false);
+        if (Result)
+        {
+            IELOG_SUCCESS("%s", Result.Message.c_str());
+        }
+        else
+        {
+            IELOG_ERROR("%s", Result.Message.c_str());
+        }
+    }
+
+    for (const std::string& MidiDeviceName : m_VirtualMidiDeviceNames)
+    {
+        const IEResult Result = ActivateMidiDeviceProfile(MidiDeviceName, true);
+        if (Result)
+        {
+            IELOG_SUCCESS("%s", Result.Message.c_str());
+        }
+        else
+        {
+            IELOG_ERROR("%s", Result.Message.c_str());
+        }
+    }
+
+    if (GetActiveMidiDeviceCount() == 0)
+    {
+        IELOG_ERROR("No midi device profile activated, pass device names or list them under %s in %s",
+            DAEMON_DEVICES_NODE_NAME, m_ConfigFilePath.string().c_str());
+    }
+
+    m_MidiProfileWatcher = std::make_unique<IEMidiProfileWatcher>(*m_MidiProcessor, *m_MidiProfileManager);
+    m_MidiProfileWatcher->WatchActiveMidiDeviceProfiles();
+
+    InstallSignalHandlers();
+    IEMidiStartupStats::Log("IEMidiDaemon", GetActiveMidiDeviceCount());
+
+    if (StatsIntervalSeconds > 0)
+    {
+        StartStatsTimer(StatsIntervalSeconds);
+    }
+}
+
+IEMidiDaemon::~IEMidiDaemon()
+{
+    m_MidiProcessor->DeactivateAllMidiDeviceProfiles();
+    m_MidiProcessor->StopMidiCapture();
+}
+
+std::vector<std::string> IEMidiDaemon::GetConfiguredMidiDeviceNames() const
+{
+    std::vector<std::string> MidiDeviceNames;
+    if (std::FILE* const ConfigFile = std::fopen(m_ConfigFilePath.string().c_str(), "rb"))
+    {
+        std::string Content;
+        std::fseek(ConfigFile, 0, SEEK_END);
+        const long Size = std::ftell(ConfigFile);
+        if (Size > 0)
+        {
+            Content.resize(Size);
+            std::rewind(ConfigFile);
+            std::fread(Content.data(), 1, Size, ConfigFile);
+        }
+        std::fclose(ConfigFile);
+
+        const ryml::Tree ConfigTree = ryml::parse_in_arena(ryml::to_csubstr(Content));
+        const ryml::ConstNodeRef Root = ConfigTree.rootref();
+        if (Root.is_map() && Root.has_child(DAEMON_DEVICES_NODE_NAME))
+        {
+            const ryml::ConstNodeRef DevicesNode = Root[DAEMON_DEVICES_NODE_NAME];
+            if (DevicesNode.is_seq())
+            {
+                for (const ryml::ConstNodeRef DeviceNode : DevicesNode.children())
+                {
+                    std::string MidiDeviceName;
+                    DeviceNode >> MidiDeviceName;
+                    if (!MidiDeviceName.empty())
+                    {
+                        MidiDeviceNames.emplace_back(MidiDeviceName);
+                    }
+                }
+            }
+        }
+    }
+    return MidiDeviceNames;
+}
+
+IEResult IEMidiDaemon::ActivateMidiDeviceProfile(const std::string& MidiDeviceName, bool bIsVirtual)
+{
+    IEResult Result = bIsVirtual ? m_MidiProcessor->ActivateVirtualMidiDeviceProfile(MidiDeviceName) :
+        m_MidiProcessor->ActivateMidiDeviceProfile(MidiDeviceName);
+    if (Result)
+    {
+        IEMidiDeviceProfile& ActiveMidiDeviceProfile = m_MidiProcessor->GetActiveMidiDeviceProfile();
+        if (m_MidiProfileManager && m_MidiProfileManager->LoadProfile(ActiveMidiDeviceProfile))
+        {
+            m_MidiProcessor->CompileActiveMidiDeviceProfile();
+            for (const IEMidiDeviceOutputProperty& MidiDeviceOutputProperty : ActiveMidiDeviceProfile.OutputProperties)
+            {
+                m_MidiProcessor->SendMidiOutputMessage(MidiDeviceOutputProperty.MidiMessage);
+            }
+        }
+        else if (bIsVirtual)
+        {
+            // Without a saved profile a virtual device still measures the callback and dispatch stages
+            IELOG_ERROR("No saved profile for virtual midi device %s, incoming messages will not trigger actions", MidiDeviceName.c_str());
+        }
+        else
+        {
+            m_MidiProcessor->DeactivateMidiDeviceProfile(MidiDeviceName);
+            Result.Type = IEResult::Type::Fail;
+            Result.Message = std::format("Failed to load a saved profile for midi device {}", MidiDeviceName);
+        }
+    }
+    return Result;
+}
+
+void IEMidiDaemon::StartStatsTimer(int IntervalSeconds)
+{
+    m_LastActionWorkerStats = m_MidiProcessor->GetActionWorkerStats();
+    m_LastStatsTime = std::chrono::steady_clock::now();
+
+    QTimer* const StatsTimer = new QTimer(this);
+    connect(StatsTimer, &QTimer::timeout, this, &IEMidiDaemon::LogStats);
+    StatsTimer->start(IntervalSeconds * 1000);
+}
+
+void IEMidiDaemon::LogStats()
+{
+    const IEMidiActionWorkerStats ActionWorkerStats = m_MidiProcessor->GetActionWorkerStats();
+    const std::chrono::steady_clock::time_point Now = std::chrono::steady_clock::now();
+    const std::chrono::duration<double> Elapsed = Now - m_LastStatsTime;
+
+    const uint64_t ProcessedCount = ActionWorkerStats.ProcessedCount - m_LastActionWorkerStats.ProcessedCount;
+    const uint64_t DroppedCount = ActionWorkerStats.DroppedCount - m_LastActionWorkerStats.DroppedCount;
+    const double Throughput = Elapsed.count() > 0.0 ? ProcessedCount / Elapsed.count() : 0.0;
+    IELOG_SUCCESS("Processed %llu midi message(s) at %.1f msg/s, dropped %llu, peak queue depth %llu, coalesced %llu, truncated %llu",
+        static_cast<unsigned long long>(ProcessedCount), Throughput, static_cast<unsigned long long>(DroppedCount),
+        static_cast<unsigned long long>(ActionWorkerStats.PeakQueueDepth),
+        static_cast<unsigned long long>(m_MidiProcessor->GetCoalescedUpdateCount()),
+        static_cast<unsigned long long>(m_MidiProcessor->GetTruncatedMessageCount()));
+
+    const IEMidiCommandRunnerStats CommandRunnerStats = m_MidiProcessor->GetCommandRunnerStats();
+    IELOG_SUCCESS("Ran %llu console command(s), failed %llu, replaced %llu, dropped %llu, peak queue depth %llu",
+        static_cast<unsigned long long>(CommandRunnerStats.ExecutedCount), static_cast<unsigned long long>(CommandRunnerStats.FailedCount),
+        static_cast<unsigned long long>(CommandRunnerStats.ReplacedCount), static_cast<unsigned long long>(CommandRunnerStats.DroppedCount),
+        static_cast<unsigned long long>(CommandRunnerStats.PeakQueueDepth));
+
+    if (m_MidiProcessor->IsMidiCaptureRunning())
+    {
+        const IEMidiCaptureStats CaptureStats = m_MidiProcessor->GetMidiCaptureStats();
+        IELOG_SUCCESS("Captured %llu midi message(s), wrote %llu to %u file(s) in %.1f MB, dropped %llu, truncated %llu, peak queue depth %llu",
+            static_cast<unsigned long long>(CaptureStats.CapturedCount), static_cast<unsigned long long>(CaptureStats.WrittenCount),
+            CaptureStats.FileCount, CaptureStats.WrittenByteCount / (1024.0 * 1024.0),
+            static_cast<unsigned long long>(CaptureStats.DroppedCount), static_cast<unsigned long long>(CaptureStats.TruncatedCount),
+            static_cast<unsigned long long>(CaptureStats.PeakQueueDepth));
+    }
+
+    const std::string LatencyHistograms = m_MidiProcessor->DumpLatencyHistograms();
+    IELOG_SUCCESS("%s", LatencyHistograms.c_str());
+
+    m_LastActionWorkerStats = ActionWorkerStats;
+    m_LastStatsTime = Now;
+}
+
+void IEMidiDaemon::InstallSignalHandlers()
+{
+    std::signal(SIGINT, &IEMidiDaemon::OnTerminationSignal);
+    std::signal(SIGTERM, &IEMidiDaemon::OnTerminationSignal);
+
+    // Quitting from inside a signal handler is not safe, so the event loop polls for it
+    QTimer* const TerminationTimer = new QTimer(this);
+    connect(TerminationTimer, &QTimer::timeout, this, []()
+        {
+            if (bTerminationRequested.load(std::memory_order_relaxed))
+            {
+                QCoreApplication::quit();
+            }
+        });
+    TerminationTimer->start(TERMINATION_POLL_INTERVAL_MS);
+}
+
+void IEMidiDaemon::OnTerminationSignal(int Signal)
+{
+    bTerminationRequested.store(true, std::memory_order_relaxed);
+}
\ No newline at end of file
@@ -0,0 +1,56 @@
+// SPDX-License-Identifier: GPL-2.0-only
+// Copyright © Interactive Echoes. All rights reserved.
+// Author: mozahzah
+
+#pragma once
+
+#include <chrono>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "qcoreapplication.h"
+
+#include "IELog.h"
+
+#include "IEMidiProcessor.h"
+#include "IEMidiProfileManager.h"
+#include "IEMidiStartupStats.h"
+#include "IEMidiProfileWatcher.h"
+
+// Headless host that routes midi for the profiles named on the command line, or listed in
+// daemon.yaml next to the profiles folder. Only links Qt Core, no widgets, fonts or styles are loaded.
+// Virtual devices open a port other applications can write to, so the full pipeline can be driven
+// by a synthetic midi source and measured with the periodic stats output.
+class IEMidiDaemon : public QCoreApplication
+{
+public:
+    IEMidiDaemon(int& Argc, char** Argv);
+    ~IEMidiDaemon();
+
+public:
+    size_t GetActiveMidiDeviceCount() const { return m_MidiProcessor->GetActiveMidiDeviceNames().size(); }
+
+private:
+    std::vector<std::string> GetConfiguredMidiDeviceNames() const;
+    IEResult ActivateMidiDeviceProfile(const std::string& MidiDeviceName, bool bIsVirtual);
+    void StartStatsTimer(int IntervalSeconds);
+    void LogStats();
+    void InstallSignalHandlers();
+
+private:
+    static void OnTerminationSignal(int Signal);
+
+private:
+    const std::unique_ptr<IEMidiProcessor> m_MidiProcessor;
+    std::unique_ptr<IEMidiProfileManager> m_MidiProfileManager;
+    std::unique_ptr<IEMidiProfileWatcher> m_MidiProfileWatcher;
+    std::vector<std::string> m_MidiDeviceNames;
+    std::vector<std::string> m_VirtualMidiDeviceNames;
+    std::filesystem::path m_ConfigFilePath;
+
+private:
+    IEMidiActionWorkerStats m_LastActionWorkerStats;
+    std::chrono::steady_clock::time_point m_LastStatsTime;
+};
\ No newline at end of file
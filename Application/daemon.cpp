@@ -0,0 +1,11 @@
+// SPDX-License-Identifier: GPL-2.0-only
+// Copyright © Interactive Echoes. All rights reserved.
+// Author: mozahzah
+
+#include "IEMidiDaemon.h"
+
+int main(int Argc, char* Argv[])
+{
+    IEMidiDaemon IEMidiDaemon(Argc, Argv);
+    return IEMidiDaemon.exec();
+}
\ No newline at end of file
@@ -0,0 +1,92 @@
+// SPDX-License-Identifier: GPL-2.0-only
+// Copyright © Interactive Echoes. All rights reserved.
+// Author: mozahzah
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <limits>
+#include <string>
+
+#include "IEMidiTypes.h"
+
+// Distinct (status, data 1) keys made by MakeBenchmarkMidiMessage, every channel of control
+// changes, notes and poly aftertouch. Consecutive keys cycle through the three message types, so
+// any key range holds all of them.
+static constexpr uint32_t BENCHMARK_KEY_COUNT = 3 * 16 * 128;
+
+// Read back by the benchmarks so the optimizer can't drop the work they measure
+inline volatile uint64_t BenchmarkSink = 0;
+
+// xorshift32, keeps the generated traffic the same from run to run
+inline uint32_t NextBenchmarkRandom(uint32_t& State)
+{
+    State ^= State << 13;
+    State ^= State >> 17;
+    State ^= State << 5;
+    return State;
+}
+
+// Nanoseconds per call of Function, best of RepetitionCount runs of IterationCount calls
+template<typename FunctionType>
+double MeasureNanosecondsPerIteration(size_t IterationCount, FunctionType&& Function, uint32_t RepetitionCount = 5)
+{
+    double BestNanoseconds = std::numeric_limits<double>::max();
+    for (uint32_t Repetition = 0; Repetition < RepetitionCount; Repetition++)
+    {
+        const std::chrono::steady_clock::time_point StartTime = std::chrono::steady_clock::now();
+        for (size_t Iteration = 0; Iteration < IterationCount; Iteration++)
+        {
+            Function(Iteration);
+        }
+        const std::chrono::duration<double, std::nano> Elapsed = std::chrono::steady_clock::now() - StartTime;
+        BestNanoseconds = std::min(BestNanoseconds, Elapsed.count() / static_cast<double>(IterationCount));
+    }
+    return BestNanoseconds;
+}
+
+inline IEMidiMessage MakeBenchmarkMidiMessage(uint32_t KeyIndex, uint8_t Value)
+{
+    static constexpr std::array<uint8_t, 3> STATUS_TYPES = {0xB0, 0x90, 0xA0};
+    const uint32_t Key = KeyIndex % BENCHMARK_KEY_COUNT;
+    const uint32_t Control = Key / STATUS_TYPES.size();
+    const uint8_t Status = static_cast<uint8_t>(STATUS_TYPES[Key % STATUS_TYPES.size()] | (Control / 128));
+    return IEMidiMessage({Status, static_cast<uint8_t>(Control % 128), Value});
+}
+
+inline IEMidiMessageType GetBenchmarkMidiMessageType(const IEMidiMessage& MidiMessage)
+{
+    switch (MidiMessage.GetStatus() & 0xF0)
+    {
+        case 0x90: return IEMidiMessageType::NoteOnOff;
+        case 0xA0: return IEMidiMessageType::PolyAftertouch;
+        case 0xB0: return IEMidiMessageType::ControlChange;
+        default: return IEMidiMessageType::None;
+    }
+}
+
+// Appends PropertyCount input properties cycling through every action type. Past BENCHMARK_KEY_COUNT
+// properties the keys repeat, like a control bound to several actions.
+inline void FillBenchmarkProfile(IEMidiDeviceProfile& MidiDeviceProfile, uint32_t PropertyCount)
+{
+    for (uint32_t PropertyIndex = 0; PropertyIndex < PropertyCount; PropertyIndex++)
+    {
+        IEMidiDeviceInputProperty& MidiDeviceInputProperty = MidiDeviceProfile.MakeInputProperty();
+        MidiDeviceInputProperty.MidiMessage = MakeBenchmarkMidiMessage(PropertyIndex, 0);
+        MidiDeviceInputProperty.MidiMessageType = GetBenchmarkMidiMessageType(MidiDeviceInputProperty.MidiMessage);
+        MidiDeviceInputProperty.MidiActionType = static_cast<IEMidiActionType>(1 + PropertyIndex % (static_cast<uint32_t>(IEMidiActionType::Count) - 1));
+        MidiDeviceInputProperty.bIsMidiToggle = IsTriggerMidiMessageType(MidiDeviceInputProperty.MidiMessageType) && PropertyIndex % 2 == 0;
+        if (MidiDeviceInputProperty.MidiActionType == IEMidiActionType::ConsoleCommand)
+        {
+            MidiDeviceInputProperty.ConsoleCommand = "echo IEMidiBenchmark " + std::to_string(PropertyIndex);
+        }
+        else if (MidiDeviceInputProperty.MidiActionType == IEMidiActionType::OpenFile)
+        {
+            MidiDeviceInputProperty.OpenFilePath = "IEMidiBenchmark/" + std::to_string(PropertyIndex) + ".txt";
+        }
+    }
+}
\ No newline at end of file
@@ -0,0 +1,63 @@
+// SPDX-License-Identifier: GPL-2.0-only
+// Copyright © Interactive Echoes. All rights reserved.
+// Author: mozahzah
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+
+#include "IEMidiActionBackend.h"
+
+// Counts the actions it is asked to apply instead of touching the system. An optional busy wait per
+// action stands in for slow volume APIs or process launches.
+class IEMidiBenchmarkActionBackend : public IEMidiActionBackend
+{
+public:
+    explicit IEMidiBenchmarkActionBackend(std::chrono::nanoseconds ActionCost = std::chrono::nanoseconds::zero()) :
+        m_ActionCost(ActionCost)
+    {}
+
+public:
+    bool IsSupported(IEMidiActionType MidiActionType) const override { return MidiActionType != IEMidiActionType::None; }
+    void SetVolume(float Volume) override { Apply(IEMidiActionType::Volume); }
+    bool GetMute() const override { return m_bIsMuted; }
+    void SetMute(bool bIsMuted) override { m_bIsMuted = bIsMuted; Apply(IEMidiActionType::Mute); }
+    void ExecuteConsoleCommand(const std::shared_ptr<const IEMidiCompiledCommand>& CompiledCommand, float Value) override { Apply(IEMidiActionType::ConsoleCommand); }
+    void OpenFile(const std::filesystem::path& OpenFilePath) override { Apply(IEMidiActionType::OpenFile); }
+
+public:
+    uint64_t GetAppliedCount(IEMidiActionType MidiActionType) const
+    {
+        return m_AppliedCounts[static_cast<size_t>(MidiActionType)].load(std::memory_order_relaxed);
+    }
+
+    uint64_t GetTotalAppliedCount() const
+    {
+        uint64_t TotalAppliedCount = 0;
+        for (const std::atomic<uint64_t>& AppliedCount : m_AppliedCounts)
+        {
+            TotalAppliedCount += AppliedCount.load(std::memory_order_relaxed);
+        }
+        return TotalAppliedCount;
+    }
+
+private:
+    void Apply(IEMidiActionType MidiActionType)
+    {
+        if (m_ActionCost > std::chrono::nanoseconds::zero())
+        {
+            const std::chrono::steady_clock::time_point EndTime = std::chrono::steady_clock::now() + m_ActionCost;
+            while (std::chrono::steady_clock::now() < EndTime)
+            {
+            }
+        }
+        m_AppliedCounts[static_cast<size_t>(MidiActionType)].fetch_add(1, std::memory_order_relaxed);
+    }
+
+private:
+    const std::chrono::nanoseconds m_ActionCost;
+    std::array<std::atomic<uint64_t>, static_cast<size_t>(IEMidiActionType::Count)> m_AppliedCounts = {};
+    bool m_bIsMuted = false;
+};
\ No newline at end of file
@@ -0,0 +1,106 @@
+// SPDX-License-Identifier: GPL-2.0-only
+// Copyright © Interactive Echoes. All rights reserved.
+// Author: mozahzah
+
+#include <memory>
+#include <vector>
+
+#include "IEMidiBenchmark.h"
+#include "IEMidiCompiledProfile.h"
+
+// Input property as it was before IEMidiDispatchTable, every incoming message walked this list
+struct IEMidiListInputProperty
+{
+    IEMidiListInputProperty* Next() const { return NextProperty.get(); }
+
+    IEMidiMessageType MidiMessageType = IEMidiMessageType::None;
+    IEMidiActionType MidiActionType = IEMidiActionType::None;
+    std::string ConsoleCommand = std::string();
+    std::filesystem::path OpenFilePath = std::filesystem::path();
+    std::array<uint8_t, MIDI_MESSAGE_BYTE_COUNT> MidiMessage = {0, 0, 0};
+    bool bIsMidiToggle = false;
+    bool bIsRecording = false;
+    bool bIsConsoleCommandActive = false;
+    std::shared_ptr<IEMidiListInputProperty> NextProperty;
+};
+
+static constexpr uint32_t MESSAGE_COUNT = 1 << 16;
+
+int main()
+{
+    std::printf("%10s %16s %16s %10s\n", "Mappings", "List ns/msg", "Table ns/msg", "Speedup");
+    for (const uint32_t PropertyCount : {10u, 100u, 1000u, 10000u})
+    {
+        IEMidiDeviceProfile MidiDeviceProfile("IEMidiBenchmark", 0, 0);
+        FillBenchmarkProfile(MidiDeviceProfile, PropertyCount);
+        const IEMidiCompiledProfile CompiledProfile(MidiDeviceProfile);
+
+        std::shared_ptr<IEMidiListInputProperty> InputPropertiesHead;
+        IEMidiListInputProperty* InputPropertiesTail = nullptr;
+        for (const IEMidiDeviceInputProperty& MidiDeviceInputProperty : MidiDeviceProfile.InputProperties)
+        {
+            std::shared_ptr<IEMidiListInputProperty> ListInputProperty = std::make_shared<IEMidiListInputProperty>();
+            ListInputProperty->MidiMessageType = MidiDeviceInputProperty.MidiMessageType;
+            ListInputProperty->MidiActionType = MidiDeviceInputProperty.MidiActionType;
+            ListInputProperty->ConsoleCommand = MidiDeviceInputProperty.ConsoleCommand;
+            ListInputProperty->OpenFilePath = MidiDeviceInputProperty.OpenFilePath;
+            ListInputProperty->MidiMessage = {MidiDeviceInputProperty.MidiMessage[0], MidiDeviceInputProperty.MidiMessage[1], MidiDeviceInputProperty.MidiMessage[2]};
+            IEMidiListInputProperty* NewTail = ListInputProperty.get();
+            (InputPropertiesTail ? InputPropertiesTail->NextProperty : InputPropertiesHead) = std::move(ListInputProperty);
+            InputPropertiesTail = NewTail;
+        }
+
+        // Nine in ten messages hit a mapped control, the rest are unmapped pitch bends
+        std::vector<IEMidiMessage> MidiMessages;
+        MidiMessages.reserve(MESSAGE_COUNT);
+        uint32_t RandomState = 0x1E3D1;
+        for (uint32_t MessageIndex = 0; MessageIndex < MESSAGE_COUNT; MessageIndex++)
+        {
+            const uint32_t Random = NextBenchmarkRandom(RandomState);
+            if (Random % 10 == 0)
+            {
+                MidiMessages.push_back(IEMidiMessage({static_cast<uint8_t>(0xE0 | (Random >> 8) % 16), static_cast<uint8_t>((Random >> 12) % 128), 64}));
+            }
+            else
+            {
+                MidiMessages.push_back(MakeBenchmarkMidiMessage((Random >> 8) % std::min(PropertyCount, BENCHMARK_KEY_COUNT), static_cast<uint8_t>(Random % 128)));
+            }
+        }
+
+        const size_t IterationCount = PropertyCount > 1000 ? MESSAGE_COUNT / 16 : MESSAGE_COUNT;
+        uint64_t ListMatchCount = 0;
+        const double ListNanoseconds = MeasureNanosecondsPerIteration(IterationCount, [&](size_t Iteration)
+        {
+            const IEMidiMessage& MidiMessage = MidiMessages[Iteration];
+            for (const IEMidiListInputProperty* ListInputProperty = InputPropertiesHead.get(); ListInputProperty; ListInputProperty = ListInputProperty->Next())
+            {
+                if (ListInputProperty->MidiMessage.size() >= 3 &&
+                    ListInputProperty->MidiMessage[0] == MidiMessage[0] &&
+                    ListInputProperty->MidiMessage[1] == MidiMessage[1])
+                {
+                    ListMatchCount += static_cast<uint64_t>(ListInputProperty->MidiActionType);
+                }
+            }
+        });
+
+        uint64_t TableMatchCount = 0;
+        const double TableNanoseconds = MeasureNanosecondsPerIteration(IterationCount, [&](size_t Iteration)
+        {
+            const IEMidiMatchRange MatchRange = CompiledProfile.Find(MidiMessages[Iteration]);
+            for (uint32_t EntryIndex = MatchRange.Begin; EntryIndex < MatchRange.End; EntryIndex++)
+            {
+                TableMatchCount += static_cast<uint64_t>(CompiledProfile.GetMatch(EntryIndex).MidiActionType);
+            }
+        });
+
+        if (ListMatchCount != TableMatchCount)
+        {
+            std::printf("Mismatch at %u mappings, list matched %llu and table %llu\n", PropertyCount,
+                static_cast<unsigned long long>(ListMatchCount), static_cast<unsigned long long>(TableMatchCount));
+            return 1;
+        }
+        BenchmarkSink = TableMatchCount;
+        std::printf("%10u %16.1f %16.1f %9.0fx\n", PropertyCount, ListNanoseconds, TableNanoseconds, ListNanoseconds / TableNanoseconds);
+    }
+    return 0;
+}
\ No newline at end of file
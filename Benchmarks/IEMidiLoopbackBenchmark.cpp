@@ -0,0 +1,311 @@
+// SPDX-License-Identifier: GPL-2.0-only
+// Copyright © Interactive Echoes. All rights reserved.
+// Author: mozahzah
+
+#include <array>
+#include <chrono>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "RtMidi.h"
+
+#include "IEMidiBenchmark.h"
+#include "IEMidiBenchmarkActionBackend.h"
+#include "IEMidiProcessor.h"
+
+// Drives a virtual input port of a processor from a second RtMidi client, so messages take the same
+// path as a hardware device: RtMidi input thread, action worker, then actions on a counting backend.
+// Needs a backend with virtual ports, ALSA, JACK or CoreMIDI.
+
+static constexpr const char* LOOPBACK_PORT_NAME = "IEMidiLoopback";
+static constexpr std::chrono::milliseconds IDLE_TIMEOUT = std::chrono::milliseconds(2000);
+
+enum class IEMidiTrafficPattern : uint8_t
+{
+    ControlChangeFlood, // One fader swept as fast as possible
+    Chords,             // Bursts of notes sent back to back, then released
+    Mixed,              // Controls, chords, aftertouch, program changes and SysEx
+
+    Count,
+};
+
+struct IEMidiLoopbackConfig
+{
+    uint32_t MessageCount = 100000;
+    uint32_t MessageRate = 0;   // Messages per second, 0 sends as fast as the port takes them
+    uint32_t MappingCount = 300;
+    uint32_t ChordSize = 8;
+    std::chrono::nanoseconds ActionCost = std::chrono::nanoseconds::zero();
+    std::vector<IEMidiTrafficPattern> TrafficPatterns;
+};
+
+// Messages of one burst are sent back to back, pacing only waits before a burst
+struct IEMidiTrafficMessage
+{
+    std::vector<unsigned char> Bytes;
+    bool bIsBurstStart = true;
+};
+
+static const char* GetTrafficPatternName(IEMidiTrafficPattern TrafficPattern)
+{
+    switch (TrafficPattern)
+    {
+        case IEMidiTrafficPattern::ControlChangeFlood: return "cc-flood";
+        case IEMidiTrafficPattern::Chords: return "chord";
+        case IEMidiTrafficPattern::Mixed: return "mixed";
+        default: return "none";
+    }
+}
+
+static std::vector<unsigned char> ToBytes(const IEMidiMessage& MidiMessage)
+{
+    return std::vector<unsigned char>(MidiMessage.data(), MidiMessage.data() + MidiMessage.size());
+}
+
+static void AppendChord(std::vector<IEMidiTrafficMessage>& TrafficMessages, uint32_t ChordSize, uint32_t NoteKeyCount, uint32_t& RandomState)
+{
+    // Note keys are the keys congruent to 1 mod 3, see MakeBenchmarkMidiMessage
+    const uint32_t RootNote = NextBenchmarkRandom(RandomState) % NoteKeyCount;
+    for (const uint8_t Velocity : {uint8_t(100), uint8_t(0)})
+    {
+        for (uint32_t NoteIndex = 0; NoteIndex < ChordSize; NoteIndex++)
+        {
+            const uint32_t KeyIndex = ((RootNote + NoteIndex) % NoteKeyCount) * 3 + 1;
+            TrafficMessages.push_back({ToBytes(MakeBenchmarkMidiMessage(KeyIndex, Velocity)), NoteIndex == 0});
+        }
+    }
+}
+
+static std::vector<IEMidiTrafficMessage> MakeTraffic(IEMidiTrafficPattern TrafficPattern, const IEMidiLoopbackConfig& Config)
+{
+    std::vector<IEMidiTrafficMessage> TrafficMessages;
+    TrafficMessages.reserve(Config.MessageCount + Config.ChordSize * 2);
+
+    const uint32_t ControlKeyCount = std::max(std::min(Config.MappingCount, BENCHMARK_KEY_COUNT) / 3, 1u);
+    uint32_t RandomState = 0x1E3D1;
+    while (TrafficMessages.size() < Config.MessageCount)
+    {
+        const uint32_t Random = NextBenchmarkRandom(RandomState);
+        const uint8_t Value = static_cast<uint8_t>(TrafficMessages.size() % 128);
+        if (TrafficPattern == IEMidiTrafficPattern::ControlChangeFlood)
+        {
+            TrafficMessages.push_back({ToBytes(MakeBenchmarkMidiMessage(0, Value)), true});
+        }
+        else if (TrafficPattern == IEMidiTrafficPattern::Chords)
+        {
+            AppendChord(TrafficMessages, Config.ChordSize, ControlKeyCount, RandomState);
+        }
+        else
+        {
+            const uint32_t Roll = Random % 100;
+            if (Roll < 60)
+            {
+                TrafficMessages.push_back({ToBytes(MakeBenchmarkMidiMessage((Random >> 8) % ControlKeyCount * 3, Value)), true});
+            }
+            else if (Roll < 80)
+            {
+                AppendChord(TrafficMessages, Config.ChordSize, ControlKeyCount, RandomState);
+            }
+            else if (Roll < 90)
+            {
+                TrafficMessages.push_back({ToBytes(MakeBenchmarkMidiMessage((Random >> 8) % ControlKeyCount * 3 + 2, Value)), true});
+            }
+            else if (Roll < 95)
+            {
+                TrafficMessages.push_back({{static_cast<unsigned char>(0xC0 | (Random >> 8) % 16), static_cast<unsigned char>((Random >> 12) % 128)}, true});
+            }
+            else
+            {
+                std::vector<unsigned char> SysExBytes = {0xF0, 0x7D};
+                SysExBytes.resize(31, static_cast<unsigned char>((Random >> 8) % 128));
+                SysExBytes.push_back(0xF7);
+                TrafficMessages.push_back({std::move(SysExBytes), true});
+            }
+        }
+    }
+    TrafficMessages.resize(Config.MessageCount);
+    return TrafficMessages;
+}
+
+static bool OpenLoopbackPort(RtMidiOut& MidiDriver)
+{
+    for (unsigned int PortNumber = 0; PortNumber < MidiDriver.getPortCount(); PortNumber++)
+    {
+        if (MidiDriver.getPortName(PortNumber).find(LOOPBACK_PORT_NAME) != std::string::npos)
+        {
+            MidiDriver.openPort(PortNumber);
+            return true;
+        }
+    }
+    return false;
+}
+
+static void PrintLatency(const char* Label, const IEMidiLatencySnapshot& LatencySnapshot)
+{
+    const auto ToMicroseconds = [](std::chrono::nanoseconds Nanoseconds) { return Nanoseconds.count() / 1000.0; };
+    std::printf("  %-28s %10llu %10.1f %10.1f %10.1f %10.1f\n", Label, static_cast<unsigned long long>(LatencySnapshot.Count),
+        ToMicroseconds(LatencySnapshot.GetPercentile(50.0)), ToMicroseconds(LatencySnapshot.GetPercentile(99.0)),
+        ToMicroseconds(LatencySnapshot.GetPercentile(99.9)), ToMicroseconds(LatencySnapshot.GetMax()));
+}
+
+static void RunTrafficPattern(IEMidiTrafficPattern TrafficPattern, const IEMidiLoopbackConfig& Config, IEMidiProcessor& MidiProcessor,
+    const IEMidiBenchmarkActionBackend& ActionBackend, RtMidiOut& MidiDriver)
+{
+    const std::vector<IEMidiTrafficMessage> TrafficMessages = MakeTraffic(TrafficPattern, Config);
+    MidiProcessor.ResetLatencyHistograms();
+    const IEMidiActionWorkerStats StartStats = MidiProcessor.GetActionWorkerStats();
+    const uint64_t StartAppliedCount = ActionBackend.GetTotalAppliedCount();
+
+    const std::chrono::steady_clock::time_point StartTime = std::chrono::steady_clock::now();
+    for (size_t MessageIndex = 0; MessageIndex < TrafficMessages.size(); MessageIndex++)
+    {
+        if (Config.MessageRate > 0 && TrafficMessages[MessageIndex].bIsBurstStart)
+        {
+            std::this_thread::sleep_until(StartTime + std::chrono::nanoseconds(MessageIndex * 1'000'000'000ull / Config.MessageRate));
+        }
+        MidiDriver.sendMessage(&TrafficMessages[MessageIndex].Bytes);
+    }
+    const std::chrono::duration<double> SendDuration = std::chrono::steady_clock::now() - StartTime;
+
+    // Done once everything sent was either processed or dropped, or when nothing moved for a while
+    IEMidiActionWorkerStats Stats = StartStats;
+    std::chrono::steady_clock::time_point LastProgressTime = std::chrono::steady_clock::now();
+    while (Stats.ProcessedCount + Stats.DroppedCount - StartStats.ProcessedCount - StartStats.DroppedCount < TrafficMessages.size() &&
+        std::chrono::steady_clock::now() - LastProgressTime < IDLE_TIMEOUT)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        const IEMidiActionWorkerStats NewStats = MidiProcessor.GetActionWorkerStats();
+        if (NewStats.ProcessedCount != Stats.ProcessedCount || NewStats.DroppedCount != Stats.DroppedCount)
+        {
+            LastProgressTime = std::chrono::steady_clock::now();
+        }
+        Stats = NewStats;
+    }
+    const std::chrono::duration<double> Duration = LastProgressTime - StartTime;
+
+    const uint64_t ProcessedCount = Stats.ProcessedCount - StartStats.ProcessedCount;
+    const uint64_t DroppedCount = Stats.DroppedCount - StartStats.DroppedCount;
+    const uint64_t LostCount = TrafficMessages.size() - std::min<uint64_t>(ProcessedCount + DroppedCount, TrafficMessages.size());
+    std::printf("%s: sent %zu in %.3f s, processed %llu in %.3f s (%.0f msg/s), dropped %llu, lost before the callback %llu, "
+        "peak queue depth %llu, actions applied %llu\n",
+        GetTrafficPatternName(TrafficPattern), TrafficMessages.size(), SendDuration.count(), static_cast<unsigned long long>(ProcessedCount),
+        Duration.count(), Duration.count() > 0.0 ? ProcessedCount / Duration.count() : 0.0, static_cast<unsigned long long>(DroppedCount),
+        static_cast<unsigned long long>(LostCount), static_cast<unsigned long long>(Stats.PeakQueueDepth),
+        static_cast<unsigned long long>(ActionBackend.GetTotalAppliedCount() - StartAppliedCount));
+
+    std::printf("  %-28s %10s %10s %10s %10s %10s\n", "Latency (us)", "Count", "p50", "p99", "p99.9", "Max");
+    static constexpr std::array<const char*, static_cast<size_t>(IEMidiLatencyStage::Count)> STAGE_NAMES = {"callback", "dispatch", "completion"};
+    for (uint32_t ActionTypeIndex = 0; ActionTypeIndex < static_cast<uint32_t>(IEMidiActionType::Count); ActionTypeIndex++)
+    {
+        const IEMidiActionType MidiActionType = static_cast<IEMidiActionType>(ActionTypeIndex);
+        for (uint32_t StageIndex = 0; StageIndex < static_cast<uint32_t>(IEMidiLatencyStage::Count); StageIndex++)
+        {
+            const IEMidiLatencySnapshot LatencySnapshot = MidiProcessor.GetLatencySnapshot(MidiActionType, static_cast<IEMidiLatencyStage>(StageIndex));
+            if (LatencySnapshot.Count > 0)
+            {
+                const std::string Label = std::string(GetMidiActionTypeName(MidiActionType)) + " " + STAGE_NAMES[StageIndex];
+                PrintLatency(Label.c_str(), LatencySnapshot);
+            }
+        }
+    }
+}
+
+int main(int Argc, char* Argv[])
+{
+    const std::string MessagesFlag = std::string("--messages");
+    const std::string RateFlag = std::string("--rate");
+    const std::string MappingsFlag = std::string("--mappings");
+    const std::string ChordSizeFlag = std::string("--chord-size");
+    const std::string ActionCostFlag = std::string("--action-cost-us");
+    const std::string PatternFlag = std::string("--pattern");
+
+    IEMidiLoopbackConfig Config;
+    for (int i = 1; i < Argc; i++)
+    {
+        const std::string Arg = Argv[i];
+        if (Arg == MessagesFlag && i + 1 < Argc)
+        {
+            Config.MessageCount = static_cast<uint32_t>(std::max(std::atoi(Argv[++i]), 1));
+        }
+        else if (Arg == RateFlag && i + 1 < Argc)
+        {
+            Config.MessageRate = static_cast<uint32_t>(std::max(std::atoi(Argv[++i]), 0));
+        }
+        else if (Arg == MappingsFlag && i + 1 < Argc)
+        {
+            Config.MappingCount = static_cast<uint32_t>(std::max(std::atoi(Argv[++i]), 3));
+        }
+        else if (Arg == ChordSizeFlag && i + 1 < Argc)
+        {
+            Config.ChordSize = static_cast<uint32_t>(std::max(std::atoi(Argv[++i]), 1));
+        }
+        else if (Arg == ActionCostFlag && i + 1 < Argc)
+        {
+            Config.ActionCost = std::chrono::microseconds(std::max(std::atoi(Argv[++i]), 0));
+        }
+        else if (Arg == PatternFlag && i + 1 < Argc)
+        {
+            const std::string PatternName = Argv[++i];
+            bool bIsKnownPattern = false;
+            for (uint32_t PatternIndex = 0; PatternIndex < static_cast<uint32_t>(IEMidiTrafficPattern::Count); PatternIndex++)
+            {
+                if (PatternName == GetTrafficPatternName(static_cast<IEMidiTrafficPattern>(PatternIndex)))
+                {
+                    Config.TrafficPatterns.push_back(static_cast<IEMidiTrafficPattern>(PatternIndex));
+                    bIsKnownPattern = true;
+                }
+            }
+            if (!bIsKnownPattern)
+            {
+                std::printf("Unknown traffic pattern %s, expected cc-flood, chord or mixed\n", PatternName.c_str());
+                return 1;
+            }
+        }
+        else
+        {
+            std::printf("Usage: %s [--pattern cc-flood|chord|mixed]... [--messages N] [--rate msg/s] [--mappings N] "
+                "[--chord-size N] [--action-cost-us N]\n", Argv[0]);
+            return 1;
+        }
+    }
+    if (Config.TrafficPatterns.empty())
+    {
+        Config.TrafficPatterns = {IEMidiTrafficPattern::ControlChangeFlood, IEMidiTrafficPattern::Chords, IEMidiTrafficPattern::Mixed};
+    }
+
+    std::unique_ptr<IEMidiBenchmarkActionBackend> ActionBackend = std::make_unique<IEMidiBenchmarkActionBackend>(Config.ActionCost);
+    const IEMidiBenchmarkActionBackend& ActionBackendRef = *ActionBackend;
+    IEMidiProcessor MidiProcessor(std::move(ActionBackend));
+
+    const IEResult Result = MidiProcessor.ActivateVirtualMidiDeviceProfile(LOOPBACK_PORT_NAME);
+    if (!Result)
+    {
+        std::printf("%s\n", Result.Message.c_str());
+        return 1;
+    }
+    FillBenchmarkProfile(MidiProcessor.GetActiveMidiDeviceProfile(), Config.MappingCount);
+    MidiProcessor.CompileActiveMidiDeviceProfile();
+
+    RtMidiOut MidiDriver;
+    if (!OpenLoopbackPort(MidiDriver))
+    {
+        std::printf("Virtual port %s not found, the %s backend may not support virtual ports\n", LOOPBACK_PORT_NAME,
+            RtMidi::getApiDisplayName(MidiDriver.getCurrentApi()).c_str());
+        return 1;
+    }
+
+    std::printf("%u mappings, %u messages per pattern, %s, action cost %lld us\n", Config.MappingCount, Config.MessageCount,
+        Config.MessageRate > 0 ? (std::to_string(Config.MessageRate) + " msg/s").c_str() : "unpaced",
+        static_cast<long long>(std::chrono::duration_cast<std::chrono::microseconds>(Config.ActionCost).count()));
+    for (const IEMidiTrafficPattern TrafficPattern : Config.TrafficPatterns)
+    {
+        RunTrafficPattern(TrafficPattern, Config, MidiProcessor, ActionBackendRef, MidiDriver);
+    }
+
+    MidiDriver.closePort();
+    MidiProcessor.DeactivateAllMidiDeviceProfiles();
+    return 0;
+}
\ No newline at end of file
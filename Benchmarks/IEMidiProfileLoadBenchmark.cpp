@@ -0,0 +1,105 @@
+// SPDX-License-Identifier: GPL-2.0-only
+// Copyright © Interactive Echoes. All rights reserved.
+// Author: mozahzah
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <vector>
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include "qcoreapplication.h"
+#include "qstandardpaths.h"
+
+#include "IEMidiBenchmark.h"
+#include "IEMidiProfileManager.h"
+
+static constexpr uint32_t COLD_RUN_COUNT = 5;
+static constexpr uint32_t WARM_RUN_COUNT = 21;
+
+// Drops the file from the page cache so the next read goes to the disk, only done on Linux
+static bool EvictFile(const std::filesystem::path& FilePath)
+{
+#if defined(__linux__)
+    const int FileDescriptor = open(FilePath.c_str(), O_RDONLY);
+    if (FileDescriptor < 0)
+    {
+        return false;
+    }
+    fdatasync(FileDescriptor);
+    const bool bIsEvicted = posix_fadvise(FileDescriptor, 0, 0, POSIX_FADV_DONTNEED) == 0;
+    close(FileDescriptor);
+    return bIsEvicted;
+#else
+    return false;
+#endif
+}
+
+// Median microseconds of LoadProfile into a fresh profile
+static double MeasureLoadMicroseconds(IEMidiProfileManager& MidiProfileManager, const std::string& MidiDeviceName,
+    bool bIsCold, uint32_t RunCount)
+{
+    const std::filesystem::path ProfileFilePath = MidiProfileManager.GetIEMidiProfileFilePath(MidiDeviceName);
+
+    std::vector<double> Microseconds;
+    for (uint32_t Run = 0; Run < RunCount; Run++)
+    {
+        if (bIsCold)
+        {
+            EvictFile(ProfileFilePath);
+        }
+
+        IEMidiDeviceProfile MidiDeviceProfile(MidiDeviceName, 0, 0);
+        const std::chrono::steady_clock::time_point StartTime = std::chrono::steady_clock::now();
+        const IEResult Result = MidiProfileManager.LoadProfile(MidiDeviceProfile);
+        const std::chrono::duration<double, std::micro> Elapsed = std::chrono::steady_clock::now() - StartTime;
+        if (!Result)
+        {
+            std::printf("%s\n", Result.Message.c_str());
+            return 0.0;
+        }
+        BenchmarkSink = BenchmarkSink + MidiDeviceProfile.InputProperties.Size();
+        Microseconds.push_back(Elapsed.count());
+    }
+
+    std::sort(Microseconds.begin(), Microseconds.end());
+    return Microseconds[Microseconds.size() / 2];
+}
+
+int main(int argc, char** argv)
+{
+    // Test mode keeps the profiles written here out of the user's profiles folder
+    QCoreApplication::setApplicationName("IEMidiBenchmark");
+    QStandardPaths::setTestModeEnabled(true);
+    QCoreApplication Application(argc, argv);
+
+    IEMidiProfileManager MidiProfileManager;
+#if !defined(__linux__)
+    std::printf("Files can't be evicted from the page cache on this platform, cold runs are warm\n");
+#endif
+    std::printf("%10s %16s %16s\n", "Mappings", "Cold us", "Warm us");
+    for (const uint32_t PropertyCount : {10u, 100u, 1000u, 10000u})
+    {
+        IEMidiDeviceProfile MidiDeviceProfile("IEMidiBenchmark " + std::to_string(PropertyCount), 0, 0);
+        FillBenchmarkProfile(MidiDeviceProfile, PropertyCount);
+
+        IEMidiProfileBatch ProfileBatch;
+        ProfileBatch.SaveProfile(MidiDeviceProfile);
+        if (const IEResult Result = MidiProfileManager.CommitProfileBatch(ProfileBatch); !Result)
+        {
+            std::printf("%s\n", Result.Message.c_str());
+            return 1;
+        }
+
+        const double ColdMicroseconds = MeasureLoadMicroseconds(MidiProfileManager, MidiDeviceProfile.NameID, true, COLD_RUN_COUNT);
+        const double WarmMicroseconds = MeasureLoadMicroseconds(MidiProfileManager, MidiDeviceProfile.NameID, false, WARM_RUN_COUNT);
+        std::printf("%10u %16.1f %16.1f\n", PropertyCount, ColdMicroseconds, WarmMicroseconds);
+
+        MidiProfileManager.RemoveProfile(MidiDeviceProfile);
+    }
+    return 0;
+}
\ No newline at end of file
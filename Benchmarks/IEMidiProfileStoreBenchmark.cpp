@@ -0,0 +1,149 @@
+// SPDX-License-Identifier: GPL-2.0-only
+// Copyright © Interactive Echoes. All rights reserved.
+// Author: mozahzah
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <vector>
+
+#include "qcoreapplication.h"
+#include "qstandardpaths.h"
+#include "ryml.hpp"
+#include "ryml_std.hpp"
+
+#include "IEMidiBenchmark.h"
+#include "IEMidiProfileManager.h"
+
+struct IEMidiProfileStoreSize
+{
+    uint32_t DeviceCount = 0;
+    uint32_t PropertyCount = 0;
+};
+
+static constexpr IEMidiProfileStoreSize PROFILE_STORE_SIZES[] = {
+    {1, 10}, {1, 1000}, {1, 10000},
+    {100, 100}, {100, 1000},
+    {10000, 10}
+};
+
+// Parse and load are timed on at most this many devices of a store
+static constexpr uint32_t MAX_SAMPLED_DEVICE_COUNT = 100;
+static constexpr uint32_t LOOKUP_ROUND_COUNT = 10;
+
+static double GetElapsedMicroseconds(std::chrono::steady_clock::time_point StartTime)
+{
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - StartTime).count();
+}
+
+static std::string ReadFile(const std::filesystem::path& FilePath)
+{
+    std::ifstream File(FilePath, std::ios::binary);
+    std::ostringstream Content;
+    Content << File.rdbuf();
+    return Content.str();
+}
+
+int main(int argc, char** argv)
+{
+    // Test mode keeps the profiles written here out of the user's profiles folder
+    QCoreApplication::setApplicationName("IEMidiBenchmark");
+    QStandardPaths::setTestModeEnabled(true);
+    QCoreApplication Application(argc, argv);
+
+    IEMidiProfileManager MidiProfileManager;
+
+    // Nodes/KB, Arena/KB and Nodes/map are what IEMidiProfileManager sizes its trees from, Grown counts
+    // the sampled files whose default constructed tree reallocated while parsing
+    std::printf("%8s %8s %12s %10s %10s %12s %10s %9s %9s %9s %6s\n", "Devices", "Mappings", "Emit us/dev", "Lookup ns",
+        "Parse us", "Reserved us", "Load us", "Nodes/KB", "Arena/KB", "Nodes/map", "Grown");
+    for (const IEMidiProfileStoreSize& ProfileStoreSize : PROFILE_STORE_SIZES)
+    {
+        std::vector<std::unique_ptr<IEMidiDeviceProfile>> MidiDeviceProfiles;
+        MidiDeviceProfiles.reserve(ProfileStoreSize.DeviceCount);
+        IEMidiProfileBatch ProfileBatch;
+        for (uint32_t DeviceIndex = 0; DeviceIndex < ProfileStoreSize.DeviceCount; DeviceIndex++)
+        {
+            MidiDeviceProfiles.emplace_back(std::make_unique<IEMidiDeviceProfile>("IEMidiBenchmark " + std::to_string(DeviceIndex), 0, 0));
+            FillBenchmarkProfile(*MidiDeviceProfiles.back(), ProfileStoreSize.PropertyCount);
+            ProfileBatch.SaveProfile(*MidiDeviceProfiles.back());
+        }
+
+        std::chrono::steady_clock::time_point StartTime = std::chrono::steady_clock::now();
+        if (const IEResult Result = MidiProfileManager.CommitProfileBatch(ProfileBatch); !Result)
+        {
+            std::printf("%s\n", Result.Message.c_str());
+            return 1;
+        }
+        const double EmitMicroseconds = GetElapsedMicroseconds(StartTime) / ProfileStoreSize.DeviceCount;
+
+        StartTime = std::chrono::steady_clock::now();
+        for (uint32_t Round = 0; Round < LOOKUP_ROUND_COUNT; Round++)
+        {
+            for (const std::unique_ptr<IEMidiDeviceProfile>& MidiDeviceProfile : MidiDeviceProfiles)
+            {
+                BenchmarkSink = BenchmarkSink + MidiProfileManager.HasProfile(*MidiDeviceProfile);
+            }
+        }
+        const double LookupNanoseconds = GetElapsedMicroseconds(StartTime) * 1000.0 / (LOOKUP_ROUND_COUNT * ProfileStoreSize.DeviceCount);
+
+        const uint32_t SampledDeviceCount = std::min(ProfileStoreSize.DeviceCount, MAX_SAMPLED_DEVICE_COUNT);
+        double ParseMicroseconds = 0.0;
+        double ReservedParseMicroseconds = 0.0;
+        double LoadMicroseconds = 0.0;
+        size_t ContentSize = 0;
+        size_t NodeCount = 0;
+        size_t ArenaCharCount = 0;
+        uint32_t GrownTreeCount = 0;
+        for (uint32_t DeviceIndex = 0; DeviceIndex < SampledDeviceCount; DeviceIndex++)
+        {
+            const std::string& MidiDeviceName = MidiDeviceProfiles[DeviceIndex]->NameID;
+            const std::filesystem::path ProfileFilePath = MidiProfileManager.GetIEMidiProfileFilePath(MidiDeviceName);
+            const std::string Content = ReadFile(ProfileFilePath);
+
+            ryml::Tree Tree;
+            const size_t InitialCapacity = Tree.capacity();
+            const size_t InitialArenaCapacity = Tree.arena_capacity();
+            StartTime = std::chrono::steady_clock::now();
+            ryml::parse_in_arena(ryml::to_csubstr(Content), &Tree);
+            ParseMicroseconds += GetElapsedMicroseconds(StartTime);
+            GrownTreeCount += Tree.capacity() != InitialCapacity || Tree.arena_capacity() != InitialArenaCapacity;
+
+            ryml::Tree ReservedTree;
+            ReservedTree.reserve(Tree.size());
+            ReservedTree.reserve_arena(Tree.arena_size());
+            StartTime = std::chrono::steady_clock::now();
+            ryml::parse_in_arena(ryml::to_csubstr(Content), &ReservedTree);
+            ReservedParseMicroseconds += GetElapsedMicroseconds(StartTime);
+
+            ContentSize += Content.size();
+            NodeCount += Tree.size();
+            ArenaCharCount += Tree.arena_size();
+
+            IEMidiDeviceProfile LoadedMidiDeviceProfile(MidiDeviceName, 0, 0);
+            StartTime = std::chrono::steady_clock::now();
+            MidiProfileManager.LoadProfile(LoadedMidiDeviceProfile);
+            LoadMicroseconds += GetElapsedMicroseconds(StartTime);
+            BenchmarkSink = BenchmarkSink + LoadedMidiDeviceProfile.InputProperties.Size();
+        }
+
+        const double ContentKilobytes = static_cast<double>(ContentSize) / 1024.0;
+        std::printf("%8u %8u %12.1f %10.1f %10.1f %12.1f %10.1f %9.1f %9.1f %9.1f %6u\n",
+            ProfileStoreSize.DeviceCount, ProfileStoreSize.PropertyCount, EmitMicroseconds, LookupNanoseconds,
+            ParseMicroseconds / SampledDeviceCount, ReservedParseMicroseconds / SampledDeviceCount,
+            LoadMicroseconds / SampledDeviceCount,
+            NodeCount / ContentKilobytes, ArenaCharCount / ContentKilobytes,
+            static_cast<double>(NodeCount) / (SampledDeviceCount * ProfileStoreSize.PropertyCount), GrownTreeCount);
+
+        IEMidiProfileBatch RemoveProfileBatch;
+        for (const std::unique_ptr<IEMidiDeviceProfile>& MidiDeviceProfile : MidiDeviceProfiles)
+        {
+            RemoveProfileBatch.RemoveProfile(MidiDeviceProfile->NameID);
+        }
+        MidiProfileManager.CommitProfileBatch(RemoveProfileBatch);
+    }
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,117 @@
+// SPDX-License-Identifier: GPL-2.0-only
+// Copyright © Interactive Echoes. All rights reserved.
+// Author: mozahzah
+
+#include <memory>
+
+#include "IEMidiBenchmark.h"
+
+// Input property as it was before IEMidiSlotMap, every append walked the list to its tail
+struct IEMidiListInputProperty
+{
+    IEMidiListInputProperty* Next() const { return NextProperty.get(); }
+
+    IEMidiMessageType MidiMessageType = IEMidiMessageType::None;
+    IEMidiActionType MidiActionType = IEMidiActionType::None;
+    std::string ConsoleCommand = std::string();
+    std::filesystem::path OpenFilePath = std::filesystem::path();
+    IEMidiMessage MidiMessage = IEMidiMessage({0, 0, 0});
+    bool bIsMidiToggle = false;
+    const std::shared_ptr<IEMidiInputPropertyState> RuntimeState = std::make_shared<IEMidiInputPropertyState>();
+    std::weak_ptr<IEMidiListInputProperty> PreviousProperty;
+    std::shared_ptr<IEMidiListInputProperty> NextProperty;
+};
+
+static IEMidiListInputProperty& MakeListInputProperty(std::shared_ptr<IEMidiListInputProperty>& InputPropertiesHead)
+{
+    if (std::shared_ptr<IEMidiListInputProperty> ListInputProperty = InputPropertiesHead)
+    {
+        while (ListInputProperty->Next())
+        {
+            ListInputProperty = ListInputProperty->NextProperty;
+        }
+        ListInputProperty->NextProperty = std::make_shared<IEMidiListInputProperty>();
+        ListInputProperty->NextProperty->PreviousProperty = ListInputProperty;
+        return *ListInputProperty->NextProperty;
+    }
+    InputPropertiesHead = std::make_shared<IEMidiListInputProperty>();
+    return *InputPropertiesHead;
+}
+
+// Long lists are destroyed one node at a time instead of recursing through the shared_ptrs
+static void DestroyListInputProperties(std::shared_ptr<IEMidiListInputProperty>& InputPropertiesHead)
+{
+    while (InputPropertiesHead)
+    {
+        InputPropertiesHead = std::shared_ptr<IEMidiListInputProperty>(InputPropertiesHead->NextProperty);
+    }
+}
+
+int main()
+{
+    std::printf("%10s %14s %14s %14s %14s\n", "Mappings", "List load ns", "Slot load ns", "List iter ns", "Slot iter ns");
+    for (const uint32_t PropertyCount : {10u, 100u, 1000u, 10000u})
+    {
+        IEMidiDeviceProfile SourceMidiDeviceProfile("IEMidiBenchmark", 0, 0);
+        FillBenchmarkProfile(SourceMidiDeviceProfile, PropertyCount);
+
+        // Load appends every property the way the profile loaders do, iteration reads every one
+        std::shared_ptr<IEMidiListInputProperty> InputPropertiesHead;
+        const double ListLoadNanoseconds = MeasureNanosecondsPerIteration(1, [&](size_t)
+        {
+            DestroyListInputProperties(InputPropertiesHead);
+            for (const IEMidiDeviceInputProperty& SourceInputProperty : SourceMidiDeviceProfile.InputProperties)
+            {
+                IEMidiListInputProperty& ListInputProperty = MakeListInputProperty(InputPropertiesHead);
+                ListInputProperty.MidiMessageType = SourceInputProperty.MidiMessageType;
+                ListInputProperty.MidiActionType = SourceInputProperty.MidiActionType;
+                ListInputProperty.ConsoleCommand = SourceInputProperty.ConsoleCommand;
+                ListInputProperty.OpenFilePath = SourceInputProperty.OpenFilePath;
+                ListInputProperty.MidiMessage = SourceInputProperty.MidiMessage;
+                ListInputProperty.bIsMidiToggle = SourceInputProperty.bIsMidiToggle;
+            }
+        }, 3) / PropertyCount;
+
+        std::unique_ptr<IEMidiDeviceProfile> MidiDeviceProfile;
+        const double SlotLoadNanoseconds = MeasureNanosecondsPerIteration(1, [&](size_t)
+        {
+            MidiDeviceProfile = std::make_unique<IEMidiDeviceProfile>("IEMidiBenchmark", 0, 0);
+            MidiDeviceProfile->InputProperties.Reserve(PropertyCount);
+            for (const IEMidiDeviceInputProperty& SourceInputProperty : SourceMidiDeviceProfile.InputProperties)
+            {
+                MidiDeviceProfile->MakeInputProperty().CopyMapping(SourceInputProperty);
+            }
+        }, 3) / PropertyCount;
+
+        const size_t IterationCount = std::max<size_t>(1, 1000000 / PropertyCount);
+        uint64_t ListSum = 0;
+        const double ListIterationNanoseconds = MeasureNanosecondsPerIteration(IterationCount, [&](size_t)
+        {
+            for (const IEMidiListInputProperty* ListInputProperty = InputPropertiesHead.get(); ListInputProperty; ListInputProperty = ListInputProperty->Next())
+            {
+                ListSum += ListInputProperty->MidiMessage[1] + static_cast<uint64_t>(ListInputProperty->MidiActionType);
+            }
+        }) / PropertyCount;
+
+        uint64_t SlotSum = 0;
+        const double SlotIterationNanoseconds = MeasureNanosecondsPerIteration(IterationCount, [&](size_t)
+        {
+            for (const IEMidiDeviceInputProperty& MidiDeviceInputProperty : MidiDeviceProfile->InputProperties)
+            {
+                SlotSum += MidiDeviceInputProperty.MidiMessage[1] + static_cast<uint64_t>(MidiDeviceInputProperty.MidiActionType);
+            }
+        }) / PropertyCount;
+        DestroyListInputProperties(InputPropertiesHead);
+
+        if (ListSum != SlotSum)
+        {
+            std::printf("Mismatch at %u mappings, list read %llu and slot map %llu\n", PropertyCount,
+                static_cast<unsigned long long>(ListSum), static_cast<unsigned long long>(SlotSum));
+            return 1;
+        }
+        BenchmarkSink = SlotSum;
+        std::printf("%10u %14.1f %14.1f %14.2f %14.2f\n", PropertyCount, ListLoadNanoseconds, SlotLoadNanoseconds,
+            ListIterationNanoseconds, SlotIterationNanoseconds);
+    }
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,27 @@
+// SPDX-License-Identifier: GPL-2.0-only
+// Copyright © Interactive Echoes. All rights reserved.
+// Author: mozahzah
+
+#pragma once
+
+#include <filesystem>
+#include <memory>
+
+#include "IEMidiTypes.h"
+
+// Where matched input properties take effect. IEMidiSystemActionBackend drives the system through
+// IEActions, the benchmarks substitute their own to measure the midi path on its own.
+// Called from the action worker thread only.
+class IEMidiActionBackend
+{
+public:
+    virtual ~IEMidiActionBackend() = default;
+
+public:
+    virtual bool IsSupported(IEMidiActionType MidiActionType) const = 0;
+    virtual void SetVolume(float Volume) = 0;
+    virtual bool GetMute() const = 0;
+    virtual void SetMute(bool bIsMuted) = 0;
+    virtual void ExecuteConsoleCommand(const std::shared_ptr<const IEMidiCompiledCommand>& CompiledCommand, float Value) = 0;
+    virtual void OpenFile(const std::filesystem::path& OpenFilePath) = 0;
+};
\ No newline at end of file
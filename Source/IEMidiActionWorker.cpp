@@ -0,0 +1,208 @@
+// SPDX-License-Identifier: GPL-2.0-only
+// Copyright © Interactive Echoes. All rights reserved.
+// Author: mozahzah
+
+#include "IEMidiActionWorker.h"
+
+IEMidiActionWorker::~IEMidiActionWorker()
+{
+    Stop();
+}
+
+void IEMidiActionWorker::Start(std::function<void(const IEMidiInputEvent&)> EventHandler,
+    std::function<std::chrono::steady_clock::time_point(bool bIsFinal)> FlushHandler)
+{
+    Stop();
+
+    m_EventHandler = std::move(EventHandler);
+    m_FlushHandler = std::move(FlushHandler);
+    m_bStopRequested.store(false, std::memory_order_relaxed);
+    m_WorkerThread = std::thread(&IEMidiActionWorker::Run, this);
+}
+
+void IEMidiActionWorker::Stop()
+{
+    if (m_WorkerThread.joinable())
+    {
+        m_bStopRequested.store(true, std::memory_order_release);
+        Wake();
+        m_WorkerThread.join();
+    }
+
+    // Events left behind belong to the profiles being torn down
+    for (size_t QueueIndex = 0; QueueIndex < MAX_EVENT_QUEUE_COUNT; QueueIndex++)
+    {
+        if (m_EventQueues[QueueIndex])
+        {
+            DiscardQueue(*m_EventQueues[QueueIndex]);
+        }
+    }
+    m_EventHandler = nullptr;
+    m_FlushHandler = nullptr;
+}
+
+int32_t IEMidiActionWorker::OpenQueue()
+{
+    for (size_t QueueIndex = 0; QueueIndex < MAX_EVENT_QUEUE_COUNT; QueueIndex++)
+    {
+        if (!m_bIsEventQueueOpen[QueueIndex].load(std::memory_order_relaxed))
+        {
+            // Queues are kept allocated once created so reopening a slot never races the worker
+            if (!m_EventQueues[QueueIndex])
+            {
+                m_EventQueues[QueueIndex] = std::make_unique<IESPSCQueue<IEMidiInputEvent>>(m_QueueCapacity);
+            }
+            else
+            {
+                // A producer that raced CloseQueue may have left events of the previous device behind
+                DiscardQueue(*m_EventQueues[QueueIndex]);
+            }
+            m_bIsEventQueueOpen[QueueIndex].store(true, std::memory_order_release);
+            return static_cast<int32_t>(QueueIndex);
+        }
+    }
+    return -1;
+}
+
+void IEMidiActionWorker::CloseQueue(int32_t QueueIndex)
+{
+    if (QueueIndex >= 0 && QueueIndex < static_cast<int32_t>(MAX_EVENT_QUEUE_COUNT))
+    {
+        m_bIsEventQueueOpen[QueueIndex].store(false, std::memory_order_seq_cst);
+
+        // A pass that began before the queue was closed may still be draining it, wait for it to end
+        if (m_WorkerThread.joinable() && std::this_thread::get_id() != m_WorkerThread.get_id())
+        {
+            const uint64_t PassCount = m_PassCount.load(std::memory_order_seq_cst);
+            Wake();
+            m_PassCount.wait(PassCount, std::memory_order_acquire);
+        }
+
+        if (m_EventQueues[QueueIndex])
+        {
+            DiscardQueue(*m_EventQueues[QueueIndex]);
+        }
+    }
+}
+
+bool IEMidiActionWorker::Enqueue(uint32_t QueueIndex, const IEMidiInputEvent& MidiInputEvent)
+{
+    const bool bIsEventQueueOpen = QueueIndex < MAX_EVENT_QUEUE_COUNT && m_bIsEventQueueOpen[QueueIndex].load(std::memory_order_acquire);
+    IESPSCQueue<IEMidiInputEvent>* const EventQueue = bIsEventQueueOpen ? m_EventQueues[QueueIndex].get() : nullptr;
+    if (!EventQueue || EventQueue->IsFull())
+    {
+        m_DroppedCount.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    EventQueue->Push(MidiInputEvent);
+
+    const uint64_t EnqueuedCount = m_EnqueuedCount.fetch_add(1, std::memory_order_relaxed) + 1;
+    const uint64_t QueueDepth = EnqueuedCount - m_ProcessedCount.load(std::memory_order_relaxed);
+    uint64_t PeakQueueDepth = m_PeakQueueDepth.load(std::memory_order_relaxed);
+    while (QueueDepth > PeakQueueDepth &&
+        !m_PeakQueueDepth.compare_exchange_weak(PeakQueueDepth, QueueDepth, std::memory_order_relaxed))
+    {
+    }
+
+    Wake();
+    return true;
+}
+
+IEMidiActionWorkerStats IEMidiActionWorker::GetStats() const
+{
+    IEMidiActionWorkerStats Stats;
+    Stats.EnqueuedCount = m_EnqueuedCount.load(std::memory_order_relaxed);
+    Stats.ProcessedCount = m_ProcessedCount.load(std::memory_order_relaxed);
+    Stats.DroppedCount = m_DroppedCount.load(std::memory_order_relaxed);
+    Stats.PeakQueueDepth = m_PeakQueueDepth.load(std::memory_order_relaxed);
+    Stats.WakeCount = m_WakeCount.load(std::memory_order_relaxed);
+    return Stats;
+}
+
+void IEMidiActionWorker::Run()
+{
+    while (!m_bStopRequested.load(std::memory_order_acquire))
+    {
+        // Round robin in bounded batches so a flooding device cannot starve the others
+        bool bHasRemainingEvents = true;
+        while (bHasRemainingEvents && !m_bStopRequested.load(std::memory_order_acquire))
+        {
+            bHasRemainingEvents = false;
+            for (size_t QueueIndex = 0; QueueIndex < MAX_EVENT_QUEUE_COUNT; QueueIndex++)
+            {
+                if (m_bIsEventQueueOpen[QueueIndex].load(std::memory_order_seq_cst))
+                {
+                    bHasRemainingEvents |= DrainQueue(*m_EventQueues[QueueIndex]);
+                }
+            }
+            m_PassCount.fetch_add(1, std::memory_order_seq_cst);
+            m_PassCount.notify_all();
+        }
+
+        const std::chrono::steady_clock::time_point NextFlushTime = m_FlushHandler ? m_FlushHandler(false) : std::chrono::steady_clock::time_point::max();
+        bool bIsWoken = true;
+        if (NextFlushTime == std::chrono::steady_clock::time_point::max())
+        {
+            m_WakeSemaphore.acquire();
+        }
+        else
+        {
+            bIsWoken = m_WakeSemaphore.try_acquire_until(NextFlushTime);
+        }
+
+        // Events pushed from here on wake the worker again. A wake that raced the flush timeout
+        // is taken now, its release is at most a few instructions away.
+        if (m_bIsWakePending.exchange(false, std::memory_order_acq_rel) && !bIsWoken)
+        {
+            m_WakeSemaphore.acquire();
+        }
+        m_WakeCount.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    if (m_FlushHandler)
+    {
+        m_FlushHandler(true);
+    }
+
+    m_PassCount.fetch_add(1, std::memory_order_seq_cst);
+    m_PassCount.notify_all();
+}
+
+bool IEMidiActionWorker::DrainQueue(IESPSCQueue<IEMidiInputEvent>& EventQueue)
+{
+    IEMidiInputEvent MidiInputEvent;
+    for (size_t EventCount = 0; EventCount < MAX_EVENTS_PER_QUEUE_PASS; EventCount++)
+    {
+        if (m_bStopRequested.load(std::memory_order_acquire) || !EventQueue.Pop(MidiInputEvent))
+        {
+            return false;
+        }
+
+        if (m_EventHandler)
+        {
+            m_EventHandler(MidiInputEvent);
+        }
+        m_ProcessedCount.fetch_add(1, std::memory_order_relaxed);
+    }
+    return true;
+}
+
+void IEMidiActionWorker::Wake()
+{
+    if (!m_bIsWakePending.exchange(true, std::memory_order_acq_rel))
+    {
+        m_WakeSemaphore.release();
+    }
+}
+
+void IEMidiActionWorker::DiscardQueue(IESPSCQueue<IEMidiInputEvent>& EventQueue)
+{
+    while (!EventQueue.IsEmpty())
+    {
+        if (EventQueue.Pop())
+        {
+            m_DroppedCount.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+}
\ No newline at end of file
@@ -0,0 +1,101 @@
+// SPDX-License-Identifier: GPL-2.0-only
+// Copyright © Interactive Echoes. All rights reserved.
+// Author: mozahzah
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <semaphore>
+#include <thread>
+
+#include "IEConcurrency.h"
+
+#include "IEMidiTypes.h"
+
+static constexpr size_t MAX_EVENT_QUEUE_COUNT = 16;
+
+struct IEMidiInputEvent
+{
+    std::chrono::steady_clock::time_point ReceivedTime;
+    std::chrono::steady_clock::time_point EnqueuedTime;
+    double TimeStamp = 0.0;
+    IEMidiMessage MidiMessage;
+    uint32_t QueueIndex = 0;
+    bool bIsLearned = false;
+};
+
+struct IEMidiActionWorkerStats
+{
+    uint64_t EnqueuedCount = 0;
+    uint64_t ProcessedCount = 0;
+    uint64_t DroppedCount = 0;
+    uint64_t PeakQueueDepth = 0;
+    uint64_t WakeCount = 0;
+};
+
+// Executes midi input events on a dedicated thread. Every midi input thread owns one of the
+// bounded SPSC queues, is its single producer and never blocks: when its queue is full the event
+// is dropped and counted. The worker drains all open queues, so input devices share one thread.
+// The optional flush handler runs after each drain and returns when it next needs to run, and once
+// more as the worker stops, final, to apply whatever it still holds back.
+class IEMidiActionWorker
+{
+public:
+    explicit IEMidiActionWorker(size_t QueueCapacity = 1024) :
+        m_QueueCapacity(QueueCapacity)
+    {}
+    ~IEMidiActionWorker();
+    IEMidiActionWorker(const IEMidiActionWorker&) = delete;
+    IEMidiActionWorker& operator=(const IEMidiActionWorker&) = delete;
+
+public:
+    void Start(std::function<void(const IEMidiInputEvent&)> EventHandler,
+        std::function<std::chrono::steady_clock::time_point(bool bIsFinal)> FlushHandler = nullptr);
+    void Stop();
+    bool IsRunning() const { return m_WorkerThread.joinable(); }
+
+public:
+    // Called from the thread that starts and stops the worker. Closing waits until the worker
+    // no longer touches the queue, so the producer must be stopped beforehand.
+    int32_t OpenQueue();
+    void CloseQueue(int32_t QueueIndex);
+
+public:
+    // Events for a queue that is not open are dropped and counted
+    bool Enqueue(uint32_t QueueIndex, const IEMidiInputEvent& MidiInputEvent);
+    IEMidiActionWorkerStats GetStats() const;
+
+private:
+    void Run();
+    bool DrainQueue(IESPSCQueue<IEMidiInputEvent>& EventQueue);
+    void DiscardQueue(IESPSCQueue<IEMidiInputEvent>& EventQueue);
+    void Wake();
+
+private:
+    static constexpr size_t MAX_EVENTS_PER_QUEUE_PASS = 64;
+
+private:
+    const size_t m_QueueCapacity;
+    std::array<std::unique_ptr<IESPSCQueue<IEMidiInputEvent>>, MAX_EVENT_QUEUE_COUNT> m_EventQueues;
+    std::array<std::atomic<bool>, MAX_EVENT_QUEUE_COUNT> m_bIsEventQueueOpen = {};
+    // Only the first wake since the worker last looked releases the semaphore, so it never counts past one
+    std::atomic<bool> m_bIsWakePending = false;
+    std::binary_semaphore m_WakeSemaphore = std::binary_semaphore(0);
+    std::function<void(const IEMidiInputEvent&)> m_EventHandler;
+    std::function<std::chrono::steady_clock::time_point(bool bIsFinal)> m_FlushHandler;
+    std::thread m_WorkerThread;
+    std::atomic<bool> m_bStopRequested = false;
+    std::atomic<uint64_t> m_PassCount = 0;
+
+private:
+    std::atomic<uint64_t> m_EnqueuedCount = 0;
+    std::atomic<uint64_t> m_ProcessedCount = 0;
+    std::atomic<uint64_t> m_DroppedCount = 0;
+    std::atomic<uint64_t> m_PeakQueueDepth = 0;
+    std::atomic<uint64_t> m_WakeCount = 0;
+};
\ No newline at end of file
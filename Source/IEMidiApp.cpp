@@ -4,6 +4,7 @@
 
 #include "IEMidiApp.h"
 
+#include <algorithm>
 #include <string>
 
 #include "qboxlayout.h"
@@ -16,24 +17,33 @@
 #include "qmenu.h"
 #include "qobject.h"
 #include "qpushbutton.h"
+#include "qsignalblocker.h"
 #include "qsizepolicy.h"
+#include "qstandardpaths.h"
 #include "qstylefactory.h"
 #include "qsystemtrayicon.h"
 #include "qtablewidget.h"
 
 #include "IELog.h"
 
+#include "IEMidiStartupStats.h"
+
 #include "IEWidgets/IEMidiDeviceInfo.h"
 #include "IEWidgets/IEMidiDeviceInputPropertyEditor.h"
 #include "IEWidgets/IEMidiLogger.h"
 #include "IEWidgets/IEMidiDeviceOutputPropertyEditor.h"
 
+static constexpr char IEMIDI_CAPTURES_FOLDER_NAME[] = "captures";
+
 IEMidiApp::IEMidiApp(int& Argc, char** Argv) :
     QApplication(Argc, Argv),
     m_MidiProcessor(std::make_unique<IEMidiProcessor>()),
-    m_MidiProfileManager(std::make_unique<IEMidiProfileManager>())
+    m_MidiProfileManager(std::make_unique<IEMidiProfileManager>()),
+    m_MidiFrameNotifier(std::make_unique<IEMidiFrameNotifier>()),
+    m_MidiLearnDispatcher(std::make_unique<IEMidiLearnDispatcher>(*m_MidiProcessor))
 {
-    m_OnMidiCallbackID = m_MidiProcessor->AddOnMidiCallback(this, &IEMidiApp::OnMidiCallback);
+    connect(m_MidiFrameNotifier.get(), &IEMidiFrameNotifier::OnFrame, this, [this]() { OnMidiFrame(); });
+    m_OnMidiCallbackID = m_MidiProcessor->AddOnMidiCallback<&IEMidiApp::OnMidiCallback>(this);
 
     const std::string TestFlag = std::string("test");
     for (int i = 0; i < Argc; i++)
@@ -83,7 +93,24 @@ IEMidiApp::IEMidiApp(int& Argc, char** Argv) :
     SetupMainWindow();
     SetupTrayIcon();
 
+    m_MidiProfileManager->SetOnProfilesSavedCallback([this](const IEResult& Result)
+        {
+            QMetaObject::invokeMethod(this, [this, Result]() { OnProfilesSaved(Result); });
+        });
+
+    m_MidiProfileWatcher = new IEMidiProfileWatcher(*m_MidiProcessor, *m_MidiProfileManager, this);
+    connect(m_MidiProfileWatcher, &IEMidiProfileWatcher::OnMidiDeviceProfileReloaded, this, [this](const QString& MidiDeviceName)
+        {
+            const bool bIsFocused = m_MidiProcessor->HasActiveMidiDeviceProfile() &&
+                m_MidiProcessor->GetActiveMidiDeviceProfile().NameID == MidiDeviceName.toStdString();
+            if (bIsFocused && m_MainWindow && m_MainWindow->isVisible() && m_MidiLogger)
+            {
+                DrawActiveMidiDeviceEditor();
+            }
+        });
+
     DrawMidiDeviceSelection();
+    IEMidiStartupStats::Log("IEMidi", m_MidiProcessor->GetActiveMidiDeviceNames().size());
 }
 
 IEMidiApp::~IEMidiApp()
@@ -92,6 +119,12 @@ IEMidiApp::~IEMidiApp()
     {
         m_MidiProcessor->RemoveOnMidiCallback(m_OnMidiCallbackID);
     }
+
+    if (m_MidiProfileManager)
+    {
+        m_MidiProfileManager->SetOnProfilesSavedCallback(nullptr);
+        m_MidiProfileManager->FlushPendingSaves();
+    }
 }
 
 void IEMidiApp::SetupMainWindow()
@@ -258,6 +291,34 @@ void IEMidiApp::DrawActiveMidiDeviceSideBar(QWidget* Parent)
             m_MidiLogger = new IEMidiLogger(m_MidiProcessor->GetMidiLogMessagesBuffer(), SideBarFrame);
             SideBarLayout->addWidget(m_MidiLogger, 3);
             m_MidiLogger->setObjectName("MidiLogger");
+
+            QPushButton* const MidiCaptureButton = new QPushButton("Capture to File", SideBarFrame);
+            MidiCaptureButton->setCheckable(true);
+            MidiCaptureButton->setChecked(m_MidiProcessor->IsMidiCaptureRunning());
+            SideBarLayout->addWidget(MidiCaptureButton);
+            MidiCaptureButton->connect(MidiCaptureButton, &QPushButton::toggled, [this, MidiCaptureButton](bool bToggled)
+                {
+                    if (!bToggled)
+                    {
+                        m_MidiProcessor->StopMidiCapture();
+                        return;
+                    }
+
+                    IEMidiCaptureConfig CaptureConfig;
+                    const std::filesystem::path IEMidiConfigFolderPath = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation).toStdString();
+                    CaptureConfig.FolderPath = IEMidiConfigFolderPath / IEMIDI_CAPTURES_FOLDER_NAME;
+                    const IEResult Result = m_MidiProcessor->StartMidiCapture(CaptureConfig);
+                    if (Result)
+                    {
+                        IELOG_SUCCESS("%s", Result.Message.c_str());
+                    }
+                    else
+                    {
+                        IELOG_ERROR("%s", Result.Message.c_str());
+                        const QSignalBlocker SignalBlocker(MidiCaptureButton);
+                        MidiCaptureButton->setChecked(false);
+                    }
+                });
         }
     }
 }
@@ -331,17 +392,15 @@ void IEMidiApp::DrawActiveMidiDeviceInputEditor(QWidget* Parent)
         // Input For Loop
         if (m_MidiProcessor && m_MidiProcessor->HasActiveMidiDeviceProfile())
         {
-            IEMidiDeviceInputProperty* MidiDeviceInputProperty = m_MidiProcessor->GetActiveMidiDeviceProfile().InputPropertiesHead.get();
-            while (MidiDeviceInputProperty)
+            for (IEMidiDeviceInputProperty& MidiDeviceInputProperty : m_MidiProcessor->GetActiveMidiDeviceProfile().InputProperties)
             {
-                IEMidiDeviceInputPropertyEditor* const MidiDeviceInputPropertyEditor = new IEMidiDeviceInputPropertyEditor(*MidiDeviceInputProperty, MidiInputEditorFrame);
+                IEMidiDeviceInputPropertyEditor* const MidiDeviceInputPropertyEditor = new IEMidiDeviceInputPropertyEditor(MidiDeviceInputProperty, MidiInputEditorFrame);
                 MidiInputEditorLayout->addWidget(MidiDeviceInputPropertyEditor);
-                MidiDeviceInputPropertyEditor->connect(MidiDeviceInputPropertyEditor, &IEMidiDeviceInputPropertyEditor::OnRecording, [this, MidiDeviceInputPropertyEditor]()
+                MidiDeviceInputPropertyEditor->connect(m_MidiLearnDispatcher.get(), &IEMidiLearnDispatcher::OnMidiMessageLearned, MidiDeviceInputPropertyEditor, &IEMidiDeviceInputPropertyEditor::OnMidiMessageLearned);
+                MidiDeviceInputPropertyEditor->connect(MidiDeviceInputPropertyEditor, &IEMidiDeviceInputPropertyEditor::OnPropertyChanged, [this]()
                 {
-                    m_MidiListeningWidgets.Push(MidiDeviceInputPropertyEditor);
+                    m_MidiProcessor->CompileActiveMidiDeviceProfile();
                 });
-                
-                MidiDeviceInputProperty = MidiDeviceInputProperty->Next();
             }
         }
         // End For loop
@@ -360,10 +419,12 @@ void IEMidiApp::DrawActiveMidiDeviceInputEditor(QWidget* Parent)
 
                     IEMidiDeviceInputPropertyEditor* const MidiDeviceInputPropertyEditor = new IEMidiDeviceInputPropertyEditor(NewMidiDeviceInputProperty, MidiInputEditorFrame);
                     MidiInputEditorLayout->insertWidget(MidiInputEditorLayout->count() - 3, MidiDeviceInputPropertyEditor);
-                    MidiDeviceInputPropertyEditor->connect(MidiDeviceInputPropertyEditor, &IEMidiDeviceInputPropertyEditor::OnRecording, [this, MidiDeviceInputPropertyEditor]()
+                    MidiDeviceInputPropertyEditor->connect(m_MidiLearnDispatcher.get(), &IEMidiLearnDispatcher::OnMidiMessageLearned, MidiDeviceInputPropertyEditor, &IEMidiDeviceInputPropertyEditor::OnMidiMessageLearned);
+                    MidiDeviceInputPropertyEditor->connect(MidiDeviceInputPropertyEditor, &IEMidiDeviceInputPropertyEditor::OnPropertyChanged, [this]()
                     {
-                        m_MidiListeningWidgets.Push(MidiDeviceInputPropertyEditor);
+                        m_MidiProcessor->CompileActiveMidiDeviceProfile();
                     });
+                    m_MidiProcessor->CompileActiveMidiDeviceProfile();
                 }
             });
         
@@ -391,21 +452,18 @@ void IEMidiApp::DrawActiveMidiDeviceOutputEditor(QWidget* Parent) const
         // Output for loop
         if (m_MidiProcessor && m_MidiProcessor->HasActiveMidiDeviceProfile())
         {
-            IEMidiDeviceOutputProperty* MidiDeviceOutputProperty = m_MidiProcessor->GetActiveMidiDeviceProfile().OutputPropertiesHead.get();
-            while (MidiDeviceOutputProperty)
+            for (IEMidiDeviceOutputProperty& MidiDeviceOutputProperty : m_MidiProcessor->GetActiveMidiDeviceProfile().OutputProperties)
             {
-                IEMidiDeviceOutputPropertyEditor* const MidiDeviceOutputPropertyEditor = new IEMidiDeviceOutputPropertyEditor(*MidiDeviceOutputProperty, MidiOutputEditorFrame);
+                IEMidiDeviceOutputPropertyEditor* const MidiDeviceOutputPropertyEditor = new IEMidiDeviceOutputPropertyEditor(MidiDeviceOutputProperty, MidiOutputEditorFrame);
                 MidiOutputEditorLayout->addWidget(MidiDeviceOutputPropertyEditor);
                 MidiDeviceOutputPropertyEditor->connect(MidiDeviceOutputPropertyEditor, &IEMidiDeviceOutputPropertyEditor::OnSendMidiButtonPressed,
-                    [this](const std::array<uint8_t, MIDI_MESSAGE_BYTE_COUNT>& MidiMessage)
+                    [this](const IEMidiMessage& MidiMessage)
                     {
                         if (m_MidiProcessor && m_MidiProcessor->HasActiveMidiDeviceProfile())
                         {
                             m_MidiProcessor->SendMidiOutputMessage(MidiMessage);
                         }
                     });
-                
-                MidiDeviceOutputProperty = MidiDeviceOutputProperty->Next();
             }
         }
         // End For loop
@@ -424,7 +482,7 @@ void IEMidiApp::DrawActiveMidiDeviceOutputEditor(QWidget* Parent) const
                     IEMidiDeviceOutputPropertyEditor* const MidiDeviceOutputPropertyEditor = new IEMidiDeviceOutputPropertyEditor(NewMidiDeviceOutputProperty, MidiOutputEditorFrame);
                     MidiOutputEditorLayout->insertWidget(MidiOutputEditorLayout->count() - 3, MidiDeviceOutputPropertyEditor);
                     MidiDeviceOutputPropertyEditor->connect(MidiDeviceOutputPropertyEditor, &IEMidiDeviceOutputPropertyEditor::OnSendMidiButtonPressed,
-                    [this](const std::array<uint8_t, MIDI_MESSAGE_BYTE_COUNT>& MidiMessage)
+                    [this](const IEMidiMessage& MidiMessage)
                     {
                         if (m_MidiProcessor && m_MidiProcessor->HasActiveMidiDeviceProfile())
                         {
@@ -450,18 +508,11 @@ void IEMidiApp::RunInBackground()
         );
     }
 
-    while (!m_MidiListeningWidgets.IsEmpty())
-    {
-        m_MidiListeningWidgets.Pop();
-    }
-
     if (m_MidiProcessor && m_MidiProcessor->HasActiveMidiDeviceProfile())
     {
-        IEMidiDeviceInputProperty* MidiDeviceInputProperty = m_MidiProcessor->GetActiveMidiDeviceProfile().InputPropertiesHead.get();
-        while (MidiDeviceInputProperty)
+        for (IEMidiDeviceInputProperty& MidiDeviceInputProperty : m_MidiProcessor->GetActiveMidiDeviceProfile().InputProperties)
         {
-            MidiDeviceInputProperty->bIsRecording = false;
-            MidiDeviceInputProperty = MidiDeviceInputProperty->Next();
+            MidiDeviceInputProperty.SetRecording(false);
         }
     }
 
@@ -470,15 +521,25 @@ void IEMidiApp::RunInBackground()
 
 void IEMidiApp::ActivateMidiDeviceProfile(const std::string& MidiDeviceName) const
 {
-    if (m_MidiProcessor && m_MidiProfileManager && m_MidiProcessor->ActivateMidiDeviceProfile(MidiDeviceName))
+    if (m_MidiProcessor && m_MidiProfileManager)
     {
-        IEMidiDeviceProfile& ActiveMidiDeviceProfile = m_MidiProcessor->GetActiveMidiDeviceProfile();
-        m_MidiProfileManager->LoadProfile(ActiveMidiDeviceProfile);
-        IEMidiDeviceOutputProperty* MidiDeviceOutputProperty = m_MidiProcessor->GetActiveMidiDeviceProfile().OutputPropertiesHead.get();
-        while (MidiDeviceOutputProperty)
+        // Other devices stay active, an already active device is only brought into focus
+        const std::vector<std::string> ActiveMidiDeviceNames = m_MidiProcessor->GetActiveMidiDeviceNames();
+        const bool bIsAlreadyActive = std::find(ActiveMidiDeviceNames.begin(), ActiveMidiDeviceNames.end(), MidiDeviceName) != ActiveMidiDeviceNames.end();
+        if (m_MidiProcessor->ActivateMidiDeviceProfile(MidiDeviceName) && !bIsAlreadyActive)
         {
-            m_MidiProcessor->SendMidiOutputMessage(MidiDeviceOutputProperty->MidiMessage);
-            MidiDeviceOutputProperty = MidiDeviceOutputProperty->Next();
+            IEMidiDeviceProfile& ActiveMidiDeviceProfile = m_MidiProcessor->GetActiveMidiDeviceProfile();
+            m_MidiProfileManager->LoadProfile(ActiveMidiDeviceProfile);
+            m_MidiProcessor->CompileActiveMidiDeviceProfile();
+            for (const IEMidiDeviceOutputProperty& MidiDeviceOutputProperty : m_MidiProcessor->GetActiveMidiDeviceProfile().OutputProperties)
+            {
+                m_MidiProcessor->SendMidiOutputMessage(MidiDeviceOutputProperty.MidiMessage);
+            }
+
+            if (m_MidiProfileWatcher)
+            {
+                m_MidiProfileWatcher->WatchActiveMidiDeviceProfiles();
+            }
         }
     }
 }
@@ -487,52 +548,56 @@ void IEMidiApp::SaveActiveMidiDeviceProfile() const
 {
     if (m_MidiProcessor && m_MidiProfileManager && m_MidiProcessor->HasActiveMidiDeviceProfile())
     {
-        if (m_MidiProfileManager->SaveProfile(m_MidiProcessor->GetActiveMidiDeviceProfile()))
+        // Success is reported by OnProfilesSaved once the profile is on disk
+        const IEResult Result = m_MidiProfileManager->SaveProfile(m_MidiProcessor->GetActiveMidiDeviceProfile());
+        if (!Result)
         {
-            if (m_SystemTrayIcon)
-            {
-                m_SystemTrayIcon->showMessage(
-                    "IEMidi",                  
-                    "Successfully saved profile",
-                    QSystemTrayIcon::MessageIcon::NoIcon,
-                    2000
-                );
-            }
-        }
-        else
-        {
-            if (m_SystemTrayIcon)
-            {
-                m_SystemTrayIcon->showMessage(
-                    "IEMidi",                  
-                    "Failed to save profile",
-                    QSystemTrayIcon::MessageIcon::Critical,
-                    5000
-                );
-            }
+            OnProfilesSaved(Result);
         }
     }
 }
 
-void IEMidiApp::OnMidiCallback(double Timestamp, const std::array<uint8_t, MIDI_MESSAGE_BYTE_COUNT> MidiMessage)
+void IEMidiApp::OnProfilesSaved(const IEResult& Result) const
 {
-    QMetaObject::invokeMethod(this, [this]()
+    if (Result)
+    {
+        IELOG_SUCCESS("%s", Result.Message.c_str());
+        if (m_SystemTrayIcon)
         {
-            while (!m_MidiListeningWidgets.IsEmpty())
-            {
-                std::optional<QPointer<QWidget>> MidiDependentWidget = m_MidiListeningWidgets.Pop();
-                if (MidiDependentWidget.has_value())
-                {
-                    if (const QPointer<QWidget> MidiDependentWidgetPtr = MidiDependentWidget.value())
-                    {
-                        MidiDependentWidgetPtr->repaint();
-                    }
-                }
-            }
+            m_SystemTrayIcon->showMessage(
+                "IEMidi",                  
+                "Successfully saved profile",
+                QSystemTrayIcon::MessageIcon::NoIcon,
+                2000
+            );
+        }
+    }
+    else
+    {
+        IELOG_ERROR("%s", Result.Message.c_str());
+        if (m_SystemTrayIcon)
+        {
+            m_SystemTrayIcon->showMessage(
+                "IEMidi",                  
+                "Failed to save profile",
+                QSystemTrayIcon::MessageIcon::Critical,
+                5000
+            );
+        }
+    }
+}
 
-            if (m_MidiLogger)
-            {
-                m_MidiLogger->repaint();
-            }
-        }, Qt::QueuedConnection);
+void IEMidiApp::OnMidiCallback(double Timestamp, const IEMidiMessage& MidiMessage)
+{
+    m_MidiFrameNotifier->Notify();
 }
+
+void IEMidiApp::OnMidiFrame()
+{
+    m_MidiLearnDispatcher->DispatchMidiLearnEvents();
+
+    if (m_MidiLogger)
+    {
+        m_MidiLogger->update();
+    }
+}
\ No newline at end of file
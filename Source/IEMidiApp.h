@@ -8,8 +8,11 @@
 #include "qpointer.h"
 #include "IEConcurrency.h"
 
+#include "IEMidiFrameNotifier.h"
+#include "IEMidiLearnDispatcher.h"
 #include "IEMidiProcessor.h"
 #include "IEMidiProfileManager.h"
+#include "IEMidiProfileWatcher.h"
 #include "IEMidiTypes.h"
 
 class IEMidiLogger;
@@ -39,10 +42,13 @@ private:
 private:
     void ActivateMidiDeviceProfile(const std::string& MidiDeviceName) const;
     void SaveActiveMidiDeviceProfile() const;
+    void OnProfilesSaved(const IEResult& Result) const;
     void RunInBackground();
 
 private:
-    void OnMidiCallback(double Timestamp, const std::array<uint8_t, MIDI_MESSAGE_BYTE_COUNT> MidiMessage);
+    // Runs on the action worker thread, learned messages and the logger are picked up by OnMidiFrame
+    void OnMidiCallback(double Timestamp, const IEMidiMessage& MidiMessage);
+    void OnMidiFrame();
 
 private:
     QPointer<QMainWindow> m_MainWindow;
@@ -51,9 +57,11 @@ private:
 private:
     const std::unique_ptr<IEMidiProcessor> m_MidiProcessor;
     const std::unique_ptr<IEMidiProfileManager> m_MidiProfileManager;
+    QPointer<IEMidiProfileWatcher> m_MidiProfileWatcher;
+    const std::unique_ptr<IEMidiFrameNotifier> m_MidiFrameNotifier;
+    const std::unique_ptr<IEMidiLearnDispatcher> m_MidiLearnDispatcher;
     
 private:
-    IESPSCQueue<QPointer<QWidget>> m_MidiListeningWidgets = IESPSCQueue<QPointer<QWidget>>(6);
     QPointer<IEMidiLogger> m_MidiLogger;
     uint32_t m_OnMidiCallbackID = 0;
 
@@ -0,0 +1,525 @@
+// SPDX-License-Identifier: GPL-2.0-only
+// Copyright © Interactive Echoes. All rights reserved.
+// Author: mozahzah
+
+#include "IEMidiCaptureWriter.h"
+
+#include <algorithm>
+#include <cstring>
+#include <ctime>
+
+// One quarter note per second at 10000 ticks per quarter note, so a tick is 100 us
+using IEMidiCaptureTicks = std::chrono::duration<int64_t, std::ratio<1, 10000>>;
+static constexpr uint16_t MIDI_CAPTURE_TICKS_PER_QUARTER_NOTE = 10000;
+static constexpr uint32_t MIDI_CAPTURE_TEMPO_MICROSECONDS = 1000000;
+static constexpr uint32_t MAX_VARIABLE_LENGTH_VALUE = 0x0FFFFFFF;
+static constexpr uint64_t MIN_MIDI_CAPTURE_FILE_SIZE = 4096;
+static constexpr size_t FILE_HEADER_BYTE_COUNT = 22;
+static constexpr long TRACK_LENGTH_OFFSET = 18;
+static constexpr std::array<uint8_t, 4> END_OF_TRACK = {0x00, 0xFF, 0x2F, 0x00};
+static constexpr char MIDI_CAPTURE_TRACK_NAME[] = "IEMidi Capture";
+
+IEMidiCaptureWriter::~IEMidiCaptureWriter()
+{
+    Stop();
+}
+
+IEResult IEMidiCaptureWriter::Start(const IEMidiCaptureConfig& Config)
+{
+    IEResult Result(IEResult::Type::Fail);
+    Result.Message = std::format("Failed to start midi capture in {}", Config.FolderPath.string());
+
+    Stop();
+
+    std::error_code ErrorCode;
+    if (Config.FolderPath.empty() || (!std::filesystem::create_directories(Config.FolderPath, ErrorCode) &&
+        !std::filesystem::is_directory(Config.FolderPath, ErrorCode)))
+    {
+        return Result;
+    }
+
+    m_Config = Config;
+    m_Config.MaxFileSize = std::max(Config.MaxFileSize, MIN_MIDI_CAPTURE_FILE_SIZE);
+
+    const std::time_t CurrentTime = std::time(nullptr);
+    std::array<char, 32> TimeString = {};
+    if (const std::tm* const LocalTime = std::localtime(&CurrentTime))
+    {
+        std::strftime(TimeString.data(), TimeString.size(), "%Y%m%d-%H%M%S", LocalTime);
+    }
+    m_CaptureName = std::format("IEMidiCapture-{}", TimeString.data());
+    m_FilePaths.clear();
+    m_FileIndex = 0;
+    m_bHasFailed = false;
+
+    m_CapturedCount.store(0, std::memory_order_relaxed);
+    m_WrittenCount.store(0, std::memory_order_relaxed);
+    m_DroppedCount.store(0, std::memory_order_relaxed);
+    m_TruncatedCount.store(0, std::memory_order_relaxed);
+    m_PeakQueueDepth.store(0, std::memory_order_relaxed);
+    m_WrittenByteCount.store(0, std::memory_order_relaxed);
+    m_FileCount.store(0, std::memory_order_relaxed);
+    m_ConsumedCount.store(0, std::memory_order_relaxed);
+
+    for (uint32_t QueueIndex = 0; QueueIndex < MAX_EVENT_QUEUE_COUNT; QueueIndex++)
+    {
+        if (m_bIsQueueOpen[QueueIndex])
+        {
+            AllocateQueue(QueueIndex);
+        }
+    }
+    DiscardQueues();
+
+    // The first file is opened here so a bad folder is reported to the caller
+    if (!OpenFile(std::chrono::steady_clock::now()))
+    {
+        return Result;
+    }
+
+    while (m_StopSemaphore.try_acquire())
+    {
+    }
+    m_bStopRequested.store(false, std::memory_order_relaxed);
+    m_bIsCapturing.store(true, std::memory_order_release);
+    m_WriterThread = std::thread(&IEMidiCaptureWriter::Run, this);
+
+    Result.Type = IEResult::Type::Success;
+    Result.Message = std::format("Capturing midi to {}", m_FilePaths.back().string());
+    return Result;
+}
+
+void IEMidiCaptureWriter::Stop()
+{
+    if (m_WriterThread.joinable())
+    {
+        m_bIsCapturing.store(false, std::memory_order_release);
+        m_bStopRequested.store(true, std::memory_order_release);
+        m_StopSemaphore.release();
+        m_WriterThread.join();
+    }
+}
+
+void IEMidiCaptureWriter::OpenQueue(uint32_t QueueIndex, const std::string& MidiDeviceName)
+{
+    if (QueueIndex < MAX_EVENT_QUEUE_COUNT)
+    {
+        {
+            const std::lock_guard<std::mutex> Lock(m_MidiDeviceNamesMutex);
+            m_MidiDeviceNames[QueueIndex] = MidiDeviceName;
+        }
+        m_MidiDeviceGenerations[QueueIndex].fetch_add(1, std::memory_order_release);
+        m_bIsQueueOpen[QueueIndex] = true;
+
+        // Devices never captured from do not pay for a queue
+        if (IsRunning())
+        {
+            AllocateQueue(QueueIndex);
+        }
+    }
+}
+
+void IEMidiCaptureWriter::CloseQueue(uint32_t QueueIndex)
+{
+    // Whatever the device queued before closing is still written under its name
+    if (QueueIndex < MAX_EVENT_QUEUE_COUNT)
+    {
+        m_bIsQueueOpen[QueueIndex] = false;
+    }
+}
+
+bool IEMidiCaptureWriter::Enqueue(uint32_t QueueIndex, std::chrono::steady_clock::time_point ReceivedTime, const IEMidiMessage& MidiMessage)
+{
+    if (!m_bIsCapturing.load(std::memory_order_acquire))
+    {
+        return false;
+    }
+
+    IEMidiCaptureQueue* const CaptureQueue = QueueIndex < MAX_EVENT_QUEUE_COUNT ?
+        m_CaptureQueues[QueueIndex].load(std::memory_order_acquire) : nullptr;
+    if (!CaptureQueue || CaptureQueue->CaptureEvents.IsFull())
+    {
+        m_DroppedCount.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    IEMidiCaptureEvent CaptureEvent;
+    CaptureEvent.ReceivedTime = ReceivedTime;
+    CaptureEvent.Size = static_cast<uint16_t>(MidiMessage.size());
+    CaptureEvent.bIsTruncated = MidiMessage.IsTruncated();
+    CaptureEvent.QueueIndex = QueueIndex;
+    std::copy_n(MidiMessage.data(), std::min(MidiMessage.size(), MIDI_MESSAGE_BYTE_COUNT), CaptureEvent.Bytes.begin());
+
+    if (CaptureEvent.Size > MIDI_MESSAGE_BYTE_COUNT)
+    {
+        const uint64_t SysExWriteOffset = CaptureQueue->SysExWriteOffset.load(std::memory_order_relaxed);
+        if (SysExWriteOffset + CaptureEvent.Size - CaptureQueue->SysExReadOffset.load(std::memory_order_acquire) > MIDI_CAPTURE_SYSEX_BYTE_COUNT)
+        {
+            m_DroppedCount.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        const size_t RingOffset = SysExWriteOffset % MIDI_CAPTURE_SYSEX_BYTE_COUNT;
+        const size_t FirstByteCount = std::min<size_t>(CaptureEvent.Size, MIDI_CAPTURE_SYSEX_BYTE_COUNT - RingOffset);
+        std::memcpy(CaptureQueue->SysExBytes.data() + RingOffset, MidiMessage.data(), FirstByteCount);
+        std::memcpy(CaptureQueue->SysExBytes.data(), MidiMessage.data() + FirstByteCount, CaptureEvent.Size - FirstByteCount);
+        CaptureEvent.SysExOffset = SysExWriteOffset;
+        CaptureQueue->SysExWriteOffset.store(SysExWriteOffset + CaptureEvent.Size, std::memory_order_release);
+    }
+
+    CaptureQueue->CaptureEvents.Push(CaptureEvent);
+
+    const uint64_t CapturedCount = m_CapturedCount.fetch_add(1, std::memory_order_relaxed) + 1;
+    const uint64_t QueueDepth = CapturedCount - m_ConsumedCount.load(std::memory_order_relaxed);
+    uint64_t PeakQueueDepth = m_PeakQueueDepth.load(std::memory_order_relaxed);
+    while (QueueDepth > PeakQueueDepth &&
+        !m_PeakQueueDepth.compare_exchange_weak(PeakQueueDepth, QueueDepth, std::memory_order_relaxed))
+    {
+    }
+    return true;
+}
+
+IEMidiCaptureStats IEMidiCaptureWriter::GetStats() const
+{
+    IEMidiCaptureStats Stats;
+    Stats.CapturedCount = m_CapturedCount.load(std::memory_order_relaxed);
+    Stats.WrittenCount = m_WrittenCount.load(std::memory_order_relaxed);
+    Stats.DroppedCount = m_DroppedCount.load(std::memory_order_relaxed);
+    Stats.TruncatedCount = m_TruncatedCount.load(std::memory_order_relaxed);
+    Stats.PeakQueueDepth = m_PeakQueueDepth.load(std::memory_order_relaxed);
+    Stats.WrittenByteCount = m_WrittenByteCount.load(std::memory_order_relaxed);
+    Stats.FileCount = m_FileCount.load(std::memory_order_relaxed);
+    return Stats;
+}
+
+void IEMidiCaptureWriter::AllocateQueue(uint32_t QueueIndex)
+{
+    if (!m_OwnedCaptureQueues[QueueIndex])
+    {
+        m_OwnedCaptureQueues[QueueIndex] = std::make_unique<IEMidiCaptureQueue>();
+        m_CaptureQueues[QueueIndex].store(m_OwnedCaptureQueues[QueueIndex].get(), std::memory_order_release);
+    }
+}
+
+void IEMidiCaptureWriter::Run()
+{
+    m_NextCheckpointTime = std::chrono::steady_clock::now() + CHECKPOINT_INTERVAL;
+
+    bool bIsStopping = false;
+    while (!bIsStopping)
+    {
+        // The pass after the stop request picks up what was queued before capturing was switched off
+        bIsStopping = m_bStopRequested.load(std::memory_order_acquire);
+
+        bool bHasRemainingEvents = true;
+        while (bHasRemainingEvents)
+        {
+            bHasRemainingEvents = DrainQueues();
+            if (m_WriteBuffer.size() >= WRITE_BUFFER_BYTE_COUNT || std::chrono::steady_clock::now() >= m_NextCheckpointTime)
+            {
+                Checkpoint();
+            }
+        }
+
+        if (!bIsStopping)
+        {
+            m_StopSemaphore.try_acquire_for(DRAIN_INTERVAL);
+        }
+    }
+
+    CloseFile();
+}
+
+bool IEMidiCaptureWriter::DrainQueues()
+{
+    bool bHasRemainingEvents = false;
+    size_t SourceQueueCount = 0;
+    for (uint32_t QueueIndex = 0; QueueIndex < MAX_EVENT_QUEUE_COUNT; QueueIndex++)
+    {
+        if (IEMidiCaptureQueue* const CaptureQueue = m_CaptureQueues[QueueIndex].load(std::memory_order_acquire))
+        {
+            size_t EventCount = 0;
+            IEMidiCaptureEvent CaptureEvent;
+            while (EventCount < MAX_EVENTS_PER_QUEUE_PASS && CaptureQueue->CaptureEvents.Pop(CaptureEvent))
+            {
+                // The bytes are copied out and their room handed back before the batch is written
+                if (CaptureEvent.Size > MIDI_MESSAGE_BYTE_COUNT)
+                {
+                    const size_t RingOffset = CaptureEvent.SysExOffset % MIDI_CAPTURE_SYSEX_BYTE_COUNT;
+                    const size_t FirstByteCount = std::min<size_t>(CaptureEvent.Size, MIDI_CAPTURE_SYSEX_BYTE_COUNT - RingOffset);
+                    const uint8_t* const SysExBytes = CaptureQueue->SysExBytes.data();
+                    const uint64_t SysExReadOffset = CaptureEvent.SysExOffset + CaptureEvent.Size;
+                    CaptureEvent.SysExOffset = m_PendingSysExBytes.size();
+                    m_PendingSysExBytes.insert(m_PendingSysExBytes.end(), SysExBytes + RingOffset, SysExBytes + RingOffset + FirstByteCount);
+                    m_PendingSysExBytes.insert(m_PendingSysExBytes.end(), SysExBytes, SysExBytes + CaptureEvent.Size - FirstByteCount);
+                    CaptureQueue->SysExReadOffset.store(SysExReadOffset, std::memory_order_release);
+                }
+                m_PendingCaptureEvents.push_back(CaptureEvent);
+                EventCount++;
+            }
+            bHasRemainingEvents |= EventCount == MAX_EVENTS_PER_QUEUE_PASS;
+            SourceQueueCount += EventCount > 0;
+        }
+    }
+
+    // Each queue is already in order, devices are interleaved by when their messages arrived
+    if (SourceQueueCount > 1)
+    {
+        std::stable_sort(m_PendingCaptureEvents.begin(), m_PendingCaptureEvents.end(),
+            [](const IEMidiCaptureEvent& A, const IEMidiCaptureEvent& B) { return A.ReceivedTime < B.ReceivedTime; });
+    }
+
+    for (const IEMidiCaptureEvent& CaptureEvent : m_PendingCaptureEvents)
+    {
+        WriteCaptureEvent(CaptureEvent);
+    }
+    m_ConsumedCount.fetch_add(m_PendingCaptureEvents.size(), std::memory_order_relaxed);
+
+    m_PendingCaptureEvents.clear();
+    m_PendingSysExBytes.clear();
+    return bHasRemainingEvents;
+}
+
+void IEMidiCaptureWriter::DiscardQueues()
+{
+    for (IEMidiCaptureQueue* const CaptureQueue : m_CaptureQueues)
+    {
+        if (CaptureQueue)
+        {
+            while (!CaptureQueue->CaptureEvents.IsEmpty())
+            {
+                CaptureQueue->CaptureEvents.Pop();
+            }
+            CaptureQueue->SysExReadOffset.store(CaptureQueue->SysExWriteOffset.load(std::memory_order_acquire), std::memory_order_release);
+        }
+    }
+}
+
+void IEMidiCaptureWriter::WriteCaptureEvent(const IEMidiCaptureEvent& CaptureEvent)
+{
+    if (CaptureEvent.Size == 0)
+    {
+        return;
+    }
+
+    if (m_File && FILE_HEADER_BYTE_COUNT + m_TrackByteCount + m_WriteBuffer.size() + END_OF_TRACK.size() >= m_Config.MaxFileSize)
+    {
+        CloseFile();
+    }
+
+    if (m_bHasFailed || (!m_File && !OpenFile(CaptureEvent.ReceivedTime)))
+    {
+        m_DroppedCount.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    // The clock only advances by whole ticks so rounding never accumulates into drift
+    uint32_t DeltaTicks = 0;
+    if (CaptureEvent.ReceivedTime > m_LastEventTime)
+    {
+        const int64_t ElapsedTicks = std::chrono::duration_cast<IEMidiCaptureTicks>(CaptureEvent.ReceivedTime - m_LastEventTime).count();
+        DeltaTicks = static_cast<uint32_t>(std::min<int64_t>(ElapsedTicks, MAX_VARIABLE_LENGTH_VALUE));
+        m_LastEventTime += std::chrono::duration_cast<std::chrono::steady_clock::duration>(IEMidiCaptureTicks(DeltaTicks));
+    }
+
+    WriteDeviceMetaEvents(CaptureEvent.QueueIndex, DeltaTicks);
+    WriteVariableLength(m_WriteBuffer, DeltaTicks);
+
+    const uint8_t* const Data = CaptureEvent.Size > MIDI_MESSAGE_BYTE_COUNT ?
+        m_PendingSysExBytes.data() + CaptureEvent.SysExOffset : CaptureEvent.Bytes.data();
+    const size_t Size = CaptureEvent.Size;
+    const uint8_t Status = Data[0];
+    if (Status >= 0x80 && Status < 0xF0 && Size == IEMidiMessage::GetExpectedSize(Status))
+    {
+        // Running status keeps a CC flood at three bytes per message including the delta
+        if (Status != m_RunningStatus)
+        {
+            m_WriteBuffer.push_back(Status);
+            m_RunningStatus = Status;
+        }
+        m_WriteBuffer.insert(m_WriteBuffer.end(), Data + 1, Data + Size);
+    }
+    else if (Status == 0xF0)
+    {
+        // A truncated SysEx lost its F7, without one readers would wait for a continuation packet
+        const bool bIsUnterminated = CaptureEvent.bIsTruncated && Data[Size - 1] != 0xF7;
+        m_WriteBuffer.push_back(0xF0);
+        WriteVariableLength(m_WriteBuffer, static_cast<uint32_t>(Size - 1 + bIsUnterminated));
+        m_WriteBuffer.insert(m_WriteBuffer.end(), Data + 1, Data + Size);
+        if (bIsUnterminated)
+        {
+            m_WriteBuffer.push_back(0xF7);
+        }
+        m_RunningStatus = 0;
+    }
+    else
+    {
+        // System common, realtime and malformed messages have no event of their own, an escape keeps their bytes
+        m_WriteBuffer.push_back(0xF7);
+        WriteVariableLength(m_WriteBuffer, static_cast<uint32_t>(Size));
+        m_WriteBuffer.insert(m_WriteBuffer.end(), Data, Data + Size);
+        m_RunningStatus = 0;
+    }
+    if (CaptureEvent.bIsTruncated)
+    {
+        m_TruncatedCount.fetch_add(1, std::memory_order_relaxed);
+    }
+    m_WrittenCount.fetch_add(1, std::memory_order_relaxed);
+}
+
+void IEMidiCaptureWriter::WriteDeviceMetaEvents(uint32_t QueueIndex, uint32_t& DeltaTicks)
+{
+    const uint32_t MidiDeviceGeneration = m_MidiDeviceGenerations[QueueIndex].load(std::memory_order_acquire);
+    const bool bIsNewMidiDevice = MidiDeviceGeneration != m_WrittenMidiDeviceGenerations[QueueIndex];
+    if (!bIsNewMidiDevice && static_cast<int32_t>(QueueIndex) == m_LastQueueIndex)
+    {
+        return;
+    }
+
+    // MIDI port prefix, the following events came from this device
+    WriteVariableLength(m_WriteBuffer, DeltaTicks);
+    m_WriteBuffer.insert(m_WriteBuffer.end(), {0xFF, 0x21, 0x01, static_cast<uint8_t>(QueueIndex)});
+    DeltaTicks = 0;
+
+    if (bIsNewMidiDevice)
+    {
+        std::string MidiDeviceName;
+        {
+            const std::lock_guard<std::mutex> Lock(m_MidiDeviceNamesMutex);
+            MidiDeviceName = m_MidiDeviceNames[QueueIndex];
+        }
+
+        // Device name meta event
+        m_WriteBuffer.insert(m_WriteBuffer.end(), {0x00, 0xFF, 0x09});
+        WriteVariableLength(m_WriteBuffer, static_cast<uint32_t>(MidiDeviceName.size()));
+        m_WriteBuffer.insert(m_WriteBuffer.end(), MidiDeviceName.begin(), MidiDeviceName.end());
+        m_WrittenMidiDeviceGenerations[QueueIndex] = MidiDeviceGeneration;
+    }
+
+    m_LastQueueIndex = static_cast<int32_t>(QueueIndex);
+    m_RunningStatus = 0;
+}
+
+bool IEMidiCaptureWriter::OpenFile(std::chrono::steady_clock::time_point StartTime)
+{
+    const std::filesystem::path FilePath = m_Config.FolderPath / std::format("{}-{:03}.mid", m_CaptureName, m_FileIndex++);
+    m_File = std::fopen(FilePath.string().c_str(), "wb");
+    if (!m_File)
+    {
+        Fail(std::format("Failed to open midi capture file {}", FilePath.string()));
+        return false;
+    }
+    std::setvbuf(m_File, nullptr, _IOFBF, WRITE_BUFFER_BYTE_COUNT);
+
+    // Format 0 with a single track, whose length is patched at every checkpoint
+    std::array<uint8_t, FILE_HEADER_BYTE_COUNT> FileHeader = {'M', 'T', 'h', 'd', 0, 0, 0, 6, 0, 0, 0, 1, 0, 0, 'M', 'T', 'r', 'k', 0, 0, 0, 0};
+    WriteBigEndian(FileHeader.data() + 12, MIDI_CAPTURE_TICKS_PER_QUARTER_NOTE, 2);
+    if (std::fwrite(FileHeader.data(), 1, FileHeader.size(), m_File) != FileHeader.size())
+    {
+        Fail(std::format("Failed to write midi capture file {}", FilePath.string()));
+        return false;
+    }
+
+    m_FilePaths.push_back(FilePath);
+    m_FileCount.fetch_add(1, std::memory_order_relaxed);
+    while (m_Config.MaxFileCount > 0 && m_FilePaths.size() > m_Config.MaxFileCount)
+    {
+        std::error_code ErrorCode;
+        std::filesystem::remove(m_FilePaths.front(), ErrorCode);
+        m_FilePaths.pop_front();
+    }
+
+    m_TrackByteCount = 0;
+    m_WriteBuffer.clear();
+    m_LastEventTime = StartTime;
+    m_WrittenMidiDeviceGenerations.fill(0);
+    m_LastQueueIndex = -1;
+    m_RunningStatus = 0;
+
+    m_WriteBuffer.insert(m_WriteBuffer.end(), {0x00, 0xFF, 0x03, static_cast<uint8_t>(sizeof(MIDI_CAPTURE_TRACK_NAME) - 1)});
+    m_WriteBuffer.insert(m_WriteBuffer.end(), MIDI_CAPTURE_TRACK_NAME, MIDI_CAPTURE_TRACK_NAME + sizeof(MIDI_CAPTURE_TRACK_NAME) - 1);
+    m_WriteBuffer.insert(m_WriteBuffer.end(), {0x00, 0xFF, 0x51, 0x03, 0, 0, 0});
+    WriteBigEndian(m_WriteBuffer.data() + m_WriteBuffer.size() - 3, MIDI_CAPTURE_TEMPO_MICROSECONDS, 3);
+    return true;
+}
+
+void IEMidiCaptureWriter::CloseFile()
+{
+    if (m_File && Checkpoint())
+    {
+        const bool bIsClosed = std::fclose(m_File) == 0;
+        m_File = nullptr;
+        if (!bIsClosed)
+        {
+            Fail(std::format("Failed to close midi capture file {}", m_FilePaths.back().string()));
+        }
+    }
+}
+
+bool IEMidiCaptureWriter::Checkpoint()
+{
+    m_NextCheckpointTime = std::chrono::steady_clock::now() + CHECKPOINT_INTERVAL;
+    if (!m_File)
+    {
+        return false;
+    }
+
+    // The end of track is written after the events and overwritten by the next batch
+    const size_t EventByteCount = m_WriteBuffer.size();
+    m_WriteBuffer.insert(m_WriteBuffer.end(), END_OF_TRACK.begin(), END_OF_TRACK.end());
+    bool bIsWritten = std::fwrite(m_WriteBuffer.data(), 1, m_WriteBuffer.size(), m_File) == m_WriteBuffer.size();
+    m_WriteBuffer.clear();
+    m_TrackByteCount += EventByteCount;
+
+    std::array<uint8_t, 4> TrackLength = {};
+    WriteBigEndian(TrackLength.data(), static_cast<uint32_t>(m_TrackByteCount + END_OF_TRACK.size()), TrackLength.size());
+    bIsWritten = bIsWritten && std::fseek(m_File, TRACK_LENGTH_OFFSET, SEEK_SET) == 0 &&
+        std::fwrite(TrackLength.data(), 1, TrackLength.size(), m_File) == TrackLength.size() &&
+        std::fseek(m_File, -static_cast<long>(END_OF_TRACK.size()), SEEK_END) == 0 &&
+        std::fflush(m_File) == 0;
+    if (!bIsWritten)
+    {
+        Fail(std::format("Failed to write midi capture file {}", m_FilePaths.back().string()));
+        return false;
+    }
+
+    m_WrittenByteCount.fetch_add(EventByteCount, std::memory_order_relaxed);
+    return true;
+}
+
+void IEMidiCaptureWriter::Fail(const std::string& Message)
+{
+    // Messages keep being drained and counted as dropped, the input threads never notice
+    IELOG_ERROR("%s", Message.c_str());
+    m_bHasFailed = true;
+    m_WriteBuffer.clear();
+    if (m_File)
+    {
+        std::fclose(m_File);
+        m_File = nullptr;
+    }
+}
+
+void IEMidiCaptureWriter::WriteVariableLength(std::vector<uint8_t>& Buffer, uint32_t Value)
+{
+    std::array<uint8_t, 4> Bytes = {};
+    size_t ByteCount = 0;
+    do
+    {
+        Bytes[ByteCount++] = static_cast<uint8_t>(Value & 0x7F);
+        Value >>= 7;
+    } while (Value > 0 && ByteCount < Bytes.size());
+
+    while (ByteCount > 1)
+    {
+        Buffer.push_back(Bytes[--ByteCount] | 0x80);
+    }
+    Buffer.push_back(Bytes[0]);
+}
+
+void IEMidiCaptureWriter::WriteBigEndian(uint8_t* Destination, uint32_t Value, size_t ByteCount)
+{
+    for (size_t ByteIndex = 0; ByteIndex < ByteCount; ByteIndex++)
+    {
+        Destination[ByteIndex] = static_cast<uint8_t>(Value >> (8 * (ByteCount - ByteIndex - 1)));
+    }
+}
\ No newline at end of file
@@ -0,0 +1,171 @@
+// SPDX-License-Identifier: GPL-2.0-only
+// Copyright © Interactive Echoes. All rights reserved.
+// Author: mozahzah
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <semaphore>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "IEConcurrency.h"
+#include "IELog.h"
+
+#include "IEMidiActionWorker.h"
+#include "IEMidiMessage.h"
+
+static constexpr size_t MIDI_CAPTURE_QUEUE_CAPACITY = 16384;
+static constexpr size_t MIDI_CAPTURE_SYSEX_BYTE_COUNT = 256 * 1024;
+
+// Holds the first bytes of the message, anything longer is copied into the capture's own SysEx
+// bytes so a queued capture never holds a SysEx pool slot
+struct IEMidiCaptureEvent
+{
+    std::chrono::steady_clock::time_point ReceivedTime;
+    std::array<uint8_t, MIDI_MESSAGE_BYTE_COUNT> Bytes = {0, 0, 0};
+    uint64_t SysExOffset = 0;
+    uint16_t Size = 0;
+    bool bIsTruncated = false;
+    uint32_t QueueIndex = 0;
+};
+
+// The SysEx bytes are a ring with the same single producer and consumer as the events, the producer
+// copies them in before pushing the event that points at them
+struct IEMidiCaptureQueue
+{
+    IEMidiCaptureQueue() : CaptureEvents(MIDI_CAPTURE_QUEUE_CAPACITY), SysExBytes(MIDI_CAPTURE_SYSEX_BYTE_COUNT) {}
+
+    IESPSCQueue<IEMidiCaptureEvent> CaptureEvents;
+    std::vector<uint8_t> SysExBytes;
+    std::atomic<uint64_t> SysExWriteOffset = 0;
+    std::atomic<uint64_t> SysExReadOffset = 0;
+};
+
+struct IEMidiCaptureConfig
+{
+    std::filesystem::path FolderPath;
+    uint64_t MaxFileSize = 16 * 1024 * 1024;
+    // The oldest files of the capture are deleted past this count, 0 keeps them all
+    uint32_t MaxFileCount = 0;
+};
+
+struct IEMidiCaptureStats
+{
+    uint64_t CapturedCount = 0;
+    uint64_t WrittenCount = 0;
+    uint64_t DroppedCount = 0;
+    // Written SysEx that was cut to fit the SysEx pool, each is closed with an F7 in the file
+    uint64_t TruncatedCount = 0;
+    uint64_t PeakQueueDepth = 0;
+    uint64_t WrittenByteCount = 0;
+    uint32_t FileCount = 0;
+};
+
+// Streams every incoming midi message to Standard MIDI Files. Like the action worker, each midi
+// input thread is the single producer of its own SPSC queue and never blocks or touches the
+// filesystem. The writer thread polls the queues instead of being woken per message, orders each
+// batch by receive time and appends it to a format 0 track with 100 us ticks. The source device is
+// recorded with MIDI port meta events. At every checkpoint the track is closed and its length
+// patched, so the file on disk stays readable while it grows, and files rotate at the size limit.
+class IEMidiCaptureWriter
+{
+public:
+    IEMidiCaptureWriter() = default;
+    ~IEMidiCaptureWriter();
+    IEMidiCaptureWriter(const IEMidiCaptureWriter&) = delete;
+    IEMidiCaptureWriter& operator=(const IEMidiCaptureWriter&) = delete;
+
+public:
+    IEResult Start(const IEMidiCaptureConfig& Config);
+    void Stop();
+    bool IsRunning() const { return m_WriterThread.joinable(); }
+
+public:
+    // Called from the thread that starts and stops the writer, before the device's input thread
+    // starts and after it stops. Queues are kept allocated once created.
+    void OpenQueue(uint32_t QueueIndex, const std::string& MidiDeviceName);
+    void CloseQueue(uint32_t QueueIndex);
+
+public:
+    bool Enqueue(uint32_t QueueIndex, std::chrono::steady_clock::time_point ReceivedTime, const IEMidiMessage& MidiMessage);
+    IEMidiCaptureStats GetStats() const;
+
+private:
+    void AllocateQueue(uint32_t QueueIndex);
+    void Run();
+    bool DrainQueues();
+    void DiscardQueues();
+    void WriteCaptureEvent(const IEMidiCaptureEvent& CaptureEvent);
+    void WriteDeviceMetaEvents(uint32_t QueueIndex, uint32_t& DeltaTicks);
+
+private:
+    // Rotated files start at the message that did not fit, not at the time the writer got to it
+    bool OpenFile(std::chrono::steady_clock::time_point StartTime);
+    void CloseFile();
+    bool Checkpoint();
+    void Fail(const std::string& Message);
+
+private:
+    static void WriteVariableLength(std::vector<uint8_t>& Buffer, uint32_t Value);
+    static void WriteBigEndian(uint8_t* Destination, uint32_t Value, size_t ByteCount);
+
+private:
+    static constexpr size_t MAX_EVENTS_PER_QUEUE_PASS = 4096;
+    static constexpr size_t WRITE_BUFFER_BYTE_COUNT = 64 * 1024;
+    static constexpr std::chrono::milliseconds DRAIN_INTERVAL = std::chrono::milliseconds(5);
+    static constexpr std::chrono::milliseconds CHECKPOINT_INTERVAL = std::chrono::milliseconds(1000);
+
+private:
+    std::array<std::unique_ptr<IEMidiCaptureQueue>, MAX_EVENT_QUEUE_COUNT> m_OwnedCaptureQueues;
+    std::array<std::atomic<IEMidiCaptureQueue*>, MAX_EVENT_QUEUE_COUNT> m_CaptureQueues = {};
+    std::array<bool, MAX_EVENT_QUEUE_COUNT> m_bIsQueueOpen = {};
+    std::atomic<bool> m_bIsCapturing = false;
+    std::atomic<bool> m_bStopRequested = false;
+    std::counting_semaphore<> m_StopSemaphore = std::counting_semaphore<>(0);
+    std::thread m_WriterThread;
+
+private:
+    // A device opening on a reused queue bumps its generation, so the writer names it again
+    mutable std::mutex m_MidiDeviceNamesMutex;
+    std::array<std::string, MAX_EVENT_QUEUE_COUNT> m_MidiDeviceNames;
+    std::array<std::atomic<uint32_t>, MAX_EVENT_QUEUE_COUNT> m_MidiDeviceGenerations = {};
+
+private:
+    // Writer thread only
+    IEMidiCaptureConfig m_Config;
+    std::string m_CaptureName;
+    std::deque<std::filesystem::path> m_FilePaths;
+    uint32_t m_FileIndex = 0;
+    std::FILE* m_File = nullptr;
+    bool m_bHasFailed = false;
+    std::vector<IEMidiCaptureEvent> m_PendingCaptureEvents;
+    // SysEx bytes of the pending events, whose SysExOffset points in here once drained
+    std::vector<uint8_t> m_PendingSysExBytes;
+    std::vector<uint8_t> m_WriteBuffer;
+    uint64_t m_TrackByteCount = 0;
+    std::chrono::steady_clock::time_point m_LastEventTime;
+    std::chrono::steady_clock::time_point m_NextCheckpointTime;
+    std::array<uint32_t, MAX_EVENT_QUEUE_COUNT> m_WrittenMidiDeviceGenerations = {};
+    int32_t m_LastQueueIndex = -1;
+    uint8_t m_RunningStatus = 0;
+
+private:
+    std::atomic<uint64_t> m_CapturedCount = 0;
+    std::atomic<uint64_t> m_WrittenCount = 0;
+    std::atomic<uint64_t> m_DroppedCount = 0;
+    std::atomic<uint64_t> m_TruncatedCount = 0;
+    std::atomic<uint64_t> m_PeakQueueDepth = 0;
+    std::atomic<uint64_t> m_ConsumedCount = 0;
+    std::atomic<uint64_t> m_WrittenByteCount = 0;
+    std::atomic<uint32_t> m_FileCount = 0;
+};
\ No newline at end of file
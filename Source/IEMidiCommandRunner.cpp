@@ -0,0 +1,582 @@
+// SPDX-License-Identifier: GPL-2.0-only
+// Copyright © Interactive Echoes. All rights reserved.
+// Author: mozahzah
+
+#include "IEMidiCommandRunner.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <string_view>
+
+#if !defined(_WIN32)
+#include <csignal>
+#include <fcntl.h>
+#include <pthread.h>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char** environ;
+#endif
+
+static constexpr std::string_view SHELL_SYNTAX_CHARACTERS = "|&;<>()$`*?[]{}~\n";
+static constexpr char SHELL_PATH[] = "/bin/sh";
+static constexpr uint32_t PERSISTENT_COMMAND_EXIT_POLL_COUNT = 50;
+static constexpr std::chrono::milliseconds PERSISTENT_COMMAND_EXIT_POLL_INTERVAL = std::chrono::milliseconds(10);
+
+// Splits a command the way a shell would for plain words and quotes. Returns false when the command
+// relies on anything else, such as pipes, redirections, globs, variables or assignments.
+static bool TokeniseCommand(const std::string& ConsoleCommand, std::vector<std::string>& Arguments)
+{
+    std::string Argument;
+    bool bHasArgument = false;
+    char Quote = '\0';
+    for (size_t i = 0; i < ConsoleCommand.size(); i++)
+    {
+        const char Character = ConsoleCommand[i];
+        if (Quote == '\'')
+        {
+            if (Character == '\'')
+            {
+                Quote = '\0';
+            }
+            else
+            {
+                Argument += Character;
+            }
+        }
+        else if (Quote == '"')
+        {
+            if (Character == '"')
+            {
+                Quote = '\0';
+            }
+            else if (Character == '$' || Character == '`')
+            {
+                return false;
+            }
+            else if (Character == '\\' && i + 1 < ConsoleCommand.size() && std::string_view("\"\\$`").find(ConsoleCommand[i + 1]) != std::string_view::npos)
+            {
+                Argument += ConsoleCommand[++i];
+            }
+            else
+            {
+                Argument += Character;
+            }
+        }
+        else if (Character == ' ' || Character == '\t')
+        {
+            if (bHasArgument)
+            {
+                Arguments.emplace_back(std::move(Argument));
+                Argument.clear();
+                bHasArgument = false;
+            }
+        }
+        else
+        {
+            if (SHELL_SYNTAX_CHARACTERS.find(Character) != std::string_view::npos ||
+                (Character == '#' && !bHasArgument) ||
+                (Character == '=' && Arguments.empty()))
+            {
+                return false;
+            }
+
+            bHasArgument = true;
+            if (Character == '\'' || Character == '"')
+            {
+                Quote = Character;
+            }
+            else if (Character == '\\')
+            {
+                if (i + 1 < ConsoleCommand.size())
+                {
+                    Argument += ConsoleCommand[++i];
+                }
+            }
+            else
+            {
+                Argument += Character;
+            }
+        }
+    }
+
+    if (Quote != '\0')
+    {
+        // Unterminated quote, leave it to the shell to report
+        return false;
+    }
+    if (bHasArgument)
+    {
+        Arguments.emplace_back(std::move(Argument));
+    }
+    return true;
+}
+
+std::shared_ptr<const IEMidiCompiledCommand> IEMidiCompiledCommand::Compile(const std::string& ConsoleCommand, bool bIsPersistent)
+{
+    const std::shared_ptr<IEMidiCompiledCommand> CompiledCommand = std::make_shared<IEMidiCompiledCommand>();
+    CompiledCommand->ConsoleCommand = ConsoleCommand;
+    CompiledCommand->bIsPersistent = bIsPersistent;
+    if (!TokeniseCommand(ConsoleCommand, CompiledCommand->Arguments))
+    {
+        // The midi value follows as $1 so the shell sees it where a plain command would
+        CompiledCommand->Arguments = bIsPersistent ?
+            std::vector<std::string>{SHELL_PATH, "-c", ConsoleCommand} :
+            std::vector<std::string>{SHELL_PATH, "-c", ConsoleCommand + " \"$1\"", "sh"};
+    }
+
+    if (CompiledCommand->Arguments.empty())
+    {
+        return nullptr;
+    }
+    return CompiledCommand;
+}
+
+#if !defined(_WIN32)
+static pid_t SpawnCommand(const std::vector<std::string>& Arguments, const std::string* Value, int InputFileDescriptor)
+{
+    std::vector<char*> ArgumentPointers;
+    ArgumentPointers.reserve(Arguments.size() + 2);
+    for (const std::string& Argument : Arguments)
+    {
+        ArgumentPointers.push_back(const_cast<char*>(Argument.c_str()));
+    }
+    if (Value)
+    {
+        ArgumentPointers.push_back(const_cast<char*>(Value->c_str()));
+    }
+    ArgumentPointers.push_back(nullptr);
+
+    posix_spawn_file_actions_t FileActions;
+    posix_spawn_file_actions_init(&FileActions);
+    if (InputFileDescriptor >= 0)
+    {
+        posix_spawn_file_actions_adddup2(&FileActions, InputFileDescriptor, STDIN_FILENO);
+    }
+    else
+    {
+        posix_spawn_file_actions_addopen(&FileActions, STDIN_FILENO, "/dev/null", O_RDONLY, 0);
+    }
+
+    // The worker threads block SIGPIPE, the command starts with the default mask and disposition
+    sigset_t EmptySignals;
+    sigemptyset(&EmptySignals);
+    sigset_t DefaultSignals;
+    sigemptyset(&DefaultSignals);
+    sigaddset(&DefaultSignals, SIGPIPE);
+
+    posix_spawnattr_t Attributes;
+    posix_spawnattr_init(&Attributes);
+    posix_spawnattr_setsigmask(&Attributes, &EmptySignals);
+    posix_spawnattr_setsigdefault(&Attributes, &DefaultSignals);
+    posix_spawnattr_setflags(&Attributes, POSIX_SPAWN_SETSIGMASK | POSIX_SPAWN_SETSIGDEF);
+
+    pid_t ProcessID = -1;
+    const int Error = posix_spawnp(&ProcessID, ArgumentPointers[0], &FileActions, &Attributes, ArgumentPointers.data(), environ);
+    posix_spawnattr_destroy(&Attributes);
+    posix_spawn_file_actions_destroy(&FileActions);
+
+    if (Error != 0)
+    {
+        IELOG_ERROR("Failed to launch console command %s, %s", ArgumentPointers[0], std::strerror(Error));
+        return -1;
+    }
+    return ProcessID;
+}
+
+static bool WaitForCommand(pid_t ProcessID)
+{
+    int Status = 0;
+    while (waitpid(ProcessID, &Status, 0) < 0)
+    {
+        if (errno != EINTR)
+        {
+            return false;
+        }
+    }
+    return WIFEXITED(Status) && WEXITSTATUS(Status) == 0;
+}
+
+static void ConsumePendingPipeSignal()
+{
+    sigset_t PendingSignals;
+    sigemptyset(&PendingSignals);
+    if (sigpending(&PendingSignals) == 0 && sigismember(&PendingSignals, SIGPIPE))
+    {
+        sigset_t PipeSignal;
+        sigemptyset(&PipeSignal);
+        sigaddset(&PipeSignal, SIGPIPE);
+        int Signal = 0;
+        sigwait(&PipeSignal, &Signal);
+    }
+}
+
+static bool WriteLine(int FileDescriptor, const std::string& Line)
+{
+    size_t WrittenSize = 0;
+    while (WrittenSize < Line.size())
+    {
+        const ssize_t Result = write(FileDescriptor, Line.data() + WrittenSize, Line.size() - WrittenSize);
+        if (Result < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            if (errno == EPIPE)
+            {
+                ConsumePendingPipeSignal();
+            }
+            return false;
+        }
+        WrittenSize += static_cast<size_t>(Result);
+    }
+    return true;
+}
+#endif
+
+IEMidiCommandRunner::IEMidiCommandRunner(const IEMidiCommandRunnerConfig& Config)
+{
+    SetConfig(Config);
+}
+
+IEMidiCommandRunner::~IEMidiCommandRunner()
+{
+    {
+        std::scoped_lock Lock(m_Mutex);
+        m_bStopRequested = true;
+    }
+    m_WakeCondition.notify_all();
+
+    // Queued values are dropped, running commands are waited on
+    for (std::thread& WorkerThread : m_WorkerThreads)
+    {
+        if (WorkerThread.joinable())
+        {
+            WorkerThread.join();
+        }
+    }
+
+    for (auto& [ConsoleCommand, PersistentCommand] : m_PersistentCommands)
+    {
+        StopPersistentCommand(PersistentCommand);
+    }
+    for (IEPersistentCommand& PersistentCommand : m_StoppingPersistentCommands)
+    {
+        StopPersistentCommand(PersistentCommand);
+    }
+}
+
+bool IEMidiCommandRunner::Submit(const std::shared_ptr<const IEMidiCompiledCommand>& CompiledCommand, float Value)
+{
+    if (!IsSupported() || !CompiledCommand)
+    {
+        return false;
+    }
+
+    {
+        std::scoped_lock Lock(m_Mutex);
+        m_Stats.SubmittedCount++;
+        if (m_RunningConsoleCommands.contains(CompiledCommand->ConsoleCommand))
+        {
+            // Only the newest queued value is replaced, so older ones still run before it
+            const auto PendingCommandIt = std::find_if(m_PendingCommands.rbegin(), m_PendingCommands.rend(),
+                [&CompiledCommand](const IEPendingCommand& PendingCommand)
+                {
+                    return PendingCommand.CompiledCommand->ConsoleCommand == CompiledCommand->ConsoleCommand;
+                });
+            if (PendingCommandIt != m_PendingCommands.rend())
+            {
+                *PendingCommandIt = IEPendingCommand{CompiledCommand, Value};
+                m_Stats.ReplacedCount++;
+                return true;
+            }
+        }
+
+        if (m_PendingCommands.size() >= m_Config.MaxQueuedCommandCount)
+        {
+            switch (m_Config.OverflowPolicy)
+            {
+                case IEMidiCommandOverflowPolicy::DropOldest:
+                {
+                    m_PendingCommands.pop_front();
+                    m_Stats.DroppedCount++;
+                    break;
+                }
+                case IEMidiCommandOverflowPolicy::ReplacePending:
+                {
+                    const auto PendingCommandIt = std::find_if(m_PendingCommands.rbegin(), m_PendingCommands.rend(),
+                        [&CompiledCommand](const IEPendingCommand& PendingCommand)
+                        {
+                            return PendingCommand.CompiledCommand->bIsPersistent == CompiledCommand->bIsPersistent &&
+                                PendingCommand.CompiledCommand->ConsoleCommand == CompiledCommand->ConsoleCommand;
+                        });
+                    if (PendingCommandIt != m_PendingCommands.rend())
+                    {
+                        PendingCommandIt->Value = Value;
+                        m_Stats.ReplacedCount++;
+                        return true;
+                    }
+                    m_Stats.DroppedCount++;
+                    return false;
+                }
+                default:
+                {
+                    m_Stats.DroppedCount++;
+                    return false;
+                }
+            }
+        }
+
+        m_PendingCommands.push_back(IEPendingCommand{CompiledCommand, Value});
+        m_Stats.PeakQueueDepth = std::max<uint64_t>(m_Stats.PeakQueueDepth, m_PendingCommands.size());
+    }
+    m_WakeCondition.notify_one();
+    return true;
+}
+
+void IEMidiCommandRunner::RetainPersistentCommands(std::set<std::string> ConsoleCommands)
+{
+    {
+        std::scoped_lock Lock(m_Mutex);
+        for (auto PersistentCommandIt = m_PersistentCommands.begin(); PersistentCommandIt != m_PersistentCommands.end();)
+        {
+            // A running helper is stopped by its worker once the value it is writing is done
+            if (!ConsoleCommands.contains(PersistentCommandIt->first) && !m_RunningConsoleCommands.contains(PersistentCommandIt->first))
+            {
+                m_StoppingPersistentCommands.push_back(PersistentCommandIt->second);
+                PersistentCommandIt = m_PersistentCommands.erase(PersistentCommandIt);
+            }
+            else
+            {
+                ++PersistentCommandIt;
+            }
+        }
+        m_RetainedPersistentCommands = std::move(ConsoleCommands);
+    }
+    m_WakeCondition.notify_one();
+}
+
+void IEMidiCommandRunner::SetConfig(const IEMidiCommandRunnerConfig& Config)
+{
+    {
+        std::scoped_lock Lock(m_Mutex);
+        m_Config = Config;
+        m_Config.MaxConcurrentCommandCount = std::clamp<uint32_t>(Config.MaxConcurrentCommandCount, 1, MAX_WORKER_THREAD_COUNT);
+        m_Config.MaxQueuedCommandCount = std::max<uint32_t>(Config.MaxQueuedCommandCount, 1);
+        StartWorkerThreads();
+    }
+    m_WakeCondition.notify_all();
+}
+
+IEMidiCommandRunnerConfig IEMidiCommandRunner::GetConfig() const
+{
+    std::scoped_lock Lock(m_Mutex);
+    return m_Config;
+}
+
+IEMidiCommandRunnerStats IEMidiCommandRunner::GetStats() const
+{
+    std::scoped_lock Lock(m_Mutex);
+    return m_Stats;
+}
+
+void IEMidiCommandRunner::StartWorkerThreads()
+{
+    if (IsSupported())
+    {
+        // Threads are never stopped when the limit drops, the extra ones simply stay idle
+        while (m_WorkerThreads.size() < m_Config.MaxConcurrentCommandCount)
+        {
+            m_WorkerThreads.emplace_back(&IEMidiCommandRunner::Run, this);
+        }
+    }
+}
+
+void IEMidiCommandRunner::Run()
+{
+#if !defined(_WIN32)
+    // A persistent command that exited fails the write instead of terminating the process
+    sigset_t PipeSignal;
+    sigemptyset(&PipeSignal);
+    sigaddset(&PipeSignal, SIGPIPE);
+    pthread_sigmask(SIG_BLOCK, &PipeSignal, nullptr);
+#endif
+
+    std::unique_lock Lock(m_Mutex);
+    while (true)
+    {
+        m_WakeCondition.wait(Lock, [this]()
+            {
+                return m_bStopRequested || !m_StoppingPersistentCommands.empty() ||
+                    (m_RunningCommandCount < m_Config.MaxConcurrentCommandCount && FindRunnableCommand() != m_PendingCommands.end());
+            });
+        if (m_bStopRequested)
+        {
+            break;
+        }
+
+        if (!m_StoppingPersistentCommands.empty())
+        {
+            std::vector<IEPersistentCommand> StoppingPersistentCommands = std::move(m_StoppingPersistentCommands);
+            m_StoppingPersistentCommands.clear();
+            Lock.unlock();
+            for (IEPersistentCommand& PersistentCommand : StoppingPersistentCommands)
+            {
+                StopPersistentCommand(PersistentCommand);
+            }
+            Lock.lock();
+            continue;
+        }
+
+        const auto PendingCommandIt = FindRunnableCommand();
+        const IEPendingCommand PendingCommand = std::move(*PendingCommandIt);
+        m_PendingCommands.erase(PendingCommandIt);
+        m_RunningCommandCount++;
+        m_RunningConsoleCommands.insert(PendingCommand.CompiledCommand->ConsoleCommand);
+
+        // Values for a command run on one thread at a time, in order
+        bool bIsExecuted = false;
+        if (PendingCommand.CompiledCommand->bIsPersistent)
+        {
+            IEPersistentCommand& PersistentCommand = m_PersistentCommands[PendingCommand.CompiledCommand->ConsoleCommand];
+            Lock.unlock();
+            bIsExecuted = WritePersistentCommand(PersistentCommand, *PendingCommand.CompiledCommand, PendingCommand.Value);
+            Lock.lock();
+
+            const std::string& ConsoleCommand = PendingCommand.CompiledCommand->ConsoleCommand;
+            if (m_RetainedPersistentCommands && !m_RetainedPersistentCommands->contains(ConsoleCommand))
+            {
+                m_StoppingPersistentCommands.push_back(PersistentCommand);
+                m_PersistentCommands.erase(ConsoleCommand);
+            }
+        }
+        else
+        {
+            Lock.unlock();
+            bIsExecuted = RunCommand(*PendingCommand.CompiledCommand, PendingCommand.Value);
+            Lock.lock();
+        }
+
+        m_RunningConsoleCommands.erase(PendingCommand.CompiledCommand->ConsoleCommand);
+        m_RunningCommandCount--;
+        if (bIsExecuted)
+        {
+            m_Stats.ExecutedCount++;
+        }
+        else
+        {
+            m_Stats.FailedCount++;
+        }
+        m_WakeCondition.notify_all();
+    }
+}
+
+std::deque<IEMidiCommandRunner::IEPendingCommand>::iterator IEMidiCommandRunner::FindRunnableCommand()
+{
+    return std::find_if(m_PendingCommands.begin(), m_PendingCommands.end(), [this](const IEPendingCommand& PendingCommand)
+        {
+            return !m_RunningConsoleCommands.contains(PendingCommand.CompiledCommand->ConsoleCommand);
+        });
+}
+
+bool IEMidiCommandRunner::RunCommand(const IEMidiCompiledCommand& CompiledCommand, float Value)
+{
+#if !defined(_WIN32)
+    const std::string ValueArgument = std::format("{}", Value);
+    const pid_t ProcessID = SpawnCommand(CompiledCommand.Arguments, &ValueArgument, -1);
+    return ProcessID > 0 && WaitForCommand(ProcessID);
+#else
+    return false;
+#endif
+}
+
+bool IEMidiCommandRunner::WritePersistentCommand(IEPersistentCommand& PersistentCommand, const IEMidiCompiledCommand& CompiledCommand, float Value)
+{
+#if !defined(_WIN32)
+    const std::string Line = std::format("{}\n", Value);
+    for (uint32_t Attempt = 0; Attempt < 2; Attempt++)
+    {
+        if (PersistentCommand.ProcessID < 0 && !StartPersistentCommand(PersistentCommand, CompiledCommand))
+        {
+            return false;
+        }
+        if (WriteLine(PersistentCommand.InputFileDescriptor, Line))
+        {
+            return true;
+        }
+
+        // The command exited, it is restarted once for this value
+        StopPersistentCommand(PersistentCommand);
+    }
+#endif
+    return false;
+}
+
+bool IEMidiCommandRunner::StartPersistentCommand(IEPersistentCommand& PersistentCommand, const IEMidiCompiledCommand& CompiledCommand)
+{
+#if !defined(_WIN32)
+    int PipeFileDescriptors[2] = {-1, -1};
+#if defined(__linux__)
+    if (pipe2(PipeFileDescriptors, O_CLOEXEC) != 0)
+    {
+        return false;
+    }
+#else
+    if (pipe(PipeFileDescriptors) != 0)
+    {
+        return false;
+    }
+    fcntl(PipeFileDescriptors[0], F_SETFD, FD_CLOEXEC);
+    fcntl(PipeFileDescriptors[1], F_SETFD, FD_CLOEXEC);
+#endif
+
+    const pid_t ProcessID = SpawnCommand(CompiledCommand.Arguments, nullptr, PipeFileDescriptors[0]);
+    close(PipeFileDescriptors[0]);
+    if (ProcessID < 0)
+    {
+        close(PipeFileDescriptors[1]);
+        return false;
+    }
+
+    PersistentCommand.ProcessID = ProcessID;
+    PersistentCommand.InputFileDescriptor = PipeFileDescriptors[1];
+    return true;
+#else
+    return false;
+#endif
+}
+
+void IEMidiCommandRunner::StopPersistentCommand(IEPersistentCommand& PersistentCommand)
+{
+#if !defined(_WIN32)
+    if (PersistentCommand.InputFileDescriptor >= 0)
+    {
+        close(PersistentCommand.InputFileDescriptor);
+        PersistentCommand.InputFileDescriptor = -1;
+    }
+
+    if (PersistentCommand.ProcessID > 0)
+    {
+        // Closing its input asks the command to exit, it is terminated if it does not
+        bool bHasExited = false;
+        for (uint32_t i = 0; i < PERSISTENT_COMMAND_EXIT_POLL_COUNT && !bHasExited; i++)
+        {
+            int Status = 0;
+            bHasExited = waitpid(PersistentCommand.ProcessID, &Status, WNOHANG) != 0;
+            if (!bHasExited)
+            {
+                std::this_thread::sleep_for(PERSISTENT_COMMAND_EXIT_POLL_INTERVAL);
+            }
+        }
+        if (!bHasExited)
+        {
+            kill(PersistentCommand.ProcessID, SIGTERM);
+            WaitForCommand(PersistentCommand.ProcessID);
+        }
+        PersistentCommand.ProcessID = -1;
+    }
+#endif
+}
\ No newline at end of file
@@ -0,0 +1,130 @@
+// SPDX-License-Identifier: GPL-2.0-only
+// Copyright © Interactive Echoes. All rights reserved.
+// Author: mozahzah
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "IELog.h"
+
+enum class IEMidiCommandOverflowPolicy : uint8_t
+{
+    DropNewest,         // Rejects the incoming value while the queue is full
+    DropOldest,         // Evicts the oldest queued value to make room
+    ReplacePending      // Overwrites the value already queued for the same command, otherwise drops the newest
+};
+
+struct IEMidiCommandRunnerConfig
+{
+    uint32_t MaxConcurrentCommandCount = 4;
+    uint32_t MaxQueuedCommandCount = 64;
+    IEMidiCommandOverflowPolicy OverflowPolicy = IEMidiCommandOverflowPolicy::ReplacePending;
+};
+
+struct IEMidiCommandRunnerStats
+{
+    uint64_t SubmittedCount = 0;
+    uint64_t ExecutedCount = 0;
+    uint64_t ReplacedCount = 0;
+    uint64_t DroppedCount = 0;
+    uint64_t FailedCount = 0;
+    uint64_t PeakQueueDepth = 0;
+};
+
+// A console command tokenised once when its profile is compiled. The midi value is passed as the last
+// argument, or written as a line to the standard input of a persistent command that stays running.
+// Commands using shell syntax such as pipes or variables are handed to /bin/sh as is.
+struct IEMidiCompiledCommand
+{
+    static std::shared_ptr<const IEMidiCompiledCommand> Compile(const std::string& ConsoleCommand, bool bIsPersistent);
+
+    std::string ConsoleCommand;
+    std::vector<std::string> Arguments;
+    bool bIsPersistent = false;
+};
+
+// Runs console commands on a small pool of threads without going through a shell, so a turned knob
+// costs one process launch per value instead of a shell and the command it starts. Submitting never
+// waits on a command, values that do not fit in the bounded queue are handled by the overflow policy.
+// Each command runs one value at a time, values submitted while it runs collapse into the one queued
+// behind it, so the last value sent is always the last one applied.
+class IEMidiCommandRunner
+{
+public:
+    explicit IEMidiCommandRunner(const IEMidiCommandRunnerConfig& Config = IEMidiCommandRunnerConfig());
+    ~IEMidiCommandRunner();
+    IEMidiCommandRunner(const IEMidiCommandRunner&) = delete;
+    IEMidiCommandRunner& operator=(const IEMidiCommandRunner&) = delete;
+
+public:
+    // Windows keeps executing through IEAction_ConsoleCommand
+    static constexpr bool IsSupported()
+    {
+#if defined(_WIN32)
+        return false;
+#else
+        return true;
+#endif
+    }
+
+public:
+    // Returns false when the value was dropped
+    bool Submit(const std::shared_ptr<const IEMidiCompiledCommand>& CompiledCommand, float Value);
+    // Called whenever profiles are published. Helpers of persistent commands missing from the set are
+    // stopped on a worker thread, a value still reaching one starts it again only until that value ran.
+    void RetainPersistentCommands(std::set<std::string> ConsoleCommands);
+    void SetConfig(const IEMidiCommandRunnerConfig& Config);
+    IEMidiCommandRunnerConfig GetConfig() const;
+    IEMidiCommandRunnerStats GetStats() const;
+
+private:
+    struct IEPendingCommand
+    {
+        std::shared_ptr<const IEMidiCompiledCommand> CompiledCommand;
+        float Value = 0.0f;
+    };
+
+    struct IEPersistentCommand
+    {
+        int ProcessID = -1;
+        int InputFileDescriptor = -1;
+    };
+
+private:
+    void Run();
+    void StartWorkerThreads();
+    std::deque<IEPendingCommand>::iterator FindRunnableCommand();
+    static bool RunCommand(const IEMidiCompiledCommand& CompiledCommand, float Value);
+    static bool WritePersistentCommand(IEPersistentCommand& PersistentCommand, const IEMidiCompiledCommand& CompiledCommand, float Value);
+    static bool StartPersistentCommand(IEPersistentCommand& PersistentCommand, const IEMidiCompiledCommand& CompiledCommand);
+    static void StopPersistentCommand(IEPersistentCommand& PersistentCommand);
+
+private:
+    static constexpr uint32_t MAX_WORKER_THREAD_COUNT = 64;
+
+private:
+    mutable std::mutex m_Mutex;
+    std::condition_variable m_WakeCondition;
+    IEMidiCommandRunnerConfig m_Config;
+    IEMidiCommandRunnerStats m_Stats;
+    std::deque<IEPendingCommand> m_PendingCommands;
+    std::map<std::string, IEPersistentCommand> m_PersistentCommands;
+    std::optional<std::set<std::string>> m_RetainedPersistentCommands;
+    std::vector<IEPersistentCommand> m_StoppingPersistentCommands;
+    std::set<std::string> m_RunningConsoleCommands;
+    uint32_t m_RunningCommandCount = 0;
+    bool m_bStopRequested = false;
+    std::vector<std::thread> m_WorkerThreads;
+};
\ No newline at end of file
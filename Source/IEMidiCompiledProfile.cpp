@@ -0,0 +1,47 @@
+// SPDX-License-Identifier: GPL-2.0-only
+// Copyright © Interactive Echoes. All rights reserved.
+// Author: mozahzah
+
+#include "IEMidiCompiledProfile.h"
+
+#include "IEMidiCommandRunner.h"
+
+IEMidiCompiledProfile::IEMidiCompiledProfile(const IEMidiDeviceProfile& MidiDeviceProfile) :
+    m_ProfileState(MidiDeviceProfile.RuntimeState)
+{
+    m_InputProperties.reserve(MidiDeviceProfile.InputProperties.Size());
+    for (const IEMidiDeviceInputProperty& MidiDeviceInputProperty : MidiDeviceProfile.InputProperties)
+    {
+        IEMidiCompiledInputProperty& MidiInputProperty = m_InputProperties.emplace_back();
+        MidiInputProperty.PropertyHandle = MidiDeviceInputProperty.GetHandle();
+        if (MidiDeviceInputProperty.MidiActionType == IEMidiActionType::ConsoleCommand)
+        {
+            MidiInputProperty.CompiledCommand = IEMidiCompiledCommand::Compile(MidiDeviceInputProperty.ConsoleCommand,
+                MidiDeviceInputProperty.bIsConsoleCommandPersistent);
+        }
+        MidiInputProperty.OpenFilePath = MidiDeviceInputProperty.OpenFilePath;
+        MidiInputProperty.CoalesceInterval = MidiDeviceInputProperty.GetCoalesceInterval();
+        MidiInputProperty.RuntimeState = MidiDeviceInputProperty.RuntimeState;
+    }
+
+    // Entries refer to the cold properties by their position in the profile
+    m_DispatchTable.Build(MidiDeviceProfile);
+}
+
+bool IEMidiCompiledProfile::HasRecordingInputProperties() const
+{
+    return m_ProfileState && m_ProfileState->RecordingCount.load(std::memory_order_acquire) > 0;
+}
+
+uint32_t IEMidiCompiledProfile::GetLearnSessionID() const
+{
+    return m_ProfileState ? m_ProfileState->LearnSessionID.load(std::memory_order_acquire) : 0;
+}
+
+void IEMidiCompiledProfile::ReleaseRecordingInputProperty() const
+{
+    if (m_ProfileState)
+    {
+        m_ProfileState->RecordingCount.fetch_sub(1, std::memory_order_release);
+    }
+}
\ No newline at end of file
@@ -0,0 +1,36 @@
+// SPDX-License-Identifier: GPL-2.0-only
+// Copyright © Interactive Echoes. All rights reserved.
+// Author: mozahzah
+
+#pragma once
+
+#include <memory>
+#include <span>
+#include <vector>
+
+#include "IEMidiDispatchTable.h"
+#include "IEMidiTypes.h"
+
+// Immutable snapshot of a device profile. The UI thread builds a new one after every edit and
+// publishes it, the midi threads only ever read it. Runtime state is shared with the source profile.
+class IEMidiCompiledProfile : public std::enable_shared_from_this<IEMidiCompiledProfile>
+{
+public:
+    explicit IEMidiCompiledProfile(const IEMidiDeviceProfile& MidiDeviceProfile);
+    IEMidiCompiledProfile(const IEMidiCompiledProfile&) = delete;
+    IEMidiCompiledProfile& operator=(const IEMidiCompiledProfile&) = delete;
+
+public:
+    IEMidiMatchRange Find(const IEMidiMessage& MidiMessage) const { return m_DispatchTable.Find(MidiMessage); }
+    IEMidiInputMatch GetMatch(uint32_t EntryIndex) const { return m_DispatchTable.GetMatch(EntryIndex); }
+    const IEMidiCompiledInputProperty& GetInputProperty(uint32_t PropertyIndex) const { return m_InputProperties[PropertyIndex]; }
+    std::span<const IEMidiCompiledInputProperty> GetInputProperties() const { return m_InputProperties; }
+    bool HasRecordingInputProperties() const;
+    uint32_t GetLearnSessionID() const;
+    void ReleaseRecordingInputProperty() const;
+
+private:
+    std::vector<IEMidiCompiledInputProperty> m_InputProperties;
+    IEMidiDispatchTable m_DispatchTable;
+    std::shared_ptr<IEMidiDeviceProfileState> m_ProfileState;
+};
\ No newline at end of file
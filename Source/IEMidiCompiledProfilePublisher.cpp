@@ -0,0 +1,54 @@
+// SPDX-License-Identifier: GPL-2.0-only
+// Copyright © Interactive Echoes. All rights reserved.
+// Author: mozahzah
+
+#include "IEMidiCompiledProfilePublisher.h"
+
+#include <algorithm>
+
+void IEMidiCompiledProfilePublisher::Publish(std::shared_ptr<const IEMidiCompiledProfile> CompiledProfile)
+{
+    m_PublishedProfile.store(CompiledProfile.get(), std::memory_order_seq_cst);
+    if (m_OwnedProfile)
+    {
+        m_RetiredProfiles.push_back(std::move(m_OwnedProfile));
+    }
+    m_OwnedProfile = std::move(CompiledProfile);
+    ReclaimRetiredProfiles();
+}
+
+const IEMidiCompiledProfile* IEMidiCompiledProfilePublisher::Acquire(size_t ReaderSlot)
+{
+    IEAssert(ReaderSlot < READER_SLOT_COUNT);
+
+    // Announce, then confirm the snapshot is still the published one so the writer cannot have missed it
+    const IEMidiCompiledProfile* CompiledProfile = m_PublishedProfile.load(std::memory_order_acquire);
+    while (true)
+    {
+        m_ReaderSlots[ReaderSlot].store(CompiledProfile, std::memory_order_seq_cst);
+        const IEMidiCompiledProfile* const PublishedProfile = m_PublishedProfile.load(std::memory_order_seq_cst);
+        if (PublishedProfile == CompiledProfile)
+        {
+            return CompiledProfile;
+        }
+        CompiledProfile = PublishedProfile;
+    }
+}
+
+void IEMidiCompiledProfilePublisher::Release(size_t ReaderSlot)
+{
+    IEAssert(ReaderSlot < READER_SLOT_COUNT);
+    m_ReaderSlots[ReaderSlot].store(nullptr, std::memory_order_release);
+}
+
+void IEMidiCompiledProfilePublisher::ReclaimRetiredProfiles()
+{
+    std::erase_if(m_RetiredProfiles, [this](const std::shared_ptr<const IEMidiCompiledProfile>& RetiredProfile)
+        {
+            return std::none_of(m_ReaderSlots.begin(), m_ReaderSlots.end(),
+                [&RetiredProfile](const std::atomic<const IEMidiCompiledProfile*>& ReaderSlot)
+                {
+                    return ReaderSlot.load(std::memory_order_seq_cst) == RetiredProfile.get();
+                });
+        });
+}
\ No newline at end of file
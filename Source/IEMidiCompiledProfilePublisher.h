@@ -0,0 +1,44 @@
+// SPDX-License-Identifier: GPL-2.0-only
+// Copyright © Interactive Echoes. All rights reserved.
+// Author: mozahzah
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "IEMidiCompiledProfile.h"
+
+// Single writer, multi reader publication of compiled profiles. Readers never block or allocate:
+// each reader thread owns a slot in which it announces the snapshot it is using (a hazard pointer),
+// and the writer only frees a replaced snapshot once no slot references it.
+class IEMidiCompiledProfilePublisher
+{
+public:
+    static constexpr size_t READER_SLOT_COUNT = 4;
+
+public:
+    IEMidiCompiledProfilePublisher() = default;
+    IEMidiCompiledProfilePublisher(const IEMidiCompiledProfilePublisher&) = delete;
+    IEMidiCompiledProfilePublisher& operator=(const IEMidiCompiledProfilePublisher&) = delete;
+
+public:
+    // Writer thread only
+    void Publish(std::shared_ptr<const IEMidiCompiledProfile> CompiledProfile);
+
+public:
+    // Each reader thread must use its own slot and release before acquiring again
+    const IEMidiCompiledProfile* Acquire(size_t ReaderSlot);
+    void Release(size_t ReaderSlot);
+
+private:
+    void ReclaimRetiredProfiles();
+
+private:
+    std::atomic<const IEMidiCompiledProfile*> m_PublishedProfile = nullptr;
+    std::array<std::atomic<const IEMidiCompiledProfile*>, READER_SLOT_COUNT> m_ReaderSlots = {};
+    std::shared_ptr<const IEMidiCompiledProfile> m_OwnedProfile;
+    std::vector<std::shared_ptr<const IEMidiCompiledProfile>> m_RetiredProfiles;
+};
\ No newline at end of file
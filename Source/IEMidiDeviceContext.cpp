@@ -0,0 +1,32 @@
+// SPDX-License-Identifier: GPL-2.0-only
+// Copyright © Interactive Echoes. All rights reserved.
+// Author: mozahzah
+
+#include "IEMidiDeviceContext.h"
+
+IEMidiDeviceContext::IEMidiDeviceContext(IEMidiProcessor& _MidiProcessor, uint32_t _QueueIndex, const std::string& MidiDeviceName,
+    uint32_t InputPortNumber, uint32_t OutputPortNumber) :
+    MidiProcessor(_MidiProcessor),
+    QueueIndex(_QueueIndex),
+    MidiDeviceProfile(MidiDeviceName, InputPortNumber, OutputPortNumber),
+    MidiIn(std::make_unique<RtMidiIn>()),
+    MidiOut(std::make_unique<RtMidiOut>())
+{
+    MidiIn->ignoreTypes(false, true, true);
+}
+
+IEMidiDeviceContext::~IEMidiDeviceContext()
+{
+    ClosePorts();
+}
+
+void IEMidiDeviceContext::ClosePorts()
+{
+    if (bArePortsOpen)
+    {
+        MidiIn->cancelCallback();
+        MidiIn->closePort();
+        MidiOut->closePort();
+        bArePortsOpen = false;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,61 @@
+// SPDX-License-Identifier: GPL-2.0-only
+// Copyright © Interactive Echoes. All rights reserved.
+// Author: mozahzah
+
+#pragma once
+
+#include <array>
+#include <memory>
+#include <string>
+
+#include "IEConcurrency.h"
+#include "RtMidi.h"
+
+#include "IEMidiCompiledProfilePublisher.h"
+#include "IEMidiTypes.h"
+
+class IEMidiProcessor;
+
+// Messages waiting for the logger's next refresh, the logger keeps its own history
+static constexpr size_t MIDI_LOG_QUEUE_CAPACITY = 1024;
+static constexpr size_t MIDI_LEARN_QUEUE_CAPACITY = 64;
+static constexpr size_t MAX_LEARNED_CONTROL_COUNT = 128;
+
+// Everything owned by one active midi device. Its RtMidi input thread only touches its own
+// context, and events reach the shared action worker through the context's queue slot.
+struct IEMidiDeviceContext
+{
+public:
+    IEMidiDeviceContext(IEMidiProcessor& _MidiProcessor, uint32_t _QueueIndex, const std::string& MidiDeviceName,
+        uint32_t InputPortNumber, uint32_t OutputPortNumber);
+    IEMidiDeviceContext(const IEMidiDeviceContext&) = delete;
+    IEMidiDeviceContext& operator=(const IEMidiDeviceContext&) = delete;
+    ~IEMidiDeviceContext();
+
+public:
+    // Stops the input thread, afterwards nothing calls back into this context
+    void ClosePorts();
+
+public:
+    IEMidiProcessor& MidiProcessor;
+    const uint32_t QueueIndex;
+
+public:
+    IEMidiDeviceProfile MidiDeviceProfile;
+    IEMidiCompiledProfilePublisher CompiledProfilePublisher;
+    IESPSCQueue<IEMidiLogEntry> MidiLogMessagesBuffer = IESPSCQueue<IEMidiLogEntry>(MIDI_LOG_QUEUE_CAPACITY);
+    IESPSCQueue<IEMidiLearnEvent> MidiLearnEvents = IESPSCQueue<IEMidiLearnEvent>(MIDI_LEARN_QUEUE_CAPACITY);
+
+public:
+    // Controls already learned in the current learn session, only touched by the midi input thread
+    uint32_t LearnSessionID = 0;
+    std::array<uint16_t, MAX_LEARNED_CONTROL_COUNT> LearnedControlKeys = {};
+    uint32_t LearnedControlCount = 0;
+
+public:
+    // Declared last so the ports close before the queues and profile the input thread uses are freed.
+    // RtMidi reports virtual ports as not open, so the context tracks whether it opened any.
+    std::unique_ptr<RtMidiIn> MidiIn;
+    std::unique_ptr<RtMidiOut> MidiOut;
+    bool bArePortsOpen = false;
+};
\ No newline at end of file
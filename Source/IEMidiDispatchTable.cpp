@@ -0,0 +1,106 @@
+// SPDX-License-Identifier: GPL-2.0-only
+// Copyright © Interactive Echoes. All rights reserved.
+// Author: mozahzah
+
+#include "IEMidiDispatchTable.h"
+
+void IEMidiDispatchTable::Build(const IEMidiDeviceProfile& MidiDeviceProfile)
+{
+    Clear();
+
+    // Count entries per bucket, shifted by one so the prefix sum yields each bucket's begin offset
+    size_t EntryCount = 0;
+    for (const IEMidiDeviceInputProperty& MidiDeviceInputProperty : MidiDeviceProfile.InputProperties)
+    {
+        const IEMidiMessage& MidiMessage = MidiDeviceInputProperty.MidiMessage;
+        if (IsValidKey(MidiMessage[0], GetKeyData1(MidiMessage)))
+        {
+            m_BucketOffsets[GetKey(MidiMessage[0], GetKeyData1(MidiMessage)) + 1]++;
+            EntryCount++;
+        }
+    }
+
+    for (uint32_t Key = 0; Key < KEY_COUNT; Key++)
+    {
+        m_BucketOffsets[Key + 1] += m_BucketOffsets[Key];
+    }
+
+    // Fill buckets in profile order so matches keep the same processing order as the property list
+    m_MidiMessageTypes.resize(EntryCount);
+    m_MidiActionTypes.resize(EntryCount);
+    m_MatchFlags.resize(EntryCount);
+    m_PropertyIndices.resize(EntryCount);
+    std::vector<uint32_t> BucketCursors(m_BucketOffsets.begin(), m_BucketOffsets.end() - 1);
+
+    uint32_t PropertyIndex = 0;
+    for (const IEMidiDeviceInputProperty& MidiDeviceInputProperty : MidiDeviceProfile.InputProperties)
+    {
+        const IEMidiMessage& MidiMessage = MidiDeviceInputProperty.MidiMessage;
+        if (IsValidKey(MidiMessage[0], GetKeyData1(MidiMessage)))
+        {
+            const IEMidiMessageType MidiMessageType = MidiDeviceInputProperty.MidiMessageType < IEMidiMessageType::Count ?
+                MidiDeviceInputProperty.MidiMessageType : IEMidiMessageType::None;
+            const IEMidiActionType MidiActionType = MidiDeviceInputProperty.MidiActionType < IEMidiActionType::Count ?
+                MidiDeviceInputProperty.MidiActionType : IEMidiActionType::None;
+
+            // Options that do not apply to the message type are dropped here instead of checked per message
+            const bool bIsMidiToggle = MidiDeviceInputProperty.bIsMidiToggle && IsTriggerMidiMessageType(MidiMessageType);
+            const bool bIsCoalesced = MidiDeviceInputProperty.bIsCoalesced && IsContinuousMidiMessageType(MidiMessageType);
+
+            const uint32_t EntryIndex = BucketCursors[GetKey(MidiMessage[0], GetKeyData1(MidiMessage))]++;
+            m_MidiMessageTypes[EntryIndex] = MidiMessageType;
+            m_MidiActionTypes[EntryIndex] = MidiActionType;
+            m_MatchFlags[EntryIndex] = (bIsMidiToggle ? MATCH_FLAG_MIDI_TOGGLE : 0) | (bIsCoalesced ? MATCH_FLAG_COALESCED : 0);
+            m_PropertyIndices[EntryIndex] = PropertyIndex;
+        }
+        PropertyIndex++;
+    }
+}
+
+void IEMidiDispatchTable::Clear()
+{
+    m_BucketOffsets.fill(0);
+    m_MidiMessageTypes.clear();
+    m_MidiActionTypes.clear();
+    m_MatchFlags.clear();
+    m_PropertyIndices.clear();
+}
+
+IEMidiMatchRange IEMidiDispatchTable::Find(const IEMidiMessage& MidiMessage) const
+{
+    const uint8_t Status = MidiMessage[0];
+    const uint8_t Data1 = GetKeyData1(MidiMessage);
+    if (IsValidKey(Status, Data1))
+    {
+        const uint32_t Key = GetKey(Status, Data1);
+        return IEMidiMatchRange{m_BucketOffsets[Key], m_BucketOffsets[Key + 1]};
+    }
+    return IEMidiMatchRange();
+}
+
+IEMidiInputMatch IEMidiDispatchTable::GetMatch(uint32_t EntryIndex) const
+{
+    IEMidiInputMatch InputMatch;
+    InputMatch.MidiMessageType = m_MidiMessageTypes[EntryIndex];
+    InputMatch.MidiActionType = m_MidiActionTypes[EntryIndex];
+    InputMatch.bIsMidiToggle = (m_MatchFlags[EntryIndex] & MATCH_FLAG_MIDI_TOGGLE) != 0;
+    InputMatch.bIsCoalesced = (m_MatchFlags[EntryIndex] & MATCH_FLAG_COALESCED) != 0;
+    InputMatch.PropertyIndex = m_PropertyIndices[EntryIndex];
+    return InputMatch;
+}
+
+bool IEMidiDispatchTable::IsValidKey(uint8_t Status, uint8_t Data1)
+{
+    return Status >= 0x80 && Data1 < 0x80;
+}
+
+uint32_t IEMidiDispatchTable::GetKey(uint8_t Status, uint8_t Data1)
+{
+    return (static_cast<uint32_t>(Status - 0x80) << 7) | Data1;
+}
+
+uint8_t IEMidiDispatchTable::GetKeyData1(const IEMidiMessage& MidiMessage)
+{
+    // Channel aftertouch carries its value in data 1, so it is keyed on the status byte alone
+    return (MidiMessage[0] & 0xF0) == 0xD0 ? 0 : MidiMessage[1];
+}
@@ -0,0 +1,64 @@
+// SPDX-License-Identifier: GPL-2.0-only
+// Copyright © Interactive Echoes. All rights reserved.
+// Author: mozahzah
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "IEMidiTypes.h"
+
+// Hot fields of one matched input property, everything else lives in the cold
+// IEMidiCompiledInputProperty at PropertyIndex
+struct IEMidiInputMatch
+{
+    IEMidiMessageType MidiMessageType = IEMidiMessageType::None;
+    IEMidiActionType MidiActionType = IEMidiActionType::None;
+    bool bIsMidiToggle = false;
+    bool bIsCoalesced = false;
+    uint32_t PropertyIndex = 0;
+};
+
+struct IEMidiMatchRange
+{
+    uint32_t Begin = 0;
+    uint32_t End = 0;
+
+    bool IsEmpty() const { return Begin == End; }
+};
+
+// Input properties bucketed by (status byte, data 1) so an incoming message resolves to its
+// matching entries with a single indexed lookup. Entries only keep the fields needed to pick and
+// run an action, one densely packed array per field, so a lookup touches a few cache lines however
+// long the commands and paths of the profile are.
+class IEMidiDispatchTable
+{
+public:
+    void Build(const IEMidiDeviceProfile& MidiDeviceProfile);
+    void Clear();
+
+public:
+    IEMidiMatchRange Find(const IEMidiMessage& MidiMessage) const;
+    IEMidiInputMatch GetMatch(uint32_t EntryIndex) const;
+    size_t GetEntryCount() const { return m_PropertyIndices.size(); }
+
+private:
+    static bool IsValidKey(uint8_t Status, uint8_t Data1);
+    static uint32_t GetKey(uint8_t Status, uint8_t Data1);
+    static uint8_t GetKeyData1(const IEMidiMessage& MidiMessage);
+
+private:
+    // Status bytes are 0x80-0xFF and data bytes 0x00-0x7F
+    static constexpr uint32_t KEY_COUNT = 128 * 128;
+    static constexpr uint8_t MATCH_FLAG_MIDI_TOGGLE = 1 << 0;
+    static constexpr uint8_t MATCH_FLAG_COALESCED = 1 << 1;
+
+private:
+    std::array<uint32_t, KEY_COUNT + 1> m_BucketOffsets = {};
+    std::vector<IEMidiMessageType> m_MidiMessageTypes;
+    std::vector<IEMidiActionType> m_MidiActionTypes;
+    std::vector<uint8_t> m_MatchFlags;
+    std::vector<uint32_t> m_PropertyIndices;
+};
\ No newline at end of file
@@ -0,0 +1,45 @@
+// SPDX-License-Identifier: GPL-2.0-only
+// Copyright © Interactive Echoes. All rights reserved.
+// Author: mozahzah
+
+#include "IEMidiFrameNotifier.h"
+
+IEMidiFrameNotifier::IEMidiFrameNotifier(std::chrono::milliseconds FrameInterval, QObject* Parent) :
+    QObject(Parent),
+    m_FrameInterval(FrameInterval),
+    m_FrameTimer(new QTimer(this))
+{
+    m_FrameTimer->setSingleShot(true);
+    m_FrameTimer->setTimerType(Qt::PreciseTimer);
+    connect(m_FrameTimer, &QTimer::timeout, this, &IEMidiFrameNotifier::EmitFrame);
+}
+
+void IEMidiFrameNotifier::Notify()
+{
+    if (!m_bIsDirty.exchange(true, std::memory_order_acq_rel))
+    {
+        QMetaObject::invokeMethod(this, &IEMidiFrameNotifier::ScheduleFrame, Qt::QueuedConnection);
+    }
+}
+
+void IEMidiFrameNotifier::ScheduleFrame()
+{
+    const std::chrono::steady_clock::duration Elapsed = std::chrono::steady_clock::now() - m_LastFrameTime;
+    if (Elapsed >= m_FrameInterval)
+    {
+        EmitFrame();
+    }
+    else if (!m_FrameTimer->isActive())
+    {
+        m_FrameTimer->start(std::chrono::ceil<std::chrono::milliseconds>(m_FrameInterval - Elapsed));
+    }
+}
+
+void IEMidiFrameNotifier::EmitFrame()
+{
+    m_LastFrameTime = std::chrono::steady_clock::now();
+
+    // Cleared first so a notification arriving during the frame schedules the next one
+    m_bIsDirty.store(false, std::memory_order_release);
+    emit OnFrame();
+}
\ No newline at end of file
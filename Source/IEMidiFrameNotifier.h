@@ -0,0 +1,39 @@
+// SPDX-License-Identifier: GPL-2.0-only
+// Copyright © Interactive Echoes. All rights reserved.
+// Author: mozahzah
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+
+#include "qobject.h"
+#include "qtimer.h"
+
+// Turns notifications from any thread into at most one OnFrame per frame interval on the thread
+// the notifier lives on. Only the first notification after a frame posts to the event loop, the
+// others just find the dirty flag already set.
+class IEMidiFrameNotifier : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit IEMidiFrameNotifier(std::chrono::milliseconds FrameInterval = std::chrono::milliseconds(16), QObject* Parent = nullptr);
+
+public:
+    // Thread safe and allocation free unless it is the first call since the last frame
+    void Notify();
+
+Q_SIGNALS:
+    void OnFrame() const;
+
+private Q_SLOTS:
+    void ScheduleFrame();
+    void EmitFrame();
+
+private:
+    const std::chrono::milliseconds m_FrameInterval;
+    std::atomic<bool> m_bIsDirty = false;
+    std::chrono::steady_clock::time_point m_LastFrameTime;
+    QTimer* m_FrameTimer;
+};
\ No newline at end of file
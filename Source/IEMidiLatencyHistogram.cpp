@@ -0,0 +1,101 @@
+// SPDX-License-Identifier: GPL-2.0-only
+// Copyright © Interactive Echoes. All rights reserved.
+// Author: mozahzah
+
+#include "IEMidiLatencyHistogram.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+std::chrono::nanoseconds IEMidiLatencySnapshot::GetPercentile(double Percentile) const
+{
+    if (Count > 0)
+    {
+        const double ClampedPercentile = std::clamp(Percentile, 0.0, 100.0);
+        const uint64_t TargetCount = std::max<uint64_t>(static_cast<uint64_t>(std::ceil(ClampedPercentile / 100.0 * Count)), 1);
+
+        uint64_t CumulativeCount = 0;
+        for (uint32_t BucketIndex = 0; BucketIndex < LATENCY_HISTOGRAM_BUCKET_COUNT; BucketIndex++)
+        {
+            CumulativeCount += BucketCounts[BucketIndex];
+            if (CumulativeCount >= TargetCount)
+            {
+                const uint64_t UpperBound = IEMidiLatencyHistogram::GetBucketUpperBound(BucketIndex);
+                return std::chrono::nanoseconds(std::min(UpperBound, MaxNanoseconds));
+            }
+        }
+    }
+    return GetMax();
+}
+
+std::chrono::nanoseconds IEMidiLatencySnapshot::GetMean() const
+{
+    return std::chrono::nanoseconds(Count > 0 ? TotalNanoseconds / Count : 0);
+}
+
+void IEMidiLatencyHistogram::Record(std::chrono::steady_clock::duration Latency)
+{
+    const int64_t SignedNanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(Latency).count();
+    const uint64_t Nanoseconds = SignedNanoseconds > 0 ? static_cast<uint64_t>(SignedNanoseconds) : 0;
+
+    m_BucketCounts[GetBucketIndex(Nanoseconds)].fetch_add(1, std::memory_order_relaxed);
+    m_Count.fetch_add(1, std::memory_order_relaxed);
+    m_TotalNanoseconds.fetch_add(Nanoseconds, std::memory_order_relaxed);
+
+    uint64_t MaxNanoseconds = m_MaxNanoseconds.load(std::memory_order_relaxed);
+    while (Nanoseconds > MaxNanoseconds &&
+        !m_MaxNanoseconds.compare_exchange_weak(MaxNanoseconds, Nanoseconds, std::memory_order_relaxed))
+    {
+    }
+}
+
+void IEMidiLatencyHistogram::Reset()
+{
+    for (std::atomic<uint64_t>& BucketCount : m_BucketCounts)
+    {
+        BucketCount.store(0, std::memory_order_relaxed);
+    }
+    m_Count.store(0, std::memory_order_relaxed);
+    m_TotalNanoseconds.store(0, std::memory_order_relaxed);
+    m_MaxNanoseconds.store(0, std::memory_order_relaxed);
+}
+
+IEMidiLatencySnapshot IEMidiLatencyHistogram::GetSnapshot() const
+{
+    // Buckets are summed rather than reading m_Count so percentiles stay consistent with a racing recorder
+    IEMidiLatencySnapshot Snapshot;
+    for (uint32_t BucketIndex = 0; BucketIndex < LATENCY_HISTOGRAM_BUCKET_COUNT; BucketIndex++)
+    {
+        Snapshot.BucketCounts[BucketIndex] = m_BucketCounts[BucketIndex].load(std::memory_order_relaxed);
+        Snapshot.Count += Snapshot.BucketCounts[BucketIndex];
+    }
+    Snapshot.TotalNanoseconds = m_TotalNanoseconds.load(std::memory_order_relaxed);
+    Snapshot.MaxNanoseconds = m_MaxNanoseconds.load(std::memory_order_relaxed);
+    return Snapshot;
+}
+
+uint32_t IEMidiLatencyHistogram::GetBucketIndex(uint64_t Nanoseconds)
+{
+    // Values below the sub bucket count are exact, above they keep their top LATENCY_HISTOGRAM_SUB_BUCKET_BITS bits
+    const uint32_t BitWidth = static_cast<uint32_t>(std::bit_width(Nanoseconds));
+    if (BitWidth <= LATENCY_HISTOGRAM_SUB_BUCKET_BITS)
+    {
+        return static_cast<uint32_t>(Nanoseconds);
+    }
+    const uint32_t Magnitude = BitWidth - LATENCY_HISTOGRAM_SUB_BUCKET_BITS;
+    const uint32_t SubBucket = static_cast<uint32_t>(Nanoseconds >> (Magnitude - 1)) - LATENCY_HISTOGRAM_SUB_BUCKET_COUNT;
+    return Magnitude * LATENCY_HISTOGRAM_SUB_BUCKET_COUNT + SubBucket;
+}
+
+uint64_t IEMidiLatencyHistogram::GetBucketUpperBound(uint32_t BucketIndex)
+{
+    const uint32_t Magnitude = BucketIndex / LATENCY_HISTOGRAM_SUB_BUCKET_COUNT;
+    const uint64_t SubBucket = BucketIndex % LATENCY_HISTOGRAM_SUB_BUCKET_COUNT;
+    if (Magnitude == 0)
+    {
+        return SubBucket;
+    }
+    const uint64_t LowerBound = (LATENCY_HISTOGRAM_SUB_BUCKET_COUNT + SubBucket) << (Magnitude - 1);
+    return LowerBound + ((uint64_t(1) << (Magnitude - 1)) - 1);
+}
\ No newline at end of file
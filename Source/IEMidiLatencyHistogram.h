@@ -0,0 +1,60 @@
+// SPDX-License-Identifier: GPL-2.0-only
+// Copyright © Interactive Echoes. All rights reserved.
+// Author: mozahzah
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+// Latencies are measured from the steady clock reading taken on entry to the RtMidi callback
+enum class IEMidiLatencyStage : uint8_t
+{
+    Callback,   // Until the event is handed to the action worker
+    Dispatch,   // Until the action worker has resolved the event to its mappings
+    Completion, // Until the action returns, including any coalescing delay
+
+    Count,
+};
+
+static constexpr uint32_t LATENCY_HISTOGRAM_SUB_BUCKET_BITS = 4;
+static constexpr uint32_t LATENCY_HISTOGRAM_SUB_BUCKET_COUNT = 1 << LATENCY_HISTOGRAM_SUB_BUCKET_BITS;
+static constexpr uint32_t LATENCY_HISTOGRAM_MAGNITUDE_COUNT = 64 - LATENCY_HISTOGRAM_SUB_BUCKET_BITS + 1;
+static constexpr uint32_t LATENCY_HISTOGRAM_BUCKET_COUNT = LATENCY_HISTOGRAM_MAGNITUDE_COUNT * LATENCY_HISTOGRAM_SUB_BUCKET_COUNT;
+
+struct IEMidiLatencySnapshot
+{
+public:
+    std::chrono::nanoseconds GetPercentile(double Percentile) const;
+    std::chrono::nanoseconds GetMax() const { return std::chrono::nanoseconds(MaxNanoseconds); }
+    std::chrono::nanoseconds GetMean() const;
+
+public:
+    std::array<uint64_t, LATENCY_HISTOGRAM_BUCKET_COUNT> BucketCounts = {};
+    uint64_t Count = 0;
+    uint64_t TotalNanoseconds = 0;
+    uint64_t MaxNanoseconds = 0;
+};
+
+// HDR-style log-linear histogram of nanosecond latencies. Every power of two is split into
+// LATENCY_HISTOGRAM_SUB_BUCKET_COUNT linear buckets, bounding the relative error to ~6%.
+// Recording is wait-free apart from the max update and may run concurrently with snapshots.
+class IEMidiLatencyHistogram
+{
+public:
+    void Record(std::chrono::steady_clock::duration Latency);
+    void Reset();
+    IEMidiLatencySnapshot GetSnapshot() const;
+
+public:
+    static uint32_t GetBucketIndex(uint64_t Nanoseconds);
+    static uint64_t GetBucketUpperBound(uint32_t BucketIndex);
+
+private:
+    std::array<std::atomic<uint64_t>, LATENCY_HISTOGRAM_BUCKET_COUNT> m_BucketCounts = {};
+    std::atomic<uint64_t> m_Count = 0;
+    std::atomic<uint64_t> m_TotalNanoseconds = 0;
+    std::atomic<uint64_t> m_MaxNanoseconds = 0;
+};
\ No newline at end of file
@@ -0,0 +1,20 @@
+// SPDX-License-Identifier: GPL-2.0-only
+// Copyright © Interactive Echoes. All rights reserved.
+// Author: mozahzah
+
+#include "IEMidiLearnDispatcher.h"
+
+#include "IEMidiProcessor.h"
+
+IEMidiLearnDispatcher::IEMidiLearnDispatcher(IEMidiProcessor& MidiProcessor, QObject* Parent) :
+    QObject(Parent),
+    m_MidiProcessor(MidiProcessor)
+{}
+
+void IEMidiLearnDispatcher::DispatchMidiLearnEvents() const
+{
+    m_MidiProcessor.ConsumeMidiLearnEvents([this](IEMidiDeviceInputProperty& MidiDeviceInputProperty)
+        {
+            emit OnMidiMessageLearned(&MidiDeviceInputProperty.MidiDeviceProfile, MidiDeviceInputProperty.GetHandle());
+        });
+}
\ No newline at end of file
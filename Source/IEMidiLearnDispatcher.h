@@ -0,0 +1,30 @@
+// SPDX-License-Identifier: GPL-2.0-only
+// Copyright © Interactive Echoes. All rights reserved.
+// Author: mozahzah
+
+#pragma once
+
+#include "qobject.h"
+
+#include "IEMidiTypes.h"
+
+class IEMidiProcessor;
+
+// Hands the messages the processor learned to the editors on the UI thread, one signal per
+// learned property so only the matching editor refreshes.
+class IEMidiLearnDispatcher : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit IEMidiLearnDispatcher(IEMidiProcessor& MidiProcessor, QObject* Parent = nullptr);
+
+public:
+    void DispatchMidiLearnEvents() const;
+
+Q_SIGNALS:
+    void OnMidiMessageLearned(const IEMidiDeviceProfile* MidiDeviceProfile, IEMidiSlotHandle MidiDeviceInputPropertyHandle) const;
+
+private:
+    IEMidiProcessor& m_MidiProcessor;
+};
\ No newline at end of file
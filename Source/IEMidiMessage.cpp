@@ -0,0 +1,236 @@
+// SPDX-License-Identifier: GPL-2.0-only
+// Copyright © Interactive Echoes. All rights reserved.
+// Author: mozahzah
+
+#include "IEMidiMessage.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <vector>
+
+// Shared between copies the same way a pool slot is, the last one to let go frees it
+struct IEMidiSysExHeapBlock
+{
+    std::atomic<uint32_t> RefCount = 1;
+    std::vector<uint8_t> Bytes;
+};
+
+IEMidiSysExPool& IEMidiSysExPool::Get()
+{
+    static IEMidiSysExPool SysExPool;
+    return SysExPool;
+}
+
+int16_t IEMidiSysExPool::Acquire(const uint8_t* Data, size_t Size)
+{
+    uint64_t FreeSlotMask = m_FreeSlotMask.load(std::memory_order_relaxed);
+    while (FreeSlotMask)
+    {
+        const int Slot = std::countr_zero(FreeSlotMask);
+        const uint64_t SlotBit = uint64_t(1) << Slot;
+        if (m_FreeSlotMask.compare_exchange_weak(FreeSlotMask, FreeSlotMask & ~SlotBit, std::memory_order_acquire, std::memory_order_relaxed))
+        {
+            std::memcpy(m_Slots[Slot].data(), Data, std::min(Size, MIDI_SYSEX_POOL_SLOT_BYTE_COUNT));
+            m_RefCounts[Slot].store(1, std::memory_order_relaxed);
+            return static_cast<int16_t>(Slot);
+        }
+    }
+    return -1;
+}
+
+void IEMidiSysExPool::AddRef(int16_t Slot)
+{
+    m_RefCounts[Slot].fetch_add(1, std::memory_order_relaxed);
+}
+
+void IEMidiSysExPool::Release(int16_t Slot)
+{
+    if (m_RefCounts[Slot].fetch_sub(1, std::memory_order_acq_rel) == 1)
+    {
+        m_FreeSlotMask.fetch_or(uint64_t(1) << Slot, std::memory_order_release);
+    }
+}
+
+IEMidiMessage::IEMidiMessage(const uint8_t* Data, size_t Size)
+{
+    if (Data && Size)
+    {
+        if (Size <= MIDI_MESSAGE_BYTE_COUNT)
+        {
+            std::copy(Data, Data + Size, m_InlineBytes.begin());
+            m_Size = static_cast<uint16_t>(Size);
+        }
+        else
+        {
+            std::copy(Data, Data + MIDI_MESSAGE_BYTE_COUNT, m_InlineBytes.begin());
+            m_Size = static_cast<uint16_t>(std::min(Size, MIDI_SYSEX_POOL_SLOT_BYTE_COUNT));
+            m_bIsTruncated = Size > MIDI_SYSEX_POOL_SLOT_BYTE_COUNT;
+            m_SysExSlot = IEMidiSysExPool::Get().Acquire(Data, Size);
+            if (m_SysExSlot < 0)
+            {
+                // Every slot is held by queued copies, only then does the input thread allocate
+                m_SysExHeapBlock = new IEMidiSysExHeapBlock();
+                m_SysExHeapBlock->Bytes.assign(Data, Data + m_Size);
+            }
+        }
+    }
+}
+
+IEMidiMessage::IEMidiMessage(std::initializer_list<uint8_t> Bytes) :
+    IEMidiMessage(Bytes.begin(), Bytes.size())
+{}
+
+IEMidiMessage::IEMidiMessage(const IEMidiMessage& Other) :
+    m_InlineBytes(Other.m_InlineBytes),
+    m_Size(Other.m_Size),
+    m_SysExSlot(Other.m_SysExSlot),
+    m_bIsTruncated(Other.m_bIsTruncated),
+    m_SysExHeapBlock(Other.m_SysExHeapBlock)
+{
+    if (m_SysExSlot >= 0)
+    {
+        IEMidiSysExPool::Get().AddRef(m_SysExSlot);
+    }
+    if (m_SysExHeapBlock)
+    {
+        m_SysExHeapBlock->RefCount.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+IEMidiMessage::IEMidiMessage(IEMidiMessage&& Other) noexcept :
+    m_InlineBytes(Other.m_InlineBytes),
+    m_Size(Other.m_Size),
+    m_SysExSlot(Other.m_SysExSlot),
+    m_bIsTruncated(Other.m_bIsTruncated),
+    m_SysExHeapBlock(Other.m_SysExHeapBlock)
+{
+    Other.m_SysExSlot = -1;
+    Other.m_SysExHeapBlock = nullptr;
+    Other.Reset();
+}
+
+IEMidiMessage& IEMidiMessage::operator=(const IEMidiMessage& Other)
+{
+    if (this != &Other)
+    {
+        if (Other.m_SysExSlot >= 0)
+        {
+            IEMidiSysExPool::Get().AddRef(Other.m_SysExSlot);
+        }
+        if (Other.m_SysExHeapBlock)
+        {
+            Other.m_SysExHeapBlock->RefCount.fetch_add(1, std::memory_order_relaxed);
+        }
+        Reset();
+        m_InlineBytes = Other.m_InlineBytes;
+        m_Size = Other.m_Size;
+        m_SysExSlot = Other.m_SysExSlot;
+        m_bIsTruncated = Other.m_bIsTruncated;
+        m_SysExHeapBlock = Other.m_SysExHeapBlock;
+    }
+    return *this;
+}
+
+IEMidiMessage& IEMidiMessage::operator=(IEMidiMessage&& Other) noexcept
+{
+    if (this != &Other)
+    {
+        Reset();
+        m_InlineBytes = Other.m_InlineBytes;
+        m_Size = Other.m_Size;
+        m_SysExSlot = Other.m_SysExSlot;
+        m_bIsTruncated = Other.m_bIsTruncated;
+        m_SysExHeapBlock = Other.m_SysExHeapBlock;
+        Other.m_SysExSlot = -1;
+        Other.m_SysExHeapBlock = nullptr;
+        Other.Reset();
+    }
+    return *this;
+}
+
+IEMidiMessage::~IEMidiMessage()
+{
+    Reset();
+}
+
+const uint8_t* IEMidiMessage::data() const
+{
+    if (m_SysExSlot >= 0)
+    {
+        return IEMidiSysExPool::Get().GetData(m_SysExSlot);
+    }
+    return m_SysExHeapBlock ? m_SysExHeapBlock->Bytes.data() : m_InlineBytes.data();
+}
+
+bool IEMidiMessage::operator==(const IEMidiMessage& Other) const
+{
+    return m_Size == Other.m_Size && std::equal(data(), data() + m_Size, Other.data());
+}
+
+size_t IEMidiMessage::GetExpectedSize(uint8_t Status)
+{
+    if (Status < 0x80)
+    {
+        // Not a status byte, keep the legacy 3 byte layout
+        return MIDI_MESSAGE_BYTE_COUNT;
+    }
+
+    switch (Status & 0xF0)
+    {
+        case 0xC0:
+        case 0xD0:
+        {
+            return 2;
+        }
+        case 0xF0:
+        {
+            break;
+        }
+        default:
+        {
+            return 3;
+        }
+    }
+
+    switch (Status)
+    {
+        case 0xF0:
+        {
+            return 0;
+        }
+        case 0xF1:
+        case 0xF3:
+        {
+            return 2;
+        }
+        case 0xF2:
+        {
+            return 3;
+        }
+        default:
+        {
+            return 1;
+        }
+    }
+}
+
+void IEMidiMessage::Reset()
+{
+    if (m_SysExSlot >= 0)
+    {
+        IEMidiSysExPool::Get().Release(m_SysExSlot);
+        m_SysExSlot = -1;
+    }
+    if (m_SysExHeapBlock)
+    {
+        if (m_SysExHeapBlock->RefCount.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        {
+            delete m_SysExHeapBlock;
+        }
+        m_SysExHeapBlock = nullptr;
+    }
+    m_InlineBytes = {0, 0, 0};
+    m_Size = 0;
+    m_bIsTruncated = false;
+}
@@ -0,0 +1,81 @@
+// SPDX-License-Identifier: GPL-2.0-only
+// Copyright © Interactive Echoes. All rights reserved.
+// Author: mozahzah
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+
+static constexpr size_t MIDI_MESSAGE_BYTE_COUNT = 3;
+static constexpr size_t MIDI_SYSEX_POOL_SLOT_COUNT = 64;
+static constexpr size_t MIDI_SYSEX_POOL_SLOT_BYTE_COUNT = 1024;
+
+// Fixed pool of SysEx buffers shared by every IEMidiMessage. Slots are reference counted
+// and acquired/released lock-free so the midi input thread does not allocate while one is free.
+class IEMidiSysExPool
+{
+public:
+    static IEMidiSysExPool& Get();
+
+public:
+    int16_t Acquire(const uint8_t* Data, size_t Size);
+    void AddRef(int16_t Slot);
+    void Release(int16_t Slot);
+    const uint8_t* GetData(int16_t Slot) const { return m_Slots[Slot].data(); }
+
+private:
+    IEMidiSysExPool() = default;
+
+private:
+    std::atomic<uint64_t> m_FreeSlotMask = ~uint64_t(0);
+    std::array<std::atomic<uint32_t>, MIDI_SYSEX_POOL_SLOT_COUNT> m_RefCounts = {};
+    std::array<std::array<uint8_t, MIDI_SYSEX_POOL_SLOT_BYTE_COUNT>, MIDI_SYSEX_POOL_SLOT_COUNT> m_Slots = {};
+    static_assert(MIDI_SYSEX_POOL_SLOT_COUNT <= 64);
+};
+
+struct IEMidiSysExHeapBlock;
+
+// Midi message of any length. Channel, system common and realtime messages are stored inline,
+// SysEx payloads live in an IEMidiSysExPool slot, or on the heap once every slot is held.
+class IEMidiMessage
+{
+public:
+    IEMidiMessage() = default;
+    IEMidiMessage(const uint8_t* Data, size_t Size);
+    IEMidiMessage(std::initializer_list<uint8_t> Bytes);
+    IEMidiMessage(const IEMidiMessage& Other);
+    IEMidiMessage(IEMidiMessage&& Other) noexcept;
+    IEMidiMessage& operator=(const IEMidiMessage& Other);
+    IEMidiMessage& operator=(IEMidiMessage&& Other) noexcept;
+    ~IEMidiMessage();
+
+public:
+    const uint8_t* data() const;
+    size_t size() const { return m_Size; }
+    bool empty() const { return m_Size == 0; }
+    uint8_t operator[](size_t Index) const { return Index < m_Size ? data()[Index] : 0; }
+    bool operator==(const IEMidiMessage& Other) const;
+
+public:
+    uint8_t GetStatus() const { return (*this)[0]; }
+    bool IsSysEx() const { return GetStatus() == 0xF0; }
+    bool IsTruncated() const { return m_bIsTruncated; }
+
+public:
+    // Returns the byte count implied by the status byte, 0 for variable length SysEx
+    static size_t GetExpectedSize(uint8_t Status);
+
+private:
+    void Reset();
+
+private:
+    std::array<uint8_t, MIDI_MESSAGE_BYTE_COUNT> m_InlineBytes = {0, 0, 0};
+    uint16_t m_Size = 0;
+    int16_t m_SysExSlot = -1;
+    bool m_bIsTruncated = false;
+    IEMidiSysExHeapBlock* m_SysExHeapBlock = nullptr;
+};
@@ -4,155 +4,357 @@
 
 #include "IEMidiProcessor.h"
 
-IEResult IEMidiProcessor::ProcessMidiInputMessage(const std::array<uint8_t, MIDI_MESSAGE_BYTE_COUNT>& MidiMessage) const
+IEMidiProcessor::~IEMidiProcessor()
+{
+    DeactivateAllMidiDeviceProfiles();
+}
+
+IEResult IEMidiProcessor::ProcessMidiInputMessage(const IEMidiCompiledProfile& CompiledProfile, const IEMidiInputEvent& MidiInputEvent)
 {
     IEResult Result(IEResult::Type::Fail, "Failed to process Midi");
 
-    if (IEAssert(MidiMessage.size() >= 3))
+    const IEMidiMessage& MidiMessage = MidiInputEvent.MidiMessage;
+    if (!MidiMessage.empty())
     {
-        if (m_ActiveMidiDeviceProfile.has_value())
+        const IEMidiMatchRange MatchRange = CompiledProfile.Find(MidiMessage);
+        const std::chrono::steady_clock::time_point Now = std::chrono::steady_clock::now();
+        if (MatchRange.IsEmpty())
+        {
+            RecordLatency(IEMidiActionType::None, IEMidiLatencyStage::Callback, MidiInputEvent.ReceivedTime, MidiInputEvent.EnqueuedTime);
+            RecordLatency(IEMidiActionType::None, IEMidiLatencyStage::Dispatch, MidiInputEvent.ReceivedTime, Now);
+            RecordLatency(IEMidiActionType::None, IEMidiLatencyStage::Completion, MidiInputEvent.ReceivedTime, Now);
+        }
+
+        for (uint32_t EntryIndex = MatchRange.Begin; EntryIndex < MatchRange.End; EntryIndex++)
         {
-            IEMidiDeviceInputProperty* ActiveMidiDeviceInputProperty = m_ActiveMidiDeviceProfile->InputPropertiesHead.get();
-            while (ActiveMidiDeviceInputProperty)
+            const IEMidiInputMatch InputMatch = CompiledProfile.GetMatch(EntryIndex);
+            RecordLatency(InputMatch.MidiActionType, IEMidiLatencyStage::Callback, MidiInputEvent.ReceivedTime, MidiInputEvent.EnqueuedTime);
+            RecordLatency(InputMatch.MidiActionType, IEMidiLatencyStage::Dispatch, MidiInputEvent.ReceivedTime, Now);
+
+            if (InputMatch.bIsCoalesced)
             {
-                if (ActiveMidiDeviceInputProperty->MidiMessage.size() >= 3 &&
-                    ActiveMidiDeviceInputProperty->MidiMessage[0] == MidiMessage[0] &&
-                    ActiveMidiDeviceInputProperty->MidiMessage[1] == MidiMessage[1])
+                CoalesceMidiInputProperty(CompiledProfile, InputMatch, MidiInputEvent, Now);
+                Result.Type = IEResult::Type::Success;
+            }
+            else
+            {
+                if (ExecuteMidiInputProperty(CompiledProfile, InputMatch, MidiMessage))
                 {
-                    switch (ActiveMidiDeviceInputProperty->MidiActionType)
-                    {
-                        case IEMidiActionType::Volume:
-                        {
-                            if (m_VolumeAction)
-                            {
-                                Result.Type = IEResult::Type::Success;
+                    Result.Type = IEResult::Type::Success;
+                }
+                RecordLatency(InputMatch.MidiActionType, IEMidiLatencyStage::Completion, MidiInputEvent.ReceivedTime, std::chrono::steady_clock::now());
+            }
+        }
+    }
+    if (Result.Type == IEResult::Type::Success)
+    {
+        Result.Message = std::string("Successfully processed Midi");
+    }
+    return Result;
+}
 
-                                const float Value = static_cast<float>(MidiMessage[2]);
-                                m_VolumeAction->SetVolume(Value/127.0f);
-                            }
-                            break;
-                        }
-                        case IEMidiActionType::Mute:
-                        {
-                            if (m_MuteAction)
-                            {
-                                Result.Type = IEResult::Type::Success;
-
-                                if (ActiveMidiDeviceInputProperty->MidiMessageType == IEMidiMessageType::NoteOnOff)
-                                {
-                                    if (ActiveMidiDeviceInputProperty->bIsMidiToggle)
-                                    {
-                                        const bool bOn = static_cast<unsigned int>(MidiMessage[2]) != 0;
-                                        if (bOn)
-                                        {
-                                            if (m_MuteAction->GetMute())
-                                            {
-                                                m_MuteAction->SetMute(false);
-                                            }
-                                            else
-                                            {
-                                                m_MuteAction->SetMute(true);
-                                            }
-                                        }
-                                    }
-                                    else
-                                    {
-                                        const bool bMute = static_cast<bool>(MidiMessage[2]);
-                                        m_MuteAction->SetMute(bMute);
-                                    }
-                                }
-                            }
-                            break;
-                        }
-                        case IEMidiActionType::ConsoleCommand:
+bool IEMidiProcessor::ExecuteMidiInputProperty(const IEMidiCompiledProfile& CompiledProfile, const IEMidiInputMatch& InputMatch, const IEMidiMessage& MidiMessage) const
+{
+    bool bIsExecuted = false;
+    const uint8_t MidiValue = GetMidiMessageValue(MidiMessage);
+
+    switch (InputMatch.MidiActionType)
+    {
+        case IEMidiActionType::Volume:
+        {
+            if (m_bIsActionSupported[static_cast<size_t>(IEMidiActionType::Volume)])
+            {
+                bIsExecuted = true;
+
+                const float Value = static_cast<float>(MidiValue);
+                m_ActionBackend->SetVolume(Value/127.0f);
+            }
+            break;
+        }
+        case IEMidiActionType::Mute:
+        {
+            if (m_bIsActionSupported[static_cast<size_t>(IEMidiActionType::Mute)])
+            {
+                bIsExecuted = true;
+
+                if (IsTriggerMidiMessageType(InputMatch.MidiMessageType))
+                {
+                    if (InputMatch.bIsMidiToggle)
+                    {
+                        const bool bOn = MidiValue != 0;
+                        if (bOn)
                         {
-                            if (m_ConsoleCommandAction)
-                            {
-                                Result.Type = IEResult::Type::Success;
-
-                                switch (ActiveMidiDeviceInputProperty->MidiMessageType)
-                                {
-                                    case IEMidiMessageType::NoteOnOff:
-                                    {
-                                        if (ActiveMidiDeviceInputProperty->bIsMidiToggle)
-                                        {
-                                            const bool bOn = static_cast<unsigned int>(MidiMessage[2]) != 0;
-                                            if (bOn)
-                                            {
-                                                if (ActiveMidiDeviceInputProperty->bIsConsoleCommandActive)
-                                                {
-                                                    m_ConsoleCommandAction->ExecuteConsoleCommand(ActiveMidiDeviceInputProperty->ConsoleCommand, 0.0f);
-                                                    ActiveMidiDeviceInputProperty->bIsConsoleCommandActive = false;
-                                                }
-                                                else
-                                                {
-                                                    m_ConsoleCommandAction->ExecuteConsoleCommand(ActiveMidiDeviceInputProperty->ConsoleCommand, 1.0f);
-                                                    ActiveMidiDeviceInputProperty->bIsConsoleCommandActive = true;
-                                                }
-                                            }
-                                        }
-                                        else
-                                        {
-                                            m_ConsoleCommandAction->ExecuteConsoleCommand(ActiveMidiDeviceInputProperty->ConsoleCommand, 1.0f);
-                                        }
-                                        break;
-                                    }
-                                    case IEMidiMessageType::ControlChange:
-                                    {
-                                        const float Value = static_cast<float>(MidiMessage[2]);
-                                        m_ConsoleCommandAction->ExecuteConsoleCommand(ActiveMidiDeviceInputProperty->ConsoleCommand, Value);
-                                        break;
-                                    }
-                                    default:
-                                    {
-                                        break;
-                                    }
-                                }
-                            }
-                            break;
+                            m_ActionBackend->SetMute(!m_ActionBackend->GetMute());
                         }
-                        case IEMidiActionType::OpenFile:
+                    }
+                    else
+                    {
+                        const bool bMute = MidiValue != 0;
+                        m_ActionBackend->SetMute(bMute);
+                    }
+                }
+            }
+            break;
+        }
+        case IEMidiActionType::ConsoleCommand:
+        {
+            if (m_bIsActionSupported[static_cast<size_t>(IEMidiActionType::ConsoleCommand)])
+            {
+                bIsExecuted = true;
+
+                const IEMidiCompiledInputProperty& MidiInputProperty = CompiledProfile.GetInputProperty(InputMatch.PropertyIndex);
+                switch (InputMatch.MidiMessageType)
+                {
+                    case IEMidiMessageType::NoteOnOff:
+                    case IEMidiMessageType::ProgramChange:
+                    {
+                        if (InputMatch.bIsMidiToggle)
                         {
-                            if (m_OpenFileAction)
+                            const bool bOn = MidiValue != 0;
+                            if (bOn)
                             {
-                                Result.Type = IEResult::Type::Success;
-
-                                if (ActiveMidiDeviceInputProperty->MidiMessageType == IEMidiMessageType::NoteOnOff)
-                                {
-                                    const bool bOn = static_cast<unsigned int>(MidiMessage[2]) != 0;
-                                    if (bOn)
-                                    {
-                                        m_OpenFileAction->OpenFile(ActiveMidiDeviceInputProperty->OpenFilePath);
-                                    }
-                                }
+                                bool& bIsConsoleCommandActive = MidiInputProperty.RuntimeState->bIsConsoleCommandActive;
+                                ExecuteConsoleCommand(MidiInputProperty, bIsConsoleCommandActive ? 0.0f : 1.0f);
+                                bIsConsoleCommandActive = !bIsConsoleCommandActive;
                             }
-                            break;
                         }
-                        default:
+                        else
                         {
-                            break;
+                            ExecuteConsoleCommand(MidiInputProperty, 1.0f);
                         }
+                        break;
+                    }
+                    case IEMidiMessageType::ControlChange:
+                    case IEMidiMessageType::ChannelAftertouch:
+                    case IEMidiMessageType::PolyAftertouch:
+                    {
+                        const float Value = static_cast<float>(MidiValue);
+                        ExecuteConsoleCommand(MidiInputProperty, Value);
+                        break;
+                    }
+                    default:
+                    {
+                        break;
                     }
                 }
-                ActiveMidiDeviceInputProperty = ActiveMidiDeviceInputProperty->Next();
             }
+            break;
+        }
+        case IEMidiActionType::OpenFile:
+        {
+            if (m_bIsActionSupported[static_cast<size_t>(IEMidiActionType::OpenFile)])
+            {
+                bIsExecuted = true;
+
+                if (IsTriggerMidiMessageType(InputMatch.MidiMessageType))
+                {
+                    const bool bOn = MidiValue != 0;
+                    if (bOn)
+                    {
+                        m_ActionBackend->OpenFile(CompiledProfile.GetInputProperty(InputMatch.PropertyIndex).OpenFilePath);
+                    }
+                }
+            }
+            break;
+        }
+        default:
+        {
+            break;
         }
     }
-    if (Result.Type == IEResult::Type::Success)
+
+    return bIsExecuted;
+}
+
+uint8_t IEMidiProcessor::GetMidiMessageValue(const IEMidiMessage& MidiMessage)
+{
+    switch (MidiMessage.GetStatus() & 0xF0)
     {
-        Result.Message = std::string("Successfully processed Midi");
+        case 0xC0:
+        {
+            // Program change has no value, selecting the program acts as a press
+            return 127;
+        }
+        case 0xD0:
+        {
+            return MidiMessage[1];
+        }
+        default:
+        {
+            return MidiMessage[2];
+        }
+    }
+}
+
+void IEMidiProcessor::ExecuteConsoleCommand(const IEMidiCompiledInputProperty& MidiInputProperty, float Value) const
+{
+    if (MidiInputProperty.CompiledCommand)
+    {
+        m_ActionBackend->ExecuteConsoleCommand(MidiInputProperty.CompiledCommand, Value);
+    }
+}
+
+void IEMidiProcessor::StopUnusedPersistentCommands()
+{
+    // Helpers stay running between values, an edited or deleted mapping would otherwise keep its own until exit
+    std::set<std::string> ConsoleCommands;
+    for (const std::unique_ptr<IEMidiDeviceContext>& MidiDeviceContext : m_MidiDeviceContexts)
+    {
+        if (MidiDeviceContext)
+        {
+            for (const IEMidiDeviceInputProperty& MidiDeviceInputProperty : MidiDeviceContext->MidiDeviceProfile.InputProperties)
+            {
+                if (MidiDeviceInputProperty.MidiActionType == IEMidiActionType::ConsoleCommand && MidiDeviceInputProperty.bIsConsoleCommandPersistent)
+                {
+                    ConsoleCommands.insert(MidiDeviceInputProperty.ConsoleCommand);
+                }
+            }
+        }
+    }
+    m_CommandRunner->RetainPersistentCommands(std::move(ConsoleCommands));
+}
+
+void IEMidiProcessor::CoalesceMidiInputProperty(const IEMidiCompiledProfile& CompiledProfile, const IEMidiInputMatch& InputMatch,
+    const IEMidiInputEvent& MidiInputEvent, std::chrono::steady_clock::time_point Now)
+{
+    const IEMidiCompiledInputProperty& MidiInputProperty = CompiledProfile.GetInputProperty(InputMatch.PropertyIndex);
+    IEMidiInputPropertyState& RuntimeState = *MidiInputProperty.RuntimeState;
+    if (RuntimeState.bHasPendingMidiMessage)
+    {
+        // The previous pending value is superseded and will never be applied
+        RuntimeState.PendingMidiMessage = MidiInputEvent.MidiMessage;
+        RuntimeState.PendingReceivedTime = MidiInputEvent.ReceivedTime;
+        RuntimeState.CoalescedUpdateCount.fetch_add(1, std::memory_order_relaxed);
+        m_CoalescedUpdateCount.fetch_add(1, std::memory_order_relaxed);
+    }
+    else if (Now - RuntimeState.LastAppliedTime >= MidiInputProperty.CoalesceInterval)
+    {
+        ExecuteMidiInputProperty(CompiledProfile, InputMatch, MidiInputEvent.MidiMessage);
+        RuntimeState.LastAppliedTime = Now;
+        RecordLatency(InputMatch.MidiActionType, IEMidiLatencyStage::Completion, MidiInputEvent.ReceivedTime, std::chrono::steady_clock::now());
+    }
+    else
+    {
+        RuntimeState.PendingMidiMessage = MidiInputEvent.MidiMessage;
+        RuntimeState.PendingReceivedTime = MidiInputEvent.ReceivedTime;
+        RuntimeState.bHasPendingMidiMessage = true;
+        m_PendingCoalescedProperties.push_back({CompiledProfile.shared_from_this(), InputMatch});
+    }
+}
+
+std::chrono::steady_clock::time_point IEMidiProcessor::FlushCoalescedMidiInputProperties(bool bIsFinal)
+{
+    std::chrono::steady_clock::time_point NextFlushTime = std::chrono::steady_clock::time_point::max();
+    if (!m_PendingCoalescedProperties.empty())
+    {
+        const std::chrono::steady_clock::time_point Now = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < m_PendingCoalescedProperties.size();)
+        {
+            const IEMidiCompiledProfile& CompiledProfile = *m_PendingCoalescedProperties[i].CompiledProfile;
+            const IEMidiInputMatch& InputMatch = m_PendingCoalescedProperties[i].InputMatch;
+            const IEMidiCompiledInputProperty& MidiInputProperty = CompiledProfile.GetInputProperty(InputMatch.PropertyIndex);
+            IEMidiInputPropertyState& RuntimeState = *MidiInputProperty.RuntimeState;
+            const std::chrono::steady_clock::time_point FlushTime = RuntimeState.LastAppliedTime + MidiInputProperty.CoalesceInterval;
+            if (bIsFinal || Now >= FlushTime)
+            {
+                ExecuteMidiInputProperty(CompiledProfile, InputMatch, RuntimeState.PendingMidiMessage);
+                RuntimeState.LastAppliedTime = Now;
+                RuntimeState.bHasPendingMidiMessage = false;
+                RecordLatency(InputMatch.MidiActionType, IEMidiLatencyStage::Completion, RuntimeState.PendingReceivedTime, std::chrono::steady_clock::now());
+
+                m_PendingCoalescedProperties[i] = std::move(m_PendingCoalescedProperties.back());
+                m_PendingCoalescedProperties.pop_back();
+            }
+            else
+            {
+                NextFlushTime = std::min(NextFlushTime, FlushTime);
+                i++;
+            }
+        }
+    }
+    return NextFlushTime;
+}
+
+void IEMidiProcessor::RecordLatency(IEMidiActionType MidiActionType, IEMidiLatencyStage LatencyStage,
+    std::chrono::steady_clock::time_point ReceivedTime, std::chrono::steady_clock::time_point StageTime)
+{
+    if (MidiActionType < IEMidiActionType::Count)
+    {
+        m_LatencyHistograms[static_cast<size_t>(MidiActionType)][static_cast<size_t>(LatencyStage)].Record(StageTime - ReceivedTime);
+    }
+}
+
+IEMidiLatencySnapshot IEMidiProcessor::GetLatencySnapshot(IEMidiActionType MidiActionType, IEMidiLatencyStage LatencyStage) const
+{
+    IEMidiLatencySnapshot LatencySnapshot;
+    if (MidiActionType < IEMidiActionType::Count && LatencyStage < IEMidiLatencyStage::Count)
+    {
+        LatencySnapshot = m_LatencyHistograms[static_cast<size_t>(MidiActionType)][static_cast<size_t>(LatencyStage)].GetSnapshot();
+    }
+    return LatencySnapshot;
+}
+
+void IEMidiProcessor::ResetLatencyHistograms()
+{
+    for (std::array<IEMidiLatencyHistogram, static_cast<size_t>(IEMidiLatencyStage::Count)>& ActionLatencyHistograms : m_LatencyHistograms)
+    {
+        for (IEMidiLatencyHistogram& LatencyHistogram : ActionLatencyHistograms)
+        {
+            LatencyHistogram.Reset();
+        }
+    }
+}
+
+std::string IEMidiProcessor::DumpLatencyHistograms() const
+{
+    static constexpr std::array<const char*, static_cast<size_t>(IEMidiLatencyStage::Count)> LatencyStageNames = {"Callback", "Dispatch", "Completion"};
+
+    std::string LatencyDump = "Action Type, Stage, Count, Mean (us), P50 (us), P99 (us), Max (us)\n";
+    for (size_t ActionTypeIndex = 0; ActionTypeIndex < static_cast<size_t>(IEMidiActionType::Count); ActionTypeIndex++)
+    {
+        for (size_t StageIndex = 0; StageIndex < static_cast<size_t>(IEMidiLatencyStage::Count); StageIndex++)
+        {
+            const IEMidiLatencySnapshot LatencySnapshot = m_LatencyHistograms[ActionTypeIndex][StageIndex].GetSnapshot();
+            if (LatencySnapshot.Count > 0)
+            {
+                LatencyDump += std::format("{}, {}, {}, {:.1f}, {:.1f}, {:.1f}, {:.1f}\n",
+                    GetMidiActionTypeName(static_cast<IEMidiActionType>(ActionTypeIndex)), LatencyStageNames[StageIndex], LatencySnapshot.Count,
+                    LatencySnapshot.GetMean().count() / 1000.0, LatencySnapshot.GetPercentile(50.0).count() / 1000.0,
+                    LatencySnapshot.GetPercentile(99.0).count() / 1000.0, LatencySnapshot.GetMax().count() / 1000.0);
+            }
+        }
+    }
+    return LatencyDump;
+}
+
+IEResult IEMidiProcessor::SendMidiOutputMessage(const IEMidiMessage& MidiMessage) const
+{
+    IEResult Result(IEResult::Type::Fail, "Failed to send midi output message");
+    if (HasActiveMidiDeviceProfile())
+    {
+        const IEMidiDeviceContext& MidiDeviceContext = GetFocusedMidiDeviceContext();
+        if (MidiDeviceContext.MidiOut)
+        {
+            MidiDeviceContext.MidiOut->sendMessage(MidiMessage.data(), MidiMessage.size());
+            Result.Type = IEResult::Type::Success;
+            Result.Message = std::string("Successfully sent midi output message");
+        }
     }
     return Result;
 }
 
-IEResult IEMidiProcessor::SendMidiOutputMessage(const std::array<uint8_t, MIDI_MESSAGE_BYTE_COUNT>& MidiMessage) const
+IEResult IEMidiProcessor::SendMidiOutputMessage(const std::string& MidiDeviceName, const IEMidiMessage& MidiMessage) const
 {
     IEResult Result(IEResult::Type::Fail, "Failed to send midi output message");
-    if (m_MidiOut && m_ActiveMidiDeviceProfile)
+    if (const int32_t DeviceIndex = FindMidiDeviceContextIndex(MidiDeviceName); DeviceIndex >= 0)
     {
-        m_MidiOut->sendMessage(MidiMessage.data(), MIDI_MESSAGE_BYTE_COUNT);
-        Result.Type = IEResult::Type::Success;
-        Result.Message = std::string("Successfully sent midi output message");
+        const IEMidiDeviceContext& MidiDeviceContext = *m_MidiDeviceContexts[DeviceIndex];
+        if (MidiDeviceContext.MidiOut)
+        {
+            MidiDeviceContext.MidiOut->sendMessage(MidiMessage.data(), MidiMessage.size());
+            Result.Type = IEResult::Type::Success;
+            Result.Message = std::string("Successfully sent midi output message");
+        }
     }
     return Result;
 }
@@ -183,31 +385,53 @@ std::string IEMidiProcessor::GetAPIName() const
 
 IEMidiDeviceProfile& IEMidiProcessor::GetActiveMidiDeviceProfile()
 {
-    if (!m_ActiveMidiDeviceProfile.has_value())
+    return GetFocusedMidiDeviceContext().MidiDeviceProfile;
+}
+
+const IEMidiDeviceProfile& IEMidiProcessor::GetActiveMidiDeviceProfile() const
+{
+    return GetFocusedMidiDeviceContext().MidiDeviceProfile;
+}
+
+IESPSCQueue<IEMidiLogEntry>& IEMidiProcessor::GetMidiLogMessagesBuffer()
+{
+    return GetFocusedMidiDeviceContext().MidiLogMessagesBuffer;
+}
+
+const IESPSCQueue<IEMidiLogEntry>& IEMidiProcessor::GetMidiLogMessagesBuffer() const
+{
+    return GetFocusedMidiDeviceContext().MidiLogMessagesBuffer;
+}
+
+void IEMidiProcessor::CompileActiveMidiDeviceProfile()
+{
+    if (HasActiveMidiDeviceProfile())
     {
-        IELOG_ERROR("No active midi device profile");
-        abort();
+        IEMidiDeviceContext& MidiDeviceContext = GetFocusedMidiDeviceContext();
+        MidiDeviceContext.CompiledProfilePublisher.Publish(std::make_shared<const IEMidiCompiledProfile>(MidiDeviceContext.MidiDeviceProfile));
+        StopUnusedPersistentCommands();
     }
-    return m_ActiveMidiDeviceProfile.value();
 }
 
-const IEMidiDeviceProfile& IEMidiProcessor::GetActiveMidiDeviceProfile() const
+IEMidiDeviceProfile* IEMidiProcessor::FindMidiDeviceProfile(const std::string& MidiDeviceName)
 {
-    if (!m_ActiveMidiDeviceProfile.has_value())
+    const int32_t DeviceIndex = FindMidiDeviceContextIndex(MidiDeviceName);
+    return DeviceIndex >= 0 ? &m_MidiDeviceContexts[DeviceIndex]->MidiDeviceProfile : nullptr;
+}
+
+void IEMidiProcessor::CompileMidiDeviceProfile(const std::string& MidiDeviceName)
+{
+    if (const int32_t DeviceIndex = FindMidiDeviceContextIndex(MidiDeviceName); DeviceIndex >= 0)
     {
-        IELOG_ERROR("No active midi device profile");
-        abort();
+        IEMidiDeviceContext& MidiDeviceContext = *m_MidiDeviceContexts[DeviceIndex];
+        MidiDeviceContext.CompiledProfilePublisher.Publish(std::make_shared<const IEMidiCompiledProfile>(MidiDeviceContext.MidiDeviceProfile));
+        StopUnusedPersistentCommands();
     }
-    return m_ActiveMidiDeviceProfile.value();
 }
 
 void IEMidiProcessor::SetTestMode(bool bTestMode)
 {
     m_bTestMode = bTestMode;
-    for (int i = 0; i < 10; i++)
-    {
-        m_MidiLogMessagesBuffer.Push(std::array<uint8_t, MIDI_MESSAGE_BYTE_COUNT>{127, 0, 0});
-    }
 }
 
 IEResult IEMidiProcessor::ActivateMidiDeviceProfile(const std::string& MidiDeviceName)
@@ -215,49 +439,37 @@ IEResult IEMidiProcessor::ActivateMidiDeviceProfile(const std::string& MidiDevic
     IEResult Result(IEResult::Type::Fail);
     Result.Message = std::format("Failed to activate midi device profile {}.", MidiDeviceName);
 
-    if (m_bTestMode)
+    if (const int32_t DeviceIndex = FindMidiDeviceContextIndex(MidiDeviceName); DeviceIndex >= 0)
     {
-        m_ActiveMidiDeviceProfile.emplace(MidiDeviceName, 0, 0);
+        m_FocusedDeviceIndex = DeviceIndex;
         Result.Type = IEResult::Type::Success;
-        Result.Message = std::format("Successfully activated test midi device profile {}", MidiDeviceName);
+        Result.Message = std::format("Midi device profile {} is already active", MidiDeviceName);
+    }
+    else if (m_bTestMode)
+    {
+        Result = OpenMidiDeviceContext(MidiDeviceName, 0, 0);
+        if (Result)
+        {
+            for (int i = 0; i < 10; i++)
+            {
+                GetMidiLogMessagesBuffer().Push(IEMidiLogEntry(IEMidiMessage({127, 0, 0})));
+            }
+            Result.Message = std::format("Successfully activated test midi device profile {}", MidiDeviceName);
+        }
     }
     else if (m_MidiIn && m_MidiOut)
     {
-        for (int InputPortNumber = 0; InputPortNumber < m_MidiIn->getPortCount(); InputPortNumber++)
+        for (int InputPortNumber = 0; InputPortNumber < m_MidiIn->getPortCount() && !Result; InputPortNumber++)
         {
             const std::string& MidiDeviceNameIn = GetSanitizedMidiDeviceName(m_MidiIn->getPortName(InputPortNumber), InputPortNumber);
             if (MidiDeviceNameIn.find(MidiDeviceName) != std::string::npos)
             {
-                for (int OutputPortNumber = 0; OutputPortNumber < m_MidiOut->getPortCount(); OutputPortNumber++)
+                for (int OutputPortNumber = 0; OutputPortNumber < m_MidiOut->getPortCount() && !Result; OutputPortNumber++)
                 {
                     const std::string& MidiDeviceNameOut = GetSanitizedMidiDeviceName(m_MidiOut->getPortName(OutputPortNumber), InputPortNumber);
                     if (MidiDeviceNameOut.find(MidiDeviceName) != std::string::npos)
                     {
-                        m_ActiveMidiDeviceProfile.emplace(MidiDeviceName, InputPortNumber, OutputPortNumber);
-
-                        if (m_MidiIn->isPortOpen())
-                        {
-                            m_MidiIn->cancelCallback();
-                            m_MidiIn->closePort();
-                        }
-                        m_MidiIn->setCallback(&IEMidiProcessor::OnRtMidiCallback, this);
-                        m_MidiIn->openPort(m_ActiveMidiDeviceProfile->InputPortNumber);
-
-                        if (m_MidiOut->isPortOpen())
-                        {
-                            m_MidiOut->closePort();
-                        }
-                        m_MidiOut->openPort(m_ActiveMidiDeviceProfile->OutputPortNumber);
-
-                        IEMidiDeviceOutputProperty* MidiDeviceOutputProperty = GetActiveMidiDeviceProfile().OutputPropertiesHead.get();
-                        while (MidiDeviceOutputProperty)
-                        {
-                            m_MidiOut->sendMessage(MidiDeviceOutputProperty->MidiMessage.data(), MIDI_MESSAGE_BYTE_COUNT);
-                            MidiDeviceOutputProperty = MidiDeviceOutputProperty->Next();
-                        }
-
-                        Result.Type = IEResult::Type::Success;
-                        Result.Message = std::format("Successfully activated midi device profile {}", MidiDeviceName);
+                        Result = OpenMidiDeviceContext(MidiDeviceName, InputPortNumber, OutputPortNumber);
                     }
                 }
             }
@@ -267,87 +479,181 @@ IEResult IEMidiProcessor::ActivateMidiDeviceProfile(const std::string& MidiDevic
     return Result;
 }
 
-void IEMidiProcessor::DeactivateMidiDeviceProfile()
+IEResult IEMidiProcessor::ActivateVirtualMidiDeviceProfile(const std::string& MidiDeviceName)
 {
-    if (m_MidiIn)
+    IEResult Result(IEResult::Type::Fail);
+    Result.Message = std::format("Failed to activate virtual midi device profile {}.", MidiDeviceName);
+
+    if (const int32_t DeviceIndex = FindMidiDeviceContextIndex(MidiDeviceName); DeviceIndex >= 0)
+    {
+        m_FocusedDeviceIndex = DeviceIndex;
+        Result.Type = IEResult::Type::Success;
+        Result.Message = std::format("Midi device profile {} is already active", MidiDeviceName);
+    }
+    else
     {
-        if (m_MidiIn->isPortOpen())
+        // Virtual ports let other applications drive the processor, not supported by the Windows MM API
+        Result = OpenMidiDeviceContext(MidiDeviceName, 0, 0, true);
+        if (Result)
         {
-            m_MidiIn->closePort();
-            m_MidiIn->cancelCallback();
+            Result.Message = std::format("Successfully activated virtual midi device profile {}", MidiDeviceName);
         }
     }
+    return Result;
+}
+
+void IEMidiProcessor::DeactivateMidiDeviceProfile(const std::string& MidiDeviceName)
+{
+    CloseMidiDeviceContext(FindMidiDeviceContextIndex(MidiDeviceName));
+}
+
+void IEMidiProcessor::DeactivateAllMidiDeviceProfiles()
+{
+    for (int32_t DeviceIndex = 0; DeviceIndex < static_cast<int32_t>(MAX_EVENT_QUEUE_COUNT); DeviceIndex++)
+    {
+        CloseMidiDeviceContext(DeviceIndex);
+    }
+}
 
-    if (m_MidiOut)
+std::vector<std::string> IEMidiProcessor::GetActiveMidiDeviceNames() const
+{
+    std::vector<std::string> ActiveMidiDeviceNames;
+    for (const std::unique_ptr<IEMidiDeviceContext>& MidiDeviceContext : m_MidiDeviceContexts)
     {
-        if (m_MidiOut->isPortOpen())
+        if (MidiDeviceContext)
         {
-            m_MidiOut->closePort();
+            ActiveMidiDeviceNames.emplace_back(MidiDeviceContext->MidiDeviceProfile.NameID);
         }
     }
-
-    m_ActiveMidiDeviceProfile.reset();
+    return ActiveMidiDeviceNames;
 }
 
 bool IEMidiProcessor::HasActiveMidiDeviceProfile() const
 {
-    return m_ActiveMidiDeviceProfile.has_value();
+    return m_FocusedDeviceIndex >= 0 && m_MidiDeviceContexts[m_FocusedDeviceIndex];
 }
 
-uint32_t IEMidiProcessor::AddOnMidiCallback(std::function<void(double, const std::array<uint8_t, MIDI_MESSAGE_BYTE_COUNT>)> Func)
+uint32_t IEMidiProcessor::AddOnMidiCallback(IEMidiSubscriberFunc Func, void* Object)
 {
-    static uint32_t CallbackIDGenerator = 0;
-    m_MidiCallbackFuncs.emplace(CallbackIDGenerator++, Func);
-    return CallbackIDGenerator;
+    const uint32_t CallbackID = m_MidiCallbacks.Subscribe(Func, Object);
+    if (CallbackID == IEMidiSubscriberTable::INVALID_HANDLE)
+    {
+        IELOG_ERROR("Failed to add midi callback, all %u subscriber slots are in use", IEMidiSubscriberTable::MAX_SUBSCRIBER_COUNT);
+    }
+    return CallbackID;
 }
 
 void IEMidiProcessor::RemoveOnMidiCallback(uint32_t CallbackID)
 {
-    m_MidiCallbackFuncs.erase(CallbackID);
+    m_MidiCallbacks.Unsubscribe(CallbackID);
 }
 
-void IEMidiProcessor::OnRtMidiCallback(double TimeStamp, std::vector<unsigned char>* Message, void* UserData)
+bool IEMidiProcessor::LearnMidiMessage(IEMidiDeviceContext& MidiDeviceContext, const IEMidiCompiledProfile& CompiledProfile,
+    const IEMidiMessage& MidiMessage)
 {
-    if (Message && UserData)
+    // Releasing a note or a clock tick never starts learning a control
+    const uint8_t Status = MidiMessage.GetStatus();
+    const bool bIsNoteOff = (Status & 0xF0) == 0x80 || ((Status & 0xF0) == 0x90 && MidiMessage[2] == 0);
+    if (Status >= 0xF8 || bIsNoteOff || MidiDeviceContext.MidiLearnEvents.IsFull())
+    {
+        return false;
+    }
+
+    const uint32_t LearnSessionID = CompiledProfile.GetLearnSessionID();
+    if (LearnSessionID != MidiDeviceContext.LearnSessionID)
+    {
+        MidiDeviceContext.LearnSessionID = LearnSessionID;
+        MidiDeviceContext.LearnedControlCount = 0;
+    }
+
+    // A control keeps sending while it moves, only its first message goes to an armed property
+    const uint8_t Data1 = (Status & 0xF0) == 0xD0 ? 0 : MidiMessage[1];
+    const uint16_t ControlKey = static_cast<uint16_t>((Status << 7) | (Data1 & 0x7F));
+    const auto LearnedControlKeysEnd = MidiDeviceContext.LearnedControlKeys.begin() + MidiDeviceContext.LearnedControlCount;
+    if (std::find(MidiDeviceContext.LearnedControlKeys.begin(), LearnedControlKeysEnd, ControlKey) != LearnedControlKeysEnd)
+    {
+        return false;
+    }
+
+    // Every armed property of the session takes the next new control, in profile order
+    for (const IEMidiCompiledInputProperty& MidiInputProperty : CompiledProfile.GetInputProperties())
     {
-        if (IEAssert(Message->size() >= MIDI_MESSAGE_BYTE_COUNT))
+        if (MidiInputProperty.RuntimeState->bIsRecording.exchange(false, std::memory_order_acq_rel))
         {
-            std::array<uint8_t, MIDI_MESSAGE_BYTE_COUNT> MidiMessage;
-            std::copy(Message->begin(), Message->begin() + MIDI_MESSAGE_BYTE_COUNT, MidiMessage.begin());
+            CompiledProfile.ReleaseRecordingInputProperty();
+            MidiDeviceContext.MidiLearnEvents.Push(IEMidiLearnEvent{MidiInputProperty.PropertyHandle, MidiMessage});
+            if (MidiDeviceContext.LearnedControlCount < MidiDeviceContext.LearnedControlKeys.size())
+            {
+                MidiDeviceContext.LearnedControlKeys[MidiDeviceContext.LearnedControlCount++] = ControlKey;
+            }
+            return true;
+        }
+    }
+    return false;
+}
 
-            if (IEMidiProcessor* const MidiProcessor = reinterpret_cast<IEMidiProcessor*>(UserData))
+void IEMidiProcessor::ConsumeMidiLearnEvents(const std::function<void(IEMidiDeviceInputProperty&)>& OnMidiMessageLearned)
+{
+    for (const std::unique_ptr<IEMidiDeviceContext>& MidiDeviceContext : m_MidiDeviceContexts)
+    {
+        if (MidiDeviceContext)
+        {
+            IEMidiLearnEvent MidiLearnEvent;
+            while (MidiDeviceContext->MidiLearnEvents.Pop(MidiLearnEvent))
             {
-                bool bIncludeProcess = true;
-                if (MidiProcessor->m_ActiveMidiDeviceProfile)
+                // The property may have been deleted while it was armed
+                if (IEMidiDeviceInputProperty* const MidiDeviceInputProperty = MidiDeviceContext->MidiDeviceProfile.InputProperties.Find(MidiLearnEvent.PropertyHandle))
                 {
-                    IEMidiDeviceInputProperty* MidiDeviceInputProperty = MidiProcessor->m_ActiveMidiDeviceProfile->InputPropertiesHead.get();
-                    while (MidiDeviceInputProperty)
+                    MidiDeviceInputProperty->MidiMessage = MidiLearnEvent.MidiMessage;
+                    if (OnMidiMessageLearned)
                     {
-                        if (MidiDeviceInputProperty->bIsRecording)
-                        {
-                            MidiDeviceInputProperty->MidiMessage = MidiMessage;
-                            MidiDeviceInputProperty->bIsRecording = false;
-                            bIncludeProcess = false;
-                        }
-                        MidiDeviceInputProperty = MidiDeviceInputProperty->Next();
+                        OnMidiMessageLearned(*MidiDeviceInputProperty);
                     }
                 }
+            }
+        }
+    }
+}
 
-                if (MidiProcessor->m_MidiLogMessagesBuffer.IsFull())
+void IEMidiProcessor::OnRtMidiCallback(double TimeStamp, std::vector<unsigned char>* Message, void* UserData)
+{
+    const std::chrono::steady_clock::time_point ReceivedTime = std::chrono::steady_clock::now();
+
+    if (Message && UserData)
+    {
+        if (!Message->empty())
+        {
+            if (IEMidiDeviceContext* const MidiDeviceContext = reinterpret_cast<IEMidiDeviceContext*>(UserData))
+            {
+                IEMidiInputEvent MidiInputEvent;
+                MidiInputEvent.ReceivedTime = ReceivedTime;
+                MidiInputEvent.TimeStamp = TimeStamp;
+                MidiInputEvent.MidiMessage = IEMidiMessage(Message->data(), Message->size());
+                MidiInputEvent.QueueIndex = MidiDeviceContext->QueueIndex;
+                if (MidiInputEvent.MidiMessage.IsTruncated())
                 {
-                    MidiProcessor->m_MidiLogMessagesBuffer.Pop();
+                    MidiDeviceContext->MidiProcessor.m_TruncatedMessageCount.fetch_add(1, std::memory_order_relaxed);
                 }
-                MidiProcessor->m_MidiLogMessagesBuffer.Push(MidiMessage);
+                MidiDeviceContext->MidiProcessor.m_CaptureWriter.Enqueue(MidiDeviceContext->QueueIndex, ReceivedTime, MidiInputEvent.MidiMessage);
 
-                if (bIncludeProcess)
+                IEMidiCompiledProfilePublisher& CompiledProfilePublisher = MidiDeviceContext->CompiledProfilePublisher;
+                if (const IEMidiCompiledProfile* const CompiledProfile = CompiledProfilePublisher.Acquire(MIDI_INPUT_READER_SLOT))
                 {
-                    MidiProcessor->ProcessMidiInputMessage(MidiMessage);
+                    if (CompiledProfile->HasRecordingInputProperties())
+                    {
+                        MidiInputEvent.bIsLearned = LearnMidiMessage(*MidiDeviceContext, *CompiledProfile, MidiInputEvent.MidiMessage);
+                    }
                 }
+                CompiledProfilePublisher.Release(MIDI_INPUT_READER_SLOT);
 
-                for (const auto& Func : MidiProcessor->m_MidiCallbackFuncs)
+                if (MidiDeviceContext->MidiLogMessagesBuffer.IsFull())
                 {
-                    Func.second(TimeStamp, MidiMessage);
+                    MidiDeviceContext->MidiLogMessagesBuffer.Pop();
                 }
+                MidiDeviceContext->MidiLogMessagesBuffer.Push(IEMidiLogEntry(MidiInputEvent.MidiMessage));
+
+                MidiInputEvent.EnqueuedTime = std::chrono::steady_clock::now();
+                MidiDeviceContext->MidiProcessor.m_ActionWorker.Enqueue(MidiDeviceContext->QueueIndex, MidiInputEvent);
             }
         }
     }
@@ -358,6 +664,33 @@ void IEMidiProcessor::OnRtMidiErrorCallback(RtMidiError::Type RtMidiErrorType, c
     IELOG_ERROR("%s", ErrorText.c_str());
 }
 
+void IEMidiProcessor::StartActionWorker()
+{
+    // The previous worker applied every pending value before it exited, so the list starts empty
+    m_ActionWorker.Start([this](const IEMidiInputEvent& MidiInputEvent) { OnMidiInputEvent(MidiInputEvent); },
+        [this](bool bIsFinal) { return FlushCoalescedMidiInputProperties(bIsFinal); });
+}
+
+void IEMidiProcessor::OnMidiInputEvent(const IEMidiInputEvent& MidiInputEvent)
+{
+    // Learned messages are applied by the UI, which republishes the profile
+    if (!MidiInputEvent.bIsLearned && MidiInputEvent.QueueIndex < MAX_EVENT_QUEUE_COUNT)
+    {
+        // The context outlives any event of its queue, closing the queue waits for the worker
+        if (IEMidiDeviceContext* const MidiDeviceContext = m_MidiDeviceContexts[MidiInputEvent.QueueIndex].get())
+        {
+            IEMidiCompiledProfilePublisher& CompiledProfilePublisher = MidiDeviceContext->CompiledProfilePublisher;
+            if (const IEMidiCompiledProfile* const CompiledProfile = CompiledProfilePublisher.Acquire(ACTION_WORKER_READER_SLOT))
+            {
+                ProcessMidiInputMessage(*CompiledProfile, MidiInputEvent);
+            }
+            CompiledProfilePublisher.Release(ACTION_WORKER_READER_SLOT);
+        }
+    }
+
+    m_MidiCallbacks.Dispatch(MidiInputEvent.TimeStamp, MidiInputEvent.MidiMessage);
+}
+
 std::string IEMidiProcessor::GetSanitizedMidiDeviceName(const std::string& MidiDeviceName, uint32_t InputPortNumber) const
 {
     std::string SanitizedMidiDeviceName = MidiDeviceName;
@@ -376,4 +709,107 @@ std::string IEMidiProcessor::GetSanitizedMidiDeviceName(const std::string& MidiD
     }
 
     return SanitizedMidiDeviceName;
+}
+
+IEResult IEMidiProcessor::OpenMidiDeviceContext(const std::string& MidiDeviceName, uint32_t InputPortNumber, uint32_t OutputPortNumber, bool bIsVirtual)
+{
+    IEResult Result(IEResult::Type::Fail);
+    Result.Message = std::format("Failed to activate midi device profile {}, at most {} devices can be active at once",
+        MidiDeviceName, MAX_EVENT_QUEUE_COUNT);
+
+    const int32_t DeviceIndex = m_ActionWorker.OpenQueue();
+    if (DeviceIndex >= 0)
+    {
+        std::unique_ptr<IEMidiDeviceContext>& MidiDeviceContext = m_MidiDeviceContexts[DeviceIndex];
+        MidiDeviceContext = std::make_unique<IEMidiDeviceContext>(*this, DeviceIndex, MidiDeviceName, InputPortNumber, OutputPortNumber);
+        m_FocusedDeviceIndex = DeviceIndex;
+        m_CaptureWriter.OpenQueue(DeviceIndex, MidiDeviceName);
+        CompileActiveMidiDeviceProfile();
+
+        if (!m_ActionWorker.IsRunning())
+        {
+            StartActionWorker();
+        }
+
+        if (bIsVirtual)
+        {
+            MidiDeviceContext->MidiIn->setErrorCallback(&IEMidiProcessor::OnRtMidiErrorCallback);
+            MidiDeviceContext->MidiIn->setCallback(&IEMidiProcessor::OnRtMidiCallback, MidiDeviceContext.get());
+            MidiDeviceContext->MidiIn->openVirtualPort(MidiDeviceName);
+
+            MidiDeviceContext->MidiOut->setErrorCallback(&IEMidiProcessor::OnRtMidiErrorCallback);
+            MidiDeviceContext->MidiOut->openVirtualPort(MidiDeviceName);
+            MidiDeviceContext->bArePortsOpen = true;
+        }
+        else if (!m_bTestMode)
+        {
+            MidiDeviceContext->MidiIn->setErrorCallback(&IEMidiProcessor::OnRtMidiErrorCallback);
+            MidiDeviceContext->MidiIn->setCallback(&IEMidiProcessor::OnRtMidiCallback, MidiDeviceContext.get());
+            MidiDeviceContext->MidiIn->openPort(InputPortNumber);
+
+            MidiDeviceContext->MidiOut->setErrorCallback(&IEMidiProcessor::OnRtMidiErrorCallback);
+            MidiDeviceContext->MidiOut->openPort(OutputPortNumber);
+            MidiDeviceContext->bArePortsOpen = true;
+        }
+
+        Result.Type = IEResult::Type::Success;
+        Result.Message = std::format("Successfully activated midi device profile {}", MidiDeviceName);
+    }
+    return Result;
+}
+
+void IEMidiProcessor::CloseMidiDeviceContext(int32_t DeviceIndex)
+{
+    if (DeviceIndex >= 0 && DeviceIndex < static_cast<int32_t>(MAX_EVENT_QUEUE_COUNT) && m_MidiDeviceContexts[DeviceIndex])
+    {
+        std::unique_ptr<IEMidiDeviceContext>& MidiDeviceContext = m_MidiDeviceContexts[DeviceIndex];
+
+        // Stop the producer first, then wait for the worker to let go of the queue and the context
+        MidiDeviceContext->ClosePorts();
+        m_ActionWorker.CloseQueue(DeviceIndex);
+        m_CaptureWriter.CloseQueue(DeviceIndex);
+        MidiDeviceContext->CompiledProfilePublisher.Publish(nullptr);
+        MidiDeviceContext.reset();
+        StopUnusedPersistentCommands();
+
+        if (m_FocusedDeviceIndex == DeviceIndex)
+        {
+            m_FocusedDeviceIndex = -1;
+            for (int32_t OtherDeviceIndex = 0; OtherDeviceIndex < static_cast<int32_t>(MAX_EVENT_QUEUE_COUNT); OtherDeviceIndex++)
+            {
+                if (m_MidiDeviceContexts[OtherDeviceIndex])
+                {
+                    m_FocusedDeviceIndex = OtherDeviceIndex;
+                    break;
+                }
+            }
+        }
+
+        if (m_FocusedDeviceIndex < 0)
+        {
+            m_ActionWorker.Stop();
+        }
+    }
+}
+
+int32_t IEMidiProcessor::FindMidiDeviceContextIndex(const std::string& MidiDeviceName) const
+{
+    for (int32_t DeviceIndex = 0; DeviceIndex < static_cast<int32_t>(MAX_EVENT_QUEUE_COUNT); DeviceIndex++)
+    {
+        if (m_MidiDeviceContexts[DeviceIndex] && m_MidiDeviceContexts[DeviceIndex]->MidiDeviceProfile.NameID == MidiDeviceName)
+        {
+            return DeviceIndex;
+        }
+    }
+    return -1;
+}
+
+IEMidiDeviceContext& IEMidiProcessor::GetFocusedMidiDeviceContext() const
+{
+    if (!HasActiveMidiDeviceProfile())
+    {
+        IELOG_ERROR("No active midi device profile");
+        abort();
+    }
+    return *m_MidiDeviceContexts[m_FocusedDeviceIndex];
 }
\ No newline at end of file
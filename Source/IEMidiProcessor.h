@@ -4,86 +4,176 @@
 
 #pragma once
 
-#include <map>
+#include <algorithm>
+#include <array>
+#include <functional>
 #include <memory>
-#include <optional>
+#include <utility>
 #include <vector>
 
-#include "IEActions.h"
 #include "IEConcurrency.h"
 #include "IELog.h"
 #include "RtMidi.h"
 
+#include "IEMidiActionBackend.h"
+#include "IEMidiActionWorker.h"
+#include "IEMidiCaptureWriter.h"
+#include "IEMidiCommandRunner.h"
+#include "IEMidiCompiledProfilePublisher.h"
+#include "IEMidiDeviceContext.h"
+#include "IEMidiLatencyHistogram.h"
+#include "IEMidiSubscriberTable.h"
+#include "IEMidiSystemActionBackend.h"
 #include "IEMidiTypes.h"
 
+struct IEMidiPendingCoalescedProperty
+{
+    // Keeps the snapshot alive until the pending value is applied, even if the UI has since republished
+    std::shared_ptr<const IEMidiCompiledProfile> CompiledProfile;
+    IEMidiInputMatch InputMatch;
+};
+
 class IEMidiProcessor
 {
 public:
-    IEMidiProcessor() :
+    // Actions are applied to the system unless another backend is given
+    explicit IEMidiProcessor(std::unique_ptr<IEMidiActionBackend> ActionBackend = nullptr) :
         m_MidiIn(std::make_unique<RtMidiIn>()),
         m_MidiOut(std::make_unique<RtMidiOut>()),
-        m_VolumeAction(IEAction::GetVolumeAction()),
-        m_MuteAction(IEAction::GetMuteAction()),
-        m_ConsoleCommandAction(IEAction::GetConsoleCommandAction()),
-        m_OpenFileAction(IEAction::GetOpenFileAction())
+        m_CommandRunner(std::make_unique<IEMidiCommandRunner>()),
+        m_ActionBackend(ActionBackend ? std::move(ActionBackend) : std::make_unique<IEMidiSystemActionBackend>(*m_CommandRunner))
     {
         m_MidiIn->setErrorCallback(&IEMidiProcessor::OnRtMidiErrorCallback);
+        m_MidiIn->ignoreTypes(false, true, true);
         m_MidiOut->setErrorCallback(&IEMidiProcessor::OnRtMidiErrorCallback);
+        for (size_t ActionTypeIndex = 0; ActionTypeIndex < m_bIsActionSupported.size(); ActionTypeIndex++)
+        {
+            m_bIsActionSupported[ActionTypeIndex] = m_ActionBackend->IsSupported(static_cast<IEMidiActionType>(ActionTypeIndex));
+        }
     };
+    ~IEMidiProcessor();
+    IEMidiProcessor(const IEMidiProcessor&) = delete;
+    IEMidiProcessor& operator=(const IEMidiProcessor&) = delete;
    
 public:
-    IEResult ProcessMidiInputMessage(const std::array<uint8_t, MIDI_MESSAGE_BYTE_COUNT>& MidiMessage) const;
-    IEResult SendMidiOutputMessage(const std::array<uint8_t, MIDI_MESSAGE_BYTE_COUNT>& MidiMessage) const;
+    IEResult ProcessMidiInputMessage(const IEMidiCompiledProfile& CompiledProfile, const IEMidiInputEvent& MidiInputEvent);
+    IEResult SendMidiOutputMessage(const IEMidiMessage& MidiMessage) const;
+    IEResult SendMidiOutputMessage(const std::string& MidiDeviceName, const IEMidiMessage& MidiMessage) const;
 
+public:
     std::vector<std::string> GetAvailableMidiDevices() const;
     std::string GetAPIName() const;
+
+public:
+    // Any number of devices can be active at once. Activating a device also makes it the focused
+    // one, which the single device accessors below refer to.
     IEResult ActivateMidiDeviceProfile(const std::string& MidiDeviceName);
-    void DeactivateMidiDeviceProfile();
+    IEResult ActivateVirtualMidiDeviceProfile(const std::string& MidiDeviceName);
+    void DeactivateMidiDeviceProfile(const std::string& MidiDeviceName);
+    void DeactivateAllMidiDeviceProfiles();
+    std::vector<std::string> GetActiveMidiDeviceNames() const;
     bool HasActiveMidiDeviceProfile() const;
     IEMidiDeviceProfile& GetActiveMidiDeviceProfile();
     const IEMidiDeviceProfile& GetActiveMidiDeviceProfile() const;
-    IESPSCQueue<std::array<uint8_t, MIDI_MESSAGE_BYTE_COUNT>>& GetMidiLogMessagesBuffer() { return m_MidiLogMessagesBuffer; }
-    const IESPSCQueue<std::array<uint8_t, MIDI_MESSAGE_BYTE_COUNT>>& GetMidiLogMessagesBuffer() const { return m_MidiLogMessagesBuffer; }
+    void CompileActiveMidiDeviceProfile();
+    IESPSCQueue<IEMidiLogEntry>& GetMidiLogMessagesBuffer();
+    const IESPSCQueue<IEMidiLogEntry>& GetMidiLogMessagesBuffer() const;
+
+public:
+    // Any active device, focused or not
+    IEMidiDeviceProfile* FindMidiDeviceProfile(const std::string& MidiDeviceName);
+    void CompileMidiDeviceProfile(const std::string& MidiDeviceName);
+
+public:
+    IEMidiActionWorkerStats GetActionWorkerStats() const { return m_ActionWorker.GetStats(); }
+    uint64_t GetCoalescedUpdateCount() const { return m_CoalescedUpdateCount.load(std::memory_order_relaxed); }
+    // SysEx messages cut short because they outgrew an IEMidiSysExPool slot
+    uint64_t GetTruncatedMessageCount() const { return m_TruncatedMessageCount.load(std::memory_order_relaxed); }
+    IEMidiLatencySnapshot GetLatencySnapshot(IEMidiActionType MidiActionType, IEMidiLatencyStage LatencyStage) const;
+    void ResetLatencyHistograms();
+    std::string DumpLatencyHistograms() const;
     void SetTestMode(bool bTestMode);
+    void SetCommandRunnerConfig(const IEMidiCommandRunnerConfig& Config) { m_CommandRunner->SetConfig(Config); }
+    IEMidiCommandRunnerStats GetCommandRunnerStats() const { return m_CommandRunner->GetStats(); }
+
+public:
+    // Streams every incoming message of every active device to Standard MIDI Files until stopped
+    IEResult StartMidiCapture(const IEMidiCaptureConfig& Config) { return m_CaptureWriter.Start(Config); }
+    void StopMidiCapture() { m_CaptureWriter.Stop(); }
+    bool IsMidiCaptureRunning() const { return m_CaptureWriter.IsRunning(); }
+    IEMidiCaptureStats GetMidiCaptureStats() const { return m_CaptureWriter.GetStats(); }
 
 public:
-    [[nodiscard]] uint32_t AddOnMidiCallback(std::function<void(double, const std::array<uint8_t, MIDI_MESSAGE_BYTE_COUNT>)> Func);
-    template<typename T>
-    [[nodiscard]] uint32_t AddOnMidiCallback(T* Object, void (T::*MemFunc)(double, const std::array<uint8_t, MIDI_MESSAGE_BYTE_COUNT>));
+    // Callbacks run on the action worker thread. Returns IEMidiSubscriberTable::INVALID_HANDLE when full
+    [[nodiscard]] uint32_t AddOnMidiCallback(IEMidiSubscriberFunc Func, void* Object);
+    template<auto MemFunc, typename T>
+    [[nodiscard]] uint32_t AddOnMidiCallback(T* Object);
     void RemoveOnMidiCallback(uint32_t CallbackID);
 
+public:
+    // UI thread only. Writes the messages learned since the last call into their input properties
+    void ConsumeMidiLearnEvents(const std::function<void(IEMidiDeviceInputProperty&)>& OnMidiMessageLearned);
+
 private:
     static void OnRtMidiCallback(double TimeStamp, std::vector<unsigned char>* Message, void* UserData);
     static void OnRtMidiErrorCallback(RtMidiError::Type RtMidiErrorType, const std::string& ErrorText, void* UserData);
+    static bool LearnMidiMessage(IEMidiDeviceContext& MidiDeviceContext, const IEMidiCompiledProfile& CompiledProfile,
+        const IEMidiMessage& MidiMessage);
+    void StartActionWorker();
+    void OnMidiInputEvent(const IEMidiInputEvent& MidiInputEvent);
+
+private:
+    static uint8_t GetMidiMessageValue(const IEMidiMessage& MidiMessage);
+    bool ExecuteMidiInputProperty(const IEMidiCompiledProfile& CompiledProfile, const IEMidiInputMatch& InputMatch, const IEMidiMessage& MidiMessage) const;
+    void ExecuteConsoleCommand(const IEMidiCompiledInputProperty& MidiInputProperty, float Value) const;
+    void StopUnusedPersistentCommands();
+    void CoalesceMidiInputProperty(const IEMidiCompiledProfile& CompiledProfile, const IEMidiInputMatch& InputMatch,
+        const IEMidiInputEvent& MidiInputEvent, std::chrono::steady_clock::time_point Now);
+    // A final flush applies every pending value without waiting for its interval
+    std::chrono::steady_clock::time_point FlushCoalescedMidiInputProperties(bool bIsFinal);
+    void RecordLatency(IEMidiActionType MidiActionType, IEMidiLatencyStage LatencyStage,
+        std::chrono::steady_clock::time_point ReceivedTime, std::chrono::steady_clock::time_point StageTime);
 
 private:
     std::string GetSanitizedMidiDeviceName(const std::string& MidiDeviceName, uint32_t InputPortNumber) const;
+    IEResult OpenMidiDeviceContext(const std::string& MidiDeviceName, uint32_t InputPortNumber, uint32_t OutputPortNumber, bool bIsVirtual = false);
+    void CloseMidiDeviceContext(int32_t DeviceIndex);
+    int32_t FindMidiDeviceContextIndex(const std::string& MidiDeviceName) const;
+    IEMidiDeviceContext& GetFocusedMidiDeviceContext() const;
+
+private:
+    static constexpr size_t MIDI_INPUT_READER_SLOT = 0;
+    static constexpr size_t ACTION_WORKER_READER_SLOT = 1;
 
 private:
+    // Only used to enumerate ports, every active device opens its own pair
     std::unique_ptr<RtMidiIn> m_MidiIn;
     std::unique_ptr<RtMidiOut> m_MidiOut;
 
 private:
-    std::optional<IEMidiDeviceProfile> m_ActiveMidiDeviceProfile;
-    IESPSCQueue<std::array<uint8_t, MIDI_MESSAGE_BYTE_COUNT>> m_MidiLogMessagesBuffer = IESPSCQueue<std::array<uint8_t, MIDI_MESSAGE_BYTE_COUNT>>(8);
-    std::map<uint32_t, std::function<void(double, const std::array<uint8_t, MIDI_MESSAGE_BYTE_COUNT>)>> m_MidiCallbackFuncs;
+    std::array<std::unique_ptr<IEMidiDeviceContext>, MAX_EVENT_QUEUE_COUNT> m_MidiDeviceContexts;
+    int32_t m_FocusedDeviceIndex = -1;
+    IEMidiSubscriberTable m_MidiCallbacks;
+    IEMidiActionWorker m_ActionWorker;
+    IEMidiCaptureWriter m_CaptureWriter;
+    std::vector<IEMidiPendingCoalescedProperty> m_PendingCoalescedProperties;
+    std::atomic<uint64_t> m_CoalescedUpdateCount = 0;
+    std::atomic<uint64_t> m_TruncatedMessageCount = 0;
+    std::array<std::array<IEMidiLatencyHistogram, static_cast<size_t>(IEMidiLatencyStage::Count)>,
+        static_cast<size_t>(IEMidiActionType::Count)> m_LatencyHistograms;
 
 private:
-    std::unique_ptr<IEAction_Volume> m_VolumeAction;
-    std::unique_ptr<IEAction_Mute> m_MuteAction;
-    std::unique_ptr<IEAction_ConsoleCommand> m_ConsoleCommandAction;
-    std::unique_ptr<IEAction_OpenFile> m_OpenFileAction;
+    std::unique_ptr<IEMidiCommandRunner> m_CommandRunner;
+    std::unique_ptr<IEMidiActionBackend> m_ActionBackend;
+    std::array<bool, static_cast<size_t>(IEMidiActionType::Count)> m_bIsActionSupported = {};
     bool m_bTestMode = false;
 };
 
-template<typename T>
-inline uint32_t IEMidiProcessor::AddOnMidiCallback(T* Object, void(T::* MemFunc)(double, const std::array<uint8_t, MIDI_MESSAGE_BYTE_COUNT>))
+template<auto MemFunc, typename T>
+inline uint32_t IEMidiProcessor::AddOnMidiCallback(T* Object)
 {
-    return AddOnMidiCallback([Object, MemFunc](double Timestamp, const std::array<uint8_t, MIDI_MESSAGE_BYTE_COUNT> MidiMessage)
+    return AddOnMidiCallback([](void* Object, double Timestamp, const IEMidiMessage& MidiMessage)
         {
-            if (Object)
-            {
-                (Object->*MemFunc)(Timestamp, MidiMessage);
-            }
-        });
+            (static_cast<T*>(Object)->*MemFunc)(Timestamp, MidiMessage);
+        }, Object);
 }
\ No newline at end of file
@@ -4,45 +4,88 @@
 
 #include "IEMidiProfileManager.h"
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
 #include "qstandardpaths.h"
 #include "ryml.hpp"
 #include "ryml_std.hpp"
 
-static constexpr char IEMIDI_PROFILES_FILENAME[] = "profiles.yaml";
+static constexpr char IEMIDI_PROFILES_FOLDER_NAME[] = "profiles";
+static constexpr char IEMIDI_PROFILE_INDEX_FILENAME[] = "index.yaml";
+static constexpr char IEMIDI_PROFILE_FILE_EXTENSION[] = ".yaml";
+static constexpr char IEMIDI_LEGACY_PROFILES_FILENAME[] = "profiles.yaml";
+static constexpr char IEMIDI_LEGACY_PROFILES_CACHE_FILENAME[] = "profiles.cache";
+static constexpr char IEMIDI_MIGRATED_FILE_EXTENSION[] = ".migrated";
 static constexpr char MIDI_PROFILE_INPUT_PROPERTIES_NODE_NAME[] = "InputProperties";
 static constexpr char MIDI_PROFILE_OUTPUT_PROPERTIES_NODE_NAME[] = "OutputProperties";
 
 static constexpr char MIDI_MESSAGE_TYPE_KEY_NAME[] = "Midi Message Type";
 static constexpr char MIDI_TOGGLE_KEY_NAME[] = "Midi Toggle";
+static constexpr char MIDI_COALESCE_KEY_NAME[] = "Midi Coalesce";
+static constexpr char MIDI_COALESCE_RATE_KEY_NAME[] = "Midi Coalesce Rate";
 static constexpr char MIDI_ACTION_TYPE_KEY_NAME[] = "Midi Action Type";
 static constexpr char CONSOLE_COMMAND_KEY_NAME[] = "Console Command";
+static constexpr char CONSOLE_COMMAND_PERSISTENT_KEY_NAME[] = "Console Command Persistent";
 static constexpr char OPEN_FILE_PATH_KEY_NAME[] = "Open File Path";
 static constexpr char MIDI_MESSAGE_KEY_NAME[] = "Midi Message";
 
 static constexpr uint32_t INITIAL_TREE_NODE_COUNT = 30;
 static constexpr uint32_t INITIAL_TREE_ARENA_CHAR_COUNT = 2048;
 
-template<typename T, std::size_t N>
-void operator>>(const ryml::ConstNodeRef& Node, std::array<T, N>& Array)
+// Tree and arena sizes seen on the previous parse and emit, so a big store is reserved for in one
+// go instead of growing several times. The start values are a generous guess that only the first
+// parse and emit use, IEMidiProfileStoreBenchmark reports the real densities.
+static std::atomic<size_t> ParsedTreeNodesPerKilobyte = 64;
+static std::atomic<size_t> ParsedTreeArenaCharsPerKilobyte = 1152;
+static std::atomic<size_t> SerializedTreeNodesPerProperty = 16;
+static std::atomic<size_t> SerializedTreeArenaCharsPerProperty = 96;
+
+static void ReserveTree(ryml::Tree& Tree, size_t NodeCount, size_t ArenaCharCount)
+{
+    // An eighth of headroom so a file that grew a little since the last run still fits
+    Tree.reserve(std::max<size_t>(NodeCount + NodeCount / 8, INITIAL_TREE_NODE_COUNT));
+    Tree.reserve_arena(std::max<size_t>(ArenaCharCount + ArenaCharCount / 8, INITIAL_TREE_ARENA_CHAR_COUNT));
+}
+
+static void ParseTree(const std::string& Content, ryml::Tree& Tree)
+{
+    const size_t ContentKilobytes = Content.size() / 1024 + 1;
+    ReserveTree(Tree, ContentKilobytes * ParsedTreeNodesPerKilobyte.load(std::memory_order_relaxed),
+        std::max(Content.size(), ContentKilobytes * ParsedTreeArenaCharsPerKilobyte.load(std::memory_order_relaxed)));
+    ryml::parse_in_arena(ryml::to_csubstr(Content), &Tree);
+
+    if (Content.size() >= 1024)
+    {
+        ParsedTreeNodesPerKilobyte.store(Tree.size() / ContentKilobytes + 1, std::memory_order_relaxed);
+        ParsedTreeArenaCharsPerKilobyte.store(Tree.arena_size() / ContentKilobytes + 1, std::memory_order_relaxed);
+    }
+}
+
+void operator>>(const ryml::ConstNodeRef& Node, IEMidiMessage& MidiMessage)
 {
-    if (Node.is_seq() && Node.num_children() == N)
+    if (Node.is_seq())
     {
-        for (size_t i = 0; i < N; i++)
+        std::vector<uint8_t> Bytes(Node.num_children());
+        for (size_t i = 0; i < Bytes.size(); i++)
         {
-            Node.at(i) >> Array[i];
+            Node.at(i) >> Bytes[i];
         }
+        MidiMessage = IEMidiMessage(Bytes.data(), Bytes.size());
     }
 }
 
-template<typename T, std::size_t N>
-void operator<<(ryml::NodeRef Node, const std::array<T, N>& Array)
+void operator<<(ryml::NodeRef Node, const IEMidiMessage& MidiMessage)
 {
     Node.clear();
     Node |= ryml::SEQ;
 
-    for (const T& Element : Array)
+    for (size_t i = 0; i < MidiMessage.size(); i++)
     {
-        Node.append_child() << Element;
+        Node.append_child() << MidiMessage[i];
     }
 }
 
@@ -58,301 +101,738 @@ void operator<<(ryml::NodeRef Node, const std::filesystem::path& Path)
     Node << Path.string();
 }
 
-IEMidiProfileManager::IEMidiProfileManager()
+static void DeserializeProfile(const ryml::ConstNodeRef& MidiProfileNode, IEMidiDeviceProfile& MidiDeviceProfile)
 {
-    const std::filesystem::path IEMidiConfigFolderPath = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation).toStdString();
-    if (!IEMidiConfigFolderPath.empty())
+    if (MidiProfileNode.has_child(MIDI_PROFILE_INPUT_PROPERTIES_NODE_NAME))
+    {
+        const ryml::ConstNodeRef MidiProfileInputPropertiesNode = MidiProfileNode[MIDI_PROFILE_INPUT_PROPERTIES_NODE_NAME];
+        MidiDeviceProfile.InputProperties.Reserve(MidiDeviceProfile.InputProperties.Size() + MidiProfileInputPropertiesNode.num_children());
+        for (int ChildPos = 0; ChildPos < MidiProfileInputPropertiesNode.num_children(); ChildPos++)
+        {
+            const ryml::ConstNodeRef MidiProfileInputPropertyNode = MidiProfileInputPropertiesNode.at(ChildPos);
+            IEMidiDeviceInputProperty& MidiDeviceInputProperty = MidiDeviceProfile.MakeInputProperty();
+
+            if (MidiProfileInputPropertyNode.has_child(MIDI_MESSAGE_TYPE_KEY_NAME))
+            {
+                uint8_t MidiMessageType = 0;
+                MidiProfileInputPropertyNode[MIDI_MESSAGE_TYPE_KEY_NAME] >> MidiMessageType;
+                MidiDeviceInputProperty.MidiMessageType = static_cast<IEMidiMessageType>(MidiMessageType);
+            }
+
+            if (MidiProfileInputPropertyNode.has_child(MIDI_TOGGLE_KEY_NAME))
+            {
+                MidiProfileInputPropertyNode[MIDI_TOGGLE_KEY_NAME] >> MidiDeviceInputProperty.bIsMidiToggle;
+            }
+
+            if (MidiProfileInputPropertyNode.has_child(MIDI_COALESCE_KEY_NAME))
+            {
+                MidiProfileInputPropertyNode[MIDI_COALESCE_KEY_NAME] >> MidiDeviceInputProperty.bIsCoalesced;
+            }
+
+            if (MidiProfileInputPropertyNode.has_child(MIDI_COALESCE_RATE_KEY_NAME))
+            {
+                MidiProfileInputPropertyNode[MIDI_COALESCE_RATE_KEY_NAME] >> MidiDeviceInputProperty.CoalesceRateHz;
+            }
+
+            if (MidiProfileInputPropertyNode.has_child(MIDI_ACTION_TYPE_KEY_NAME))
+            {
+                uint8_t MidiActionType = 0;
+                MidiProfileInputPropertyNode[MIDI_ACTION_TYPE_KEY_NAME] >> MidiActionType;
+                MidiDeviceInputProperty.MidiActionType = static_cast<IEMidiActionType>(MidiActionType);
+            }
+
+            if (MidiProfileInputPropertyNode.has_child(CONSOLE_COMMAND_KEY_NAME))
+            {
+                if (!MidiProfileInputPropertyNode[CONSOLE_COMMAND_KEY_NAME].val().empty())
+                {
+                    MidiProfileInputPropertyNode[CONSOLE_COMMAND_KEY_NAME] >> MidiDeviceInputProperty.ConsoleCommand;
+                }
+            }
+
+            if (MidiProfileInputPropertyNode.has_child(CONSOLE_COMMAND_PERSISTENT_KEY_NAME))
+            {
+                MidiProfileInputPropertyNode[CONSOLE_COMMAND_PERSISTENT_KEY_NAME] >> MidiDeviceInputProperty.bIsConsoleCommandPersistent;
+            }
+
+            if (MidiProfileInputPropertyNode.has_child(OPEN_FILE_PATH_KEY_NAME))
+            {
+                if (!MidiProfileInputPropertyNode[OPEN_FILE_PATH_KEY_NAME].val().empty())
+                {
+                    MidiProfileInputPropertyNode[OPEN_FILE_PATH_KEY_NAME] >> MidiDeviceInputProperty.OpenFilePath;
+                }
+            }
+
+            if (MidiProfileInputPropertyNode.has_child(MIDI_MESSAGE_KEY_NAME))
+            {
+                MidiProfileInputPropertyNode[MIDI_MESSAGE_KEY_NAME] >> MidiDeviceInputProperty.MidiMessage;
+            }
+        }
+    }
+
+    if (MidiProfileNode.has_child(MIDI_PROFILE_OUTPUT_PROPERTIES_NODE_NAME))
     {
-        const std::filesystem::path MidiProfilesFilePath = IEMidiConfigFolderPath / IEMIDI_PROFILES_FILENAME;
-        const std::string ProfilesFilePathString = MidiProfilesFilePath.string();
-        if (!std::filesystem::exists(MidiProfilesFilePath))
+        const ryml::ConstNodeRef MidiProfileOutputPropertiesNode = MidiProfileNode[MIDI_PROFILE_OUTPUT_PROPERTIES_NODE_NAME];
+        MidiDeviceProfile.OutputProperties.Reserve(MidiDeviceProfile.OutputProperties.Size() + MidiProfileOutputPropertiesNode.num_children());
+        for (int ChildPos = 0; ChildPos < MidiProfileOutputPropertiesNode.num_children(); ChildPos++)
         {
-            if (std::FILE* const ProfilesFile = std::fopen(ProfilesFilePathString.c_str(), "w"))
+            const ryml::ConstNodeRef MidiProfileOutputPropertyNode = MidiProfileOutputPropertiesNode.at(ChildPos);
+            IEMidiDeviceOutputProperty& MidiDeviceOutputProperty = MidiDeviceProfile.MakeOutputProperty();
+
+            if (MidiProfileOutputPropertyNode.has_child(MIDI_MESSAGE_KEY_NAME))
             {
-                IELOG_SUCCESS("Successfully created profiles settings file %s", ProfilesFilePathString.c_str());
+                MidiProfileOutputPropertyNode[MIDI_MESSAGE_KEY_NAME] >> MidiDeviceOutputProperty.MidiMessage;
             }
         }
-        IELOG_SUCCESS("Using profiles settings file %s", ProfilesFilePathString.c_str());
     }
 }
 
-std::filesystem::path IEMidiProfileManager::GetIEMidiProfilesFilePath() const
+static void SerializeProfile(ryml::NodeRef MidiProfileNode, const IEMidiDeviceProfile& MidiDeviceProfile)
 {
-    std::filesystem::path MidiDeviceProfilesFilePath;
-    const std::filesystem::path IEMidiConfigFolderPath = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation).toStdString();
-    if (!std::filesystem::exists(IEMidiConfigFolderPath))
+    // Input properties serialization
     {
-        std::filesystem::create_directories(IEMidiConfigFolderPath);
+        ryml::NodeRef MidiProfileInputPropertiesNode = MidiProfileNode[MIDI_PROFILE_INPUT_PROPERTIES_NODE_NAME];
+        if (MidiProfileInputPropertiesNode.is_seed())
+        {
+            MidiProfileInputPropertiesNode.create();
+            MidiProfileInputPropertiesNode |= ryml::SEQ;
+        }
+        MidiProfileInputPropertiesNode.clear_children();
+        for (const IEMidiDeviceInputProperty& MidiDeviceInputProperty : MidiDeviceProfile.InputProperties)
+        {
+            ryml::NodeRef MidiProfileInputPropertyNode = MidiProfileInputPropertiesNode.append_child();
+            MidiProfileInputPropertyNode.create();
+            MidiProfileInputPropertyNode |= ryml::MAP;
+
+            MidiProfileInputPropertyNode[MIDI_MESSAGE_TYPE_KEY_NAME] << static_cast<uint8_t>(MidiDeviceInputProperty.MidiMessageType);
+            MidiProfileInputPropertyNode[MIDI_TOGGLE_KEY_NAME] << MidiDeviceInputProperty.bIsMidiToggle;
+            MidiProfileInputPropertyNode[MIDI_COALESCE_KEY_NAME] << MidiDeviceInputProperty.bIsCoalesced;
+            MidiProfileInputPropertyNode[MIDI_COALESCE_RATE_KEY_NAME] << MidiDeviceInputProperty.CoalesceRateHz;
+            MidiProfileInputPropertyNode[MIDI_ACTION_TYPE_KEY_NAME] << static_cast<uint8_t>(MidiDeviceInputProperty.MidiActionType);
+            MidiProfileInputPropertyNode[CONSOLE_COMMAND_KEY_NAME] << MidiDeviceInputProperty.ConsoleCommand;
+            MidiProfileInputPropertyNode[CONSOLE_COMMAND_PERSISTENT_KEY_NAME] << MidiDeviceInputProperty.bIsConsoleCommandPersistent;
+            MidiProfileInputPropertyNode[OPEN_FILE_PATH_KEY_NAME] << MidiDeviceInputProperty.OpenFilePath;
+            MidiProfileInputPropertyNode[MIDI_MESSAGE_KEY_NAME] << MidiDeviceInputProperty.MidiMessage;
+            // Other input properties go here
+        }
     }
 
-    if (std::filesystem::exists(IEMidiConfigFolderPath))
+    // Output properties serialization
     {
-        const std::filesystem::path PotentialMidiDeviceProfilesFilePath = IEMidiConfigFolderPath / IEMIDI_PROFILES_FILENAME;
-        if (std::filesystem::exists(PotentialMidiDeviceProfilesFilePath))
+        ryml::NodeRef MidiProfileOutputPropertiesNode = MidiProfileNode[MIDI_PROFILE_OUTPUT_PROPERTIES_NODE_NAME];
+        if (MidiProfileOutputPropertiesNode.is_seed())
         {
-            MidiDeviceProfilesFilePath = PotentialMidiDeviceProfilesFilePath;
+            MidiProfileOutputPropertiesNode.create();
+            MidiProfileOutputPropertiesNode |= ryml::SEQ;
+        }
+        MidiProfileOutputPropertiesNode.clear_children();
+        for (const IEMidiDeviceOutputProperty& MidiDeviceOutputProperty : MidiDeviceProfile.OutputProperties)
+        {
+            ryml::NodeRef MidiProfileOutputPropertyNode = MidiProfileOutputPropertiesNode.append_child();
+            MidiProfileOutputPropertyNode.create();
+            MidiProfileOutputPropertyNode |= ryml::MAP;
+
+            MidiProfileOutputPropertyNode[MIDI_MESSAGE_KEY_NAME] << MidiDeviceOutputProperty.MidiMessage;
+            // Other Output properties go here
         }
     }
-    return MidiDeviceProfilesFilePath;
 }
 
-bool IEMidiProfileManager::HasProfile(const IEMidiDeviceProfile& MidiDeviceProfile) const
+static std::string SerializeProfileFile(const IEMidiDeviceProfile& MidiDeviceProfile)
 {
-    bool bHasProfile = false;
+    const size_t PropertyCount = MidiDeviceProfile.InputProperties.Size() + MidiDeviceProfile.OutputProperties.Size() + 1;
 
-    const std::filesystem::path MidiProfilesFilePath = GetIEMidiProfilesFilePath();
-    if (std::filesystem::exists(MidiProfilesFilePath))
-    {
-        const std::string Content = ExtractFileContent(MidiProfilesFilePath);
+    ryml::Tree MidiProfileTree;
+    ReserveTree(MidiProfileTree, PropertyCount * SerializedTreeNodesPerProperty.load(std::memory_order_relaxed),
+        PropertyCount * SerializedTreeArenaCharsPerProperty.load(std::memory_order_relaxed));
+
+    ryml::NodeRef Root = MidiProfileTree.rootref();
+    Root |= ryml::MAP;
+    ryml::NodeRef MidiProfileNode = Root.append_child();
+    MidiProfileNode << ryml::key(MidiDeviceProfile.NameID);
+    MidiProfileNode |= ryml::MAP;
+    SerializeProfile(MidiProfileNode, MidiDeviceProfile);
 
-        ryml::Tree MidiProfilesTree;
-        MidiProfilesTree.reserve(INITIAL_TREE_NODE_COUNT);
-        MidiProfilesTree.reserve_arena(INITIAL_TREE_ARENA_CHAR_COUNT);
-        ryml::parse_in_arena(ryml::to_csubstr(Content), &MidiProfilesTree);
+    SerializedTreeNodesPerProperty.store(MidiProfileTree.size() / PropertyCount + 1, std::memory_order_relaxed);
+    SerializedTreeArenaCharsPerProperty.store(MidiProfileTree.arena_size() / PropertyCount + 1, std::memory_order_relaxed);
+
+    // Emit writes into the current size and only emits a second time when the text does not fit
+    std::string Content;
+    Content.resize(MidiProfileTree.arena_size() + MidiProfileTree.size() * 8);
+    ryml::emitrs_yaml(MidiProfileTree, &Content);
+    return Content;
+}
 
-        const ryml::ConstNodeRef Root = MidiProfilesTree.rootref();
-        if (Root.is_map())
+IEMidiProfileManager::IEMidiProfileManager()
+{
+    const std::filesystem::path IEMidiConfigFolderPath = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation).toStdString();
+    if (!IEMidiConfigFolderPath.empty())
+    {
+        const std::filesystem::path ProfilesFolderPath = IEMidiConfigFolderPath / IEMIDI_PROFILES_FOLDER_NAME;
+        std::error_code ErrorCode;
+        std::filesystem::create_directories(ProfilesFolderPath, ErrorCode);
+        if (std::filesystem::exists(ProfilesFolderPath))
         {
-            if (Root.has_child(MidiDeviceProfile.NameID.c_str()))
+            m_ProfilesFolderPath = ProfilesFolderPath;
+            m_ProfileIndexFilePath = ProfilesFolderPath / IEMIDI_PROFILE_INDEX_FILENAME;
+            IELOG_SUCCESS("Using profiles folder %s", m_ProfilesFolderPath.string().c_str());
+
+            const std::filesystem::path LegacyProfilesFilePath = IEMidiConfigFolderPath / IEMIDI_LEGACY_PROFILES_FILENAME;
+            if (!std::filesystem::exists(m_ProfileIndexFilePath) && std::filesystem::exists(LegacyProfilesFilePath))
             {
-                bHasProfile = true;
+                MigrateLegacyProfilesFile(LegacyProfilesFilePath);
             }
+
+            RefreshProfileIndex();
+            ValidateProfileFiles();
         }
     }
-    
-    return bHasProfile;
 }
 
-IEResult IEMidiProfileManager::SaveProfile(const IEMidiDeviceProfile& MidiDeviceProfile) const
+IEMidiProfileManager::~IEMidiProfileManager()
+{
+    // Batches still committing write through the persister, which is destroyed with the manager
+    WaitForProfileBatchCommits();
+}
+
+std::filesystem::path IEMidiProfileManager::GetIEMidiProfilesFolderPath() const
+{
+    return m_ProfilesFolderPath;
+}
+
+std::filesystem::path IEMidiProfileManager::GetIEMidiProfileFilePath(const std::string& MidiDeviceName)
+{
+    std::scoped_lock Lock(m_Mutex);
+    RefreshProfileIndex();
+    const auto ProfileFileNameIt = m_ProfileFileNames.find(MidiDeviceName);
+    return ProfileFileNameIt != m_ProfileFileNames.end() ? GetProfileFilePath(ProfileFileNameIt->second) : std::filesystem::path();
+}
+
+bool IEMidiProfileManager::HasProfile(const IEMidiDeviceProfile& MidiDeviceProfile)
+{
+    std::scoped_lock Lock(m_Mutex);
+    RefreshProfileIndex();
+    return m_ProfileFileNames.contains(MidiDeviceProfile.NameID);
+}
+
+IEResult IEMidiProfileManager::SaveProfile(const IEMidiDeviceProfile& MidiDeviceProfile)
 {
     IEResult Result(IEResult::Type::Fail, "Failed to save profile");
 
-    const std::filesystem::path MidiProfilesFilePath = GetIEMidiProfilesFilePath();
-    if (std::filesystem::exists(MidiProfilesFilePath))
+    if (!m_ProfilesFolderPath.empty())
     {
-        if (std::FILE* const ProfilesFile = std::fopen(MidiProfilesFilePath.string().c_str(), "w"))
+        std::string Content = SerializeProfileFile(MidiDeviceProfile);
+        if (!Content.empty())
         {
-            const std::string Content = ExtractFileContent(MidiProfilesFilePath);
-
-            ryml::Tree MidiProfilesTree;
-            MidiProfilesTree.reserve(INITIAL_TREE_NODE_COUNT);
-            MidiProfilesTree.reserve_arena(INITIAL_TREE_ARENA_CHAR_COUNT);
-            ryml::parse_in_arena(ryml::to_csubstr(Content), &MidiProfilesTree);
+            // Only this device's file is written, other devices and other instances are left untouched
+            std::scoped_lock Lock(m_Mutex);
+            RefreshProfileIndex();
+            auto [ProfileFileNameIt, bIsNewProfile] = m_ProfileFileNames.try_emplace(MidiDeviceProfile.NameID);
+            if (bIsNewProfile)
+            {
+                ProfileFileNameIt->second = MakeProfileFileName(MidiDeviceProfile.NameID);
+            }
 
-            ryml::NodeRef Root = MidiProfilesTree.rootref();
-            if (!Root.is_map() && Root.empty())
+            const std::filesystem::path ProfileFilePath = GetProfileFilePath(ProfileFileNameIt->second);
+            if (const auto UndecidedFilePathIt = m_UndecidedProfileFilePaths.find(MidiDeviceProfile.NameID);
+                UndecidedFilePathIt != m_UndecidedProfileFilePaths.end() && UndecidedFilePathIt->second != ProfileFilePath)
+            {
+                m_ProfilePersister.Schedule(UndecidedFilePathIt->second, Content, false);
+            }
+            m_ProfilePersister.Schedule(ProfileFilePath, std::move(Content));
+            if (bIsNewProfile)
             {
-                Root |= ryml::MAP;
+                ScheduleProfileIndexSave();
             }
 
-            const char* MidiDeviceName = MidiDeviceProfile.NameID.c_str();
-            ryml::NodeRef MidiProfileNode = Root[MidiDeviceName];
-            if (MidiProfileNode.is_seed())
+            Result.Type = IEResult::Type::Success;
+            Result.Message = std::format("Scheduled saving profile {}, into {}", MidiDeviceProfile.NameID, ProfileFilePath.string());
+        }
+    }
+    return Result;
+}
+
+IEResult IEMidiProfileManager::LoadProfile(IEMidiDeviceProfile& MidiDeviceProfile)
+{
+    IEResult Result(IEResult::Type::Fail, "Failed to load profile");
+
+    std::filesystem::path ProfileFilePath;
+    {
+        std::scoped_lock Lock(m_Mutex);
+        RefreshProfileIndex();
+        if (const auto ProfileFileNameIt = m_ProfileFileNames.find(MidiDeviceProfile.NameID); ProfileFileNameIt != m_ProfileFileNames.end())
+        {
+            ProfileFilePath = GetProfileFilePath(ProfileFileNameIt->second);
+        }
+    }
+
+    if (!ProfileFilePath.empty())
+    {
+        // A save that has not landed yet is newer than the file on disk
+        if (const std::optional<std::string> PendingContent = m_ProfilePersister.GetPendingContent(ProfileFilePath))
+        {
+            Result = LoadProfileContent(*PendingContent, ProfileFilePath, MidiDeviceProfile);
+        }
+        else
+        {
+            Result = LoadProfileFile(ProfileFilePath, MidiDeviceProfile);
+        }
+    }
+    return Result;
+}
+
+IEResult IEMidiProfileManager::RemoveProfile(const IEMidiDeviceProfile& MidiDeviceProfile)
+{
+    IEMidiProfileBatch ProfileBatch;
+    ProfileBatch.RemoveProfile(MidiDeviceProfile.NameID);
+    return CommitProfileBatch(ProfileBatch);
+}
+
+IEResult IEMidiProfileManager::CommitProfileBatch(const IEMidiProfileBatch& ProfileBatch)
+{
+    return CommitSerializedProfileBatch(SerializeProfileBatch(ProfileBatch));
+}
+
+void IEMidiProfileManager::CommitProfileBatchAsync(const IEMidiProfileBatch& ProfileBatch, std::function<void(const IEResult&)> OnCommitted)
+{
+    IESerializedProfileBatch SerializedProfileBatch = SerializeProfileBatch(ProfileBatch);
+
+    std::scoped_lock Lock(m_Mutex);
+    m_LastProfileBatchCommit = std::async(std::launch::async, [this, PreviousProfileBatchCommit = m_LastProfileBatchCommit,
+        SerializedProfileBatch = std::move(SerializedProfileBatch), OnCommitted = std::move(OnCommitted)]()
+        {
+            if (PreviousProfileBatchCommit.valid())
             {
-                MidiProfileNode.create();
-                MidiProfileNode |= ryml::MAP;
+                PreviousProfileBatchCommit.wait();
             }
+            const IEResult Result = CommitSerializedProfileBatch(SerializedProfileBatch);
+            if (OnCommitted)
+            {
+                OnCommitted(Result);
+            }
+        }).share();
+}
+
+void IEMidiProfileManager::SetOnProfilesSavedCallback(std::function<void(const IEResult&)> Func)
+{
+    m_ProfilePersister.SetCompletionCallback(std::move(Func));
+}
+
+void IEMidiProfileManager::FlushPendingSaves()
+{
+    WaitForProfileBatchCommits();
+    m_ProfilePersister.Flush();
+}
+
+IEResult IEMidiProfileManager::CommitSerializedProfileBatch(const IESerializedProfileBatch& SerializedProfileBatch)
+{
+    IEResult Result(IEResult::Type::Fail, "Failed to commit profile batch");
+
+    if (m_ProfilesFolderPath.empty())
+    {
+        return Result;
+    }
+
+    const std::scoped_lock CommitLock(m_CommitMutex);
+
+    // Saved profiles go to files the current index does not point to, the index write that follows is
+    // the single step that makes the whole batch visible. Earlier saves do not have to land first, the
+    // persister writes every file in the order it was scheduled.
+    std::unordered_map<std::string, std::string> StagedProfileFileNames;
+    std::unordered_map<std::string, IEMidiProfilePersister::IEWriteToken> StagedWriteTokens;
+    {
+        std::scoped_lock Lock(m_Mutex);
+        RefreshProfileIndex();
+        for (const auto& [MidiDeviceName, Content] : SerializedProfileBatch.SavedProfileContents)
+        {
+            const auto ProfileFileNameIt = m_ProfileFileNames.find(MidiDeviceName);
+            const std::string CurrentProfileFileName = MakeProfileFileName(MidiDeviceName);
+            const bool bIsCurrentRevision = ProfileFileNameIt != m_ProfileFileNames.end() && ProfileFileNameIt->second == CurrentProfileFileName;
+            const std::string& StagedProfileFileName = StagedProfileFileNames[MidiDeviceName] =
+                bIsCurrentRevision ? MakeProfileFileName(MidiDeviceName, 1) : CurrentProfileFileName;
+
+            const std::filesystem::path StagedFilePath = GetProfileFilePath(StagedProfileFileName);
+            StagedWriteTokens[MidiDeviceName] = m_ProfilePersister.ScheduleNow(StagedFilePath, Content);
+            m_UndecidedProfileFilePaths[MidiDeviceName] = StagedFilePath;
+        }
+    }
+
+    std::filesystem::path FailedFilePath;
+    for (const auto& [MidiDeviceName, StagedWriteToken] : StagedWriteTokens)
+    {
+        if (!StagedWriteToken.get() && FailedFilePath.empty())
+        {
+            FailedFilePath = GetProfileFilePath(StagedProfileFileNames[MidiDeviceName]);
+        }
+    }
 
-            // Input properties serialization
+    std::unordered_map<std::string, std::string> PreviousProfileFileNames;
+    IEMidiProfilePersister::IEWriteToken ProfileIndexWriteToken;
+    {
+        std::scoped_lock Lock(m_Mutex);
+        if (!FailedFilePath.empty())
+        {
+            for (const auto& [MidiDeviceName, StagedProfileFileName] : StagedProfileFileNames)
             {
-                ryml::NodeRef MidiProfileInputPropertiesNode = MidiProfileNode[MIDI_PROFILE_INPUT_PROPERTIES_NODE_NAME];
-                if (MidiProfileInputPropertiesNode.is_seed())
-                {
-                    MidiProfileInputPropertiesNode.create();
-                    MidiProfileInputPropertiesNode |= ryml::SEQ;
-                }
-                MidiProfileInputPropertiesNode.clear_children();
-                IEMidiDeviceInputProperty* MidiDeviceInputProperty = MidiDeviceProfile.InputPropertiesHead.get();
-                while (MidiDeviceInputProperty)
-                {
-                    ryml::NodeRef MidiProfileInputPropertyNode = MidiProfileInputPropertiesNode.append_child();
-                    MidiProfileInputPropertyNode.create();
-                    MidiProfileInputPropertyNode |= ryml::MAP;
-
-                    MidiProfileInputPropertyNode[MIDI_MESSAGE_TYPE_KEY_NAME] << static_cast<uint8_t>(MidiDeviceInputProperty->MidiMessageType);
-                    MidiProfileInputPropertyNode[MIDI_TOGGLE_KEY_NAME] << MidiDeviceInputProperty->bIsMidiToggle;
-                    MidiProfileInputPropertyNode[MIDI_ACTION_TYPE_KEY_NAME] << static_cast<uint8_t>(MidiDeviceInputProperty->MidiActionType);
-                    MidiProfileInputPropertyNode[CONSOLE_COMMAND_KEY_NAME] << MidiDeviceInputProperty->ConsoleCommand;
-                    MidiProfileInputPropertyNode[OPEN_FILE_PATH_KEY_NAME] << MidiDeviceInputProperty->OpenFilePath;
-                    MidiProfileInputPropertyNode[MIDI_MESSAGE_KEY_NAME] << MidiDeviceInputProperty->MidiMessage;
-                    // Other input properties go here
-
-                    MidiDeviceInputProperty = MidiDeviceInputProperty->Next();
-                }
+                m_UndecidedProfileFilePaths.erase(MidiDeviceName);
+                m_ProfilePersister.ScheduleRemoval(GetProfileFilePath(StagedProfileFileName));
             }
+            Result.Message = std::format("Failed to commit profile batch, could not write {}", FailedFilePath.string());
+            return Result;
+        }
 
-            // Output properties serialization
+        // Until the index write is known to have landed, saves also reach the previous file so a failed
+        // switch loses none of them
+        RefreshProfileIndex();
+        PreviousProfileFileNames = m_ProfileFileNames;
+        for (const auto& [MidiDeviceName, StagedProfileFileName] : StagedProfileFileNames)
+        {
+            std::string& ProfileFileName = m_ProfileFileNames[MidiDeviceName];
+            if (ProfileFileName.empty())
             {
-                ryml::NodeRef MidiProfileOutputPropertiesNode = MidiProfileNode[MIDI_PROFILE_OUTPUT_PROPERTIES_NODE_NAME];
-                if (MidiProfileOutputPropertiesNode.is_seed())
-                {
-                    MidiProfileOutputPropertiesNode.create();
-                    MidiProfileOutputPropertiesNode |= ryml::SEQ;
-                }
-                MidiProfileOutputPropertiesNode.clear_children();
-                IEMidiDeviceOutputProperty* MidiDeviceOutputProperty = MidiDeviceProfile.OutputPropertiesHead.get();
-                while (MidiDeviceOutputProperty)
-                {
-                    ryml::NodeRef MidiProfileOutputPropertyNode = MidiProfileOutputPropertiesNode.append_child();
-                    MidiProfileOutputPropertyNode.create();
-                    MidiProfileOutputPropertyNode |= ryml::MAP;
+                m_UndecidedProfileFilePaths.erase(MidiDeviceName);
+            }
+            else
+            {
+                m_UndecidedProfileFilePaths[MidiDeviceName] = GetProfileFilePath(ProfileFileName);
+            }
+            ProfileFileName = StagedProfileFileName;
+        }
+        for (const std::string& MidiDeviceName : SerializedProfileBatch.RemovedMidiDeviceNames)
+        {
+            m_ProfileFileNames.erase(MidiDeviceName);
+        }
+        ProfileIndexWriteToken = m_ProfilePersister.ScheduleNow(m_ProfileIndexFilePath, SerializeProfileIndex());
+    }
 
-                    MidiProfileOutputPropertyNode[MIDI_MESSAGE_KEY_NAME] << MidiDeviceOutputProperty->MidiMessage;
-                    // Other Output properties go here
+    const bool bIsProfileIndexWritten = static_cast<bool>(ProfileIndexWriteToken.get());
 
-                    MidiDeviceOutputProperty = MidiDeviceOutputProperty->Next();
-                }
-            }
+    std::scoped_lock Lock(m_Mutex);
+    for (const auto& [MidiDeviceName, StagedProfileFileName] : StagedProfileFileNames)
+    {
+        m_UndecidedProfileFilePaths.erase(MidiDeviceName);
+    }
 
-            const size_t EmitSize = ryml::emit_yaml(MidiProfilesTree, ProfilesFile);
-            if (EmitSize)
+    if (!bIsProfileIndexWritten)
+    {
+        // The index on disk still points to the previous files, which are left as they were
+        for (const auto& [MidiDeviceName, StagedProfileFileName] : StagedProfileFileNames)
+        {
+            if (const auto PreviousProfileFileNameIt = PreviousProfileFileNames.find(MidiDeviceName); PreviousProfileFileNameIt != PreviousProfileFileNames.end())
             {
-                Result.Type = IEResult::Type::Success;
-                Result.Message = std::format("Successfully saved profile {}, into {}", MidiDeviceName, MidiProfilesFilePath.string());
+                m_ProfileFileNames[MidiDeviceName] = PreviousProfileFileNameIt->second;
             }
+            else
+            {
+                m_ProfileFileNames.erase(MidiDeviceName);
+            }
+            m_ProfilePersister.ScheduleRemoval(GetProfileFilePath(StagedProfileFileName));
+        }
+        for (const std::string& MidiDeviceName : SerializedProfileBatch.RemovedMidiDeviceNames)
+        {
+            if (const auto PreviousProfileFileNameIt = PreviousProfileFileNames.find(MidiDeviceName); PreviousProfileFileNameIt != PreviousProfileFileNames.end())
+            {
+                m_ProfileFileNames.emplace(MidiDeviceName, PreviousProfileFileNameIt->second);
+            }
+        }
+
+        // Devices added while the batch was undecided are kept
+        ScheduleProfileIndexSave();
+        Result.Message = std::format("Failed to commit profile batch, could not write {}", m_ProfileIndexFilePath.string());
+        return Result;
+    }
+    m_ProfileIndexFileStamp = m_ProfilePersister.GetLastWrittenStamp(m_ProfileIndexFilePath).value_or(m_ProfileIndexFileStamp);
 
-            std::fclose(ProfilesFile);
+    // Files the new index no longer refers to are now unreachable, removing them drops the saves that
+    // still went to them
+    const auto RemoveUnreachableProfileFile = [this](const std::string& MidiDeviceName, const std::string& ProfileFileName)
+        {
+            const auto ProfileFileNameIt = m_ProfileFileNames.find(MidiDeviceName);
+            if (ProfileFileNameIt == m_ProfileFileNames.end() || ProfileFileNameIt->second != ProfileFileName)
+            {
+                m_ProfilePersister.ScheduleRemoval(GetProfileFilePath(ProfileFileName));
+            }
+        };
+    for (const auto& [MidiDeviceName, StagedProfileFileName] : StagedProfileFileNames)
+    {
+        RemoveUnreachableProfileFile(MidiDeviceName, StagedProfileFileName);
+    }
+    for (const auto& [MidiDeviceName, PreviousProfileFileName] : PreviousProfileFileNames)
+    {
+        if (StagedProfileFileNames.contains(MidiDeviceName) ||
+            std::find(SerializedProfileBatch.RemovedMidiDeviceNames.begin(), SerializedProfileBatch.RemovedMidiDeviceNames.end(), MidiDeviceName) !=
+            SerializedProfileBatch.RemovedMidiDeviceNames.end())
+        {
+            RemoveUnreachableProfileFile(MidiDeviceName, PreviousProfileFileName);
         }
     }
+
+    Result.Type = IEResult::Type::Success;
+    Result.Message = std::format("Successfully committed profile batch, {} saved, {} removed",
+        StagedProfileFileNames.size(), SerializedProfileBatch.RemovedMidiDeviceNames.size());
     return Result;
 }
 
-IEResult IEMidiProfileManager::LoadProfile(IEMidiDeviceProfile& MidiDeviceProfile) const
+void IEMidiProfileManager::WaitForProfileBatchCommits() const
 {
-    IEResult Result(IEResult::Type::Fail, "Failed to load profile");
+    std::shared_future<void> LastProfileBatchCommit;
+    {
+        std::scoped_lock Lock(m_Mutex);
+        LastProfileBatchCommit = m_LastProfileBatchCommit;
+    }
 
-    const std::filesystem::path MidiProfilesFilePath = GetIEMidiProfilesFilePath();
-    if (std::filesystem::exists(MidiProfilesFilePath))
+    // Each commit waits for the one before it
+    if (LastProfileBatchCommit.valid())
     {
-        Result.Type = IEResult::Type::Success;
-        Result.Message = std::format("Successfully found profiles config file {}", MidiProfilesFilePath.string());
+        LastProfileBatchCommit.wait();
+    }
+}
 
-        const std::string Content = ExtractFileContent(MidiProfilesFilePath);
+void IEMidiProfileManager::MigrateLegacyProfilesFile(const std::filesystem::path& LegacyProfilesFilePath)
+{
+    const std::string Content = ExtractFileContent(LegacyProfilesFilePath);
 
-        ryml::Tree MidiProfilesTree;
-        MidiProfilesTree.reserve(INITIAL_TREE_NODE_COUNT);
-        MidiProfilesTree.reserve_arena(INITIAL_TREE_ARENA_CHAR_COUNT);
-        ryml::parse_in_arena(ryml::to_csubstr(Content), &MidiProfilesTree);
+    ryml::Tree MidiProfilesTree;
+    ParseTree(Content, MidiProfilesTree);
 
-        const ryml::ConstNodeRef Root = MidiProfilesTree.rootref();
-        if (Root.is_map() && Root.has_child(MidiDeviceProfile.NameID.c_str()))
+    const ryml::ConstNodeRef Root = MidiProfilesTree.rootref();
+    if (Root.is_map())
+    {
+        for (const ryml::ConstNodeRef MidiProfileNode : Root.children())
         {
-            const ryml::ConstNodeRef MidiProfileNode = Root[MidiDeviceProfile.NameID.c_str()];
+            const ryml::csubstr MidiDeviceNameKey = MidiProfileNode.key();
+            const std::string MidiDeviceName(MidiDeviceNameKey.data(), MidiDeviceNameKey.size());
+
+            IEMidiDeviceProfile MidiDeviceProfile(MidiDeviceName, 0, 0);
+            DeserializeProfile(MidiProfileNode, MidiDeviceProfile);
+
+            const std::string ProfileFileName = MakeProfileFileName(MidiDeviceName);
+            m_ProfilePersister.Schedule(GetProfileFilePath(ProfileFileName), SerializeProfileFile(MidiDeviceProfile), false);
+            m_ProfileFileNames.emplace(MidiDeviceName, ProfileFileName);
+        }
+    }
+
+    ScheduleProfileIndexSave();
+    m_ProfilePersister.Flush();
+
+    // The old file is kept aside rather than deleted, the index marks the migration as done
+    if (std::filesystem::exists(m_ProfileIndexFilePath))
+    {
+        std::error_code ErrorCode;
+        std::filesystem::path MigratedProfilesFilePath = LegacyProfilesFilePath;
+        MigratedProfilesFilePath += IEMIDI_MIGRATED_FILE_EXTENSION;
+        std::filesystem::rename(LegacyProfilesFilePath, MigratedProfilesFilePath, ErrorCode);
+        std::filesystem::remove(LegacyProfilesFilePath.parent_path() / IEMIDI_LEGACY_PROFILES_CACHE_FILENAME, ErrorCode);
+        IELOG_SUCCESS("Migrated %zu profile(s) from %s into %s", m_ProfileFileNames.size(),
+            LegacyProfilesFilePath.string().c_str(), m_ProfilesFolderPath.string().c_str());
+    }
+    else
+    {
+        IELOG_ERROR("Failed to migrate profiles from %s", LegacyProfilesFilePath.string().c_str());
+    }
+}
 
-            if (MidiProfileNode.has_child(MIDI_PROFILE_INPUT_PROPERTIES_NODE_NAME))
+void IEMidiProfileManager::ValidateProfileFiles()
+{
+    const std::chrono::steady_clock::time_point ValidationStartTime = std::chrono::steady_clock::now();
+
+    std::vector<std::pair<std::string, std::filesystem::path>> ProfileFiles;
+    ProfileFiles.reserve(m_ProfileFileNames.size());
+    for (const auto& [MidiDeviceName, ProfileFileName] : m_ProfileFileNames)
+    {
+        ProfileFiles.emplace_back(MidiDeviceName, GetProfileFilePath(ProfileFileName));
+    }
+
+    std::vector<IEResult> Results(ProfileFiles.size(), IEResult(IEResult::Type::Fail));
+    std::atomic<size_t> NextProfileFileIndex = 0;
+    const auto ValidateNextProfileFiles = [&ProfileFiles, &Results, &NextProfileFileIndex]()
+        {
+            for (size_t i = NextProfileFileIndex++; i < ProfileFiles.size(); i = NextProfileFileIndex++)
             {
-                const ryml::ConstNodeRef MidiProfileInputPropertiesNode = MidiProfileNode[MIDI_PROFILE_INPUT_PROPERTIES_NODE_NAME];
-                for (int ChildPos = 0; ChildPos < MidiProfileInputPropertiesNode.num_children(); ChildPos++)
-                {
-                    const ryml::ConstNodeRef MidiProfileInputPropertyNode = MidiProfileInputPropertiesNode.at(ChildPos);
-                    IEMidiDeviceInputProperty& MidiDeviceInputProperty = MidiDeviceProfile.MakeInputProperty();
-
-                    if (MidiProfileInputPropertyNode.has_child(MIDI_MESSAGE_TYPE_KEY_NAME))
-                    {
-                        uint8_t MidiMessageType = 0;
-                        MidiProfileInputPropertyNode[MIDI_MESSAGE_TYPE_KEY_NAME] >> MidiMessageType;
-                        MidiDeviceInputProperty.MidiMessageType = static_cast<IEMidiMessageType>(MidiMessageType);
-                    }
-
-                    if (MidiProfileInputPropertyNode.has_child(MIDI_TOGGLE_KEY_NAME))
-                    {
-                        MidiProfileInputPropertyNode[MIDI_TOGGLE_KEY_NAME] >> MidiDeviceInputProperty.bIsMidiToggle;
-                    }
-
-                    if (MidiProfileInputPropertyNode.has_child(MIDI_ACTION_TYPE_KEY_NAME))
-                    {
-                        uint8_t MidiActionType = 0;
-                        MidiProfileInputPropertyNode[MIDI_ACTION_TYPE_KEY_NAME] >> MidiActionType;
-                        MidiDeviceInputProperty.MidiActionType = static_cast<IEMidiActionType>(MidiActionType);
-                    }
-
-                    if (MidiProfileInputPropertyNode.has_child(CONSOLE_COMMAND_KEY_NAME))
-                    {
-                        if (!MidiProfileInputPropertyNode[CONSOLE_COMMAND_KEY_NAME].val().empty())
-                        {
-                            MidiProfileInputPropertyNode[CONSOLE_COMMAND_KEY_NAME] >> MidiDeviceInputProperty.ConsoleCommand;
-                        }
-                    }
-
-                    if (MidiProfileInputPropertyNode.has_child(OPEN_FILE_PATH_KEY_NAME))
-                    {
-                        if (!MidiProfileInputPropertyNode[OPEN_FILE_PATH_KEY_NAME].val().empty())
-                        {
-                            MidiProfileInputPropertyNode[OPEN_FILE_PATH_KEY_NAME] >> MidiDeviceInputProperty.OpenFilePath;
-                        }
-                    }
-
-                    if (MidiProfileInputPropertyNode.has_child(MIDI_MESSAGE_KEY_NAME))
-                    {
-                        MidiProfileInputPropertyNode[MIDI_MESSAGE_KEY_NAME] >> MidiDeviceInputProperty.MidiMessage;
-                    }
-                }
+                IEMidiDeviceProfile MidiDeviceProfile(ProfileFiles[i].first, 0, 0);
+                Results[i] = LoadProfileFile(ProfileFiles[i].second, MidiDeviceProfile);
             }
+        };
 
-            if (MidiProfileNode.has_child(MIDI_PROFILE_OUTPUT_PROPERTIES_NODE_NAME))
-            {
-                const ryml::ConstNodeRef MidiProfileOutputPropertiesNode = MidiProfileNode[MIDI_PROFILE_OUTPUT_PROPERTIES_NODE_NAME];
-                for (int ChildPos = 0; ChildPos < MidiProfileOutputPropertiesNode.num_children(); ChildPos++)
-                {
-                    const ryml::ConstNodeRef MidiProfileOutputPropertyNode = MidiProfileOutputPropertiesNode.at(ChildPos);
-                    IEMidiDeviceOutputProperty& MidiDeviceOutputProperty = MidiDeviceProfile.MakeOutputProperty();
+    const size_t ThreadCount = std::min<size_t>(std::max(std::thread::hardware_concurrency(), 1u), ProfileFiles.size());
+    std::vector<std::thread> ValidationThreads;
+    for (size_t i = 1; i < ThreadCount; i++)
+    {
+        ValidationThreads.emplace_back(ValidateNextProfileFiles);
+    }
+    ValidateNextProfileFiles();
+    for (std::thread& ValidationThread : ValidationThreads)
+    {
+        ValidationThread.join();
+    }
 
-                    if (MidiProfileOutputPropertyNode.has_child(MIDI_MESSAGE_KEY_NAME))
-                    {
-                        MidiProfileOutputPropertyNode[MIDI_MESSAGE_KEY_NAME] >> MidiDeviceOutputProperty.MidiMessage;
-                    }
-                }
+    size_t InvalidProfileCount = 0;
+    for (size_t i = 0; i < ProfileFiles.size(); i++)
+    {
+        if (!Results[i])
+        {
+            IELOG_ERROR("Invalid profile file %s for %s", ProfileFiles[i].second.string().c_str(), ProfileFiles[i].first.c_str());
+            InvalidProfileCount++;
+        }
+    }
+
+    const std::chrono::duration<double, std::milli> ValidationTime = std::chrono::steady_clock::now() - ValidationStartTime;
+    IELOG_SUCCESS("Validated %zu profile file(s) on %zu thread(s) in %.2f ms, %zu invalid", ProfileFiles.size(),
+        ThreadCount, ValidationTime.count(), InvalidProfileCount);
+}
+
+void IEMidiProfileManager::RefreshProfileIndex()
+{
+    if (m_ProfileIndexFilePath.empty())
+    {
+        return;
+    }
+
+    std::error_code ErrorCode;
+    IEMidiFileStamp ProfileIndexFileStamp;
+    ProfileIndexFileStamp.WriteTime = std::filesystem::last_write_time(m_ProfileIndexFilePath, ErrorCode);
+    ProfileIndexFileStamp.Size = ErrorCode ? 0 : std::filesystem::file_size(m_ProfileIndexFilePath, ErrorCode);
+    if (ErrorCode || ProfileIndexFileStamp == m_ProfileIndexFileStamp)
+    {
+        return;
+    }
+
+    m_ProfileIndexFileStamp = ProfileIndexFileStamp;
+    if (ProfileIndexFileStamp == m_ProfilePersister.GetLastWrittenStamp(m_ProfileIndexFilePath))
+    {
+        // Our own write, what is on disk is already in memory
+        return;
+    }
+
+    // Another instance added or removed devices, the index is rebuilt from disk
+    std::unordered_map<std::string, std::string> ProfileFileNames;
+    const std::string Content = ExtractFileContent(m_ProfileIndexFilePath);
+    ryml::Tree ProfileIndexTree;
+    ParseTree(Content, ProfileIndexTree);
+    const ryml::ConstNodeRef Root = ProfileIndexTree.rootref();
+    if (Root.is_map())
+    {
+        ProfileFileNames.reserve(Root.num_children());
+        for (const ryml::ConstNodeRef ProfileIndexNode : Root.children())
+        {
+            const ryml::csubstr MidiDeviceName = ProfileIndexNode.key();
+            std::string ProfileFileName;
+            ProfileIndexNode >> ProfileFileName;
+            if (!ProfileFileName.empty())
+            {
+                ProfileFileNames[std::string(MidiDeviceName.data(), MidiDeviceName.size())] = std::move(ProfileFileName);
             }
+        }
+    }
 
-            Result.Type = IEResult::Type::Success;
-            Result.Message = std::format("Successfully loaded profile {} from {}", MidiDeviceProfile.NameID, MidiProfilesFilePath.string());
+    // Only devices saved here whose writes have not landed yet are missing from disk for a reason,
+    // the pending index write holds the old entries and is rescheduled from the rebuilt index
+    bool bIsProfileIndexSaveNeeded = m_ProfilePersister.HasPendingWrite(m_ProfileIndexFilePath);
+    for (auto& [MidiDeviceName, ProfileFileName] : m_ProfileFileNames)
+    {
+        if (!ProfileFileNames.contains(MidiDeviceName) &&
+            (bIsProfileIndexSaveNeeded || m_ProfilePersister.HasPendingWrite(GetProfileFilePath(ProfileFileName))))
+        {
+            ProfileFileNames.emplace(MidiDeviceName, std::move(ProfileFileName));
+            bIsProfileIndexSaveNeeded = true;
         }
     }
-    return Result;
+
+    std::swap(m_ProfileFileNames, ProfileFileNames);
+    if (bIsProfileIndexSaveNeeded)
+    {
+        ScheduleProfileIndexSave();
+    }
 }
 
-IEResult IEMidiProfileManager::RemoveProfile(const IEMidiDeviceProfile& MidiDeviceProfile) const
-{
-    IEResult Result(IEResult::Type::Fail, "Failed to remove profile");
-    const std::filesystem::path IEMidiConfigFolderPath; // = IEUtils::GetIEConfigFolderPath();
-    // TODO
-    // if (!IEMidiConfigFolderPath.empty())
-    // {
-    //     const std::filesystem::path MidiProfilesFilePath = IEMidiConfigFolderPath / IEMIDI_PROFILES_FILENAME;
-    //     if (std::filesystem::exists(MidiProfilesFilePath))
-    //     {
-    //         const std::string Content = ExtractFileContent(MidiProfilesFilePath);
-
-    //         ryml::Tree MidiProfilesTree;
-    //         MidiProfilesTree.reserve(INITIAL_TREE_NODE_COUNT);
-    //         MidiProfilesTree.reserve_arena(INITIAL_TREE_ARENA_CHAR_COUNT);
-    //         ryml::parse_in_arena(ryml::to_csubstr(Content), &MidiProfilesTree);
-
-    //         ryml::NodeRef Root = MidiProfilesTree.rootref();
-    //         if (Root.is_map())
-    //         {
-    //             const char* MidiDeviceName = MidiDeviceProfile.Name.c_str();
-    //             Root.remove_child(MidiDeviceName);
-
-    //             if (std::FILE* const ProfilesFile = std::fopen(MidiProfilesFilePath.string().c_str(), "w"))
-    //             {
-    //                 if (!Root.empty())
-    //                 {
-    //                     size_t EmitSize = ryml::emit_yaml(MidiProfilesTree, ProfilesFile);
-    //                 }
-
-    //                 Result.Type = IEResult::Type::Success;
-    //                 Result.Message = std::format("Successfully removed profile {}, from {}", MidiDeviceProfile.Name, MidiProfilesFilePath.string());
-                    
-    //                 std::fclose(ProfilesFile);
-    //             }
-    //         }
-    //     }
-    // }
+std::string IEMidiProfileManager::SerializeProfileIndex() const
+{
+    size_t ArenaCharCount = 0;
+    for (const auto& [MidiDeviceName, ProfileFileName] : m_ProfileFileNames)
+    {
+        ArenaCharCount += MidiDeviceName.size() + ProfileFileName.size();
+    }
+
+    ryml::Tree ProfileIndexTree;
+    ReserveTree(ProfileIndexTree, m_ProfileFileNames.size() + 1, ArenaCharCount);
+    ryml::NodeRef Root = ProfileIndexTree.rootref();
+    Root |= ryml::MAP;
+    for (const auto& [MidiDeviceName, ProfileFileName] : m_ProfileFileNames)
+    {
+        ryml::NodeRef ProfileIndexNode = Root.append_child();
+        ProfileIndexNode << ryml::key(MidiDeviceName);
+        ProfileIndexNode << ProfileFileName;
+    }
+    return ryml::emitrs_yaml<std::string>(ProfileIndexTree);
+}
+
+void IEMidiProfileManager::ScheduleProfileIndexSave()
+{
+    m_ProfilePersister.Schedule(m_ProfileIndexFilePath, SerializeProfileIndex(), false);
+}
+
+std::filesystem::path IEMidiProfileManager::GetProfileFilePath(const std::string& ProfileFileName) const
+{
+    return m_ProfilesFolderPath / ProfileFileName;
+}
+
+IEMidiProfileManager::IESerializedProfileBatch IEMidiProfileManager::SerializeProfileBatch(const IEMidiProfileBatch& ProfileBatch)
+{
+    IESerializedProfileBatch SerializedProfileBatch;
+    for (const IEMidiDeviceProfile* const MidiDeviceProfile : ProfileBatch.SavedProfiles)
+    {
+        // A profile saved twice in the batch keeps its last content
+        SerializedProfileBatch.SavedProfileContents[MidiDeviceProfile->NameID] = SerializeProfileFile(*MidiDeviceProfile);
+    }
+    SerializedProfileBatch.RemovedMidiDeviceNames = ProfileBatch.RemovedMidiDeviceNames;
+    return SerializedProfileBatch;
+}
+
+IEResult IEMidiProfileManager::LoadProfileFile(const std::filesystem::path& ProfileFilePath, IEMidiDeviceProfile& MidiDeviceProfile)
+{
+    return LoadProfileContent(ExtractFileContent(ProfileFilePath), ProfileFilePath, MidiDeviceProfile);
+}
+
+IEResult IEMidiProfileManager::LoadProfileContent(const std::string& Content, const std::filesystem::path& ProfileFilePath, IEMidiDeviceProfile& MidiDeviceProfile)
+{
+    IEResult Result(IEResult::Type::Fail);
+    Result.Message = std::format("Failed to load profile {} from {}", MidiDeviceProfile.NameID, ProfileFilePath.string());
+
+    ryml::Tree MidiProfileTree;
+    ParseTree(Content, MidiProfileTree);
+
+    const ryml::ConstNodeRef Root = MidiProfileTree.rootref();
+    if (Root.is_map() && Root.has_child(ryml::to_csubstr(MidiDeviceProfile.NameID)))
+    {
+        DeserializeProfile(Root[ryml::to_csubstr(MidiDeviceProfile.NameID)], MidiDeviceProfile);
+        Result.Type = IEResult::Type::Success;
+        Result.Message = std::format("Successfully loaded profile {} from {}", MidiDeviceProfile.NameID, ProfileFilePath.string());
+    }
     return Result;
 }
 
-std::string IEMidiProfileManager::ExtractFileContent(const std::filesystem::path& FilePath) const
+std::string IEMidiProfileManager::MakeProfileFileName(const std::string& MidiDeviceName, uint32_t Revision)
+{
+    // Readable prefix plus a hash of the full name, different names never share a file
+    std::string ProfileFileName;
+    for (const char Character : MidiDeviceName)
+    {
+        const bool bIsSafe = (Character >= 'a' && Character <= 'z') || (Character >= 'A' && Character <= 'Z') ||
+            (Character >= '0' && Character <= '9') || Character == '-' || Character == '_';
+        ProfileFileName.push_back(bIsSafe ? Character : '_');
+    }
+
+    uint32_t NameHash = 0x811C9DC5;
+    for (const char Character : MidiDeviceName)
+    {
+        NameHash ^= static_cast<uint8_t>(Character);
+        NameHash *= 0x01000193;
+    }
+    // Batches alternate between two revisions so the file in use is never overwritten
+    return Revision == 0 ? std::format("{}-{:08x}{}", ProfileFileName, NameHash, IEMIDI_PROFILE_FILE_EXTENSION) :
+        std::format("{}-{:08x}-{}{}", ProfileFileName, NameHash, Revision, IEMIDI_PROFILE_FILE_EXTENSION);
+}
+
+std::string IEMidiProfileManager::ExtractFileContent(const std::filesystem::path& FilePath)
 {
     std::string Content;
     if (std::FILE* const File = std::fopen(FilePath.string().c_str(), "rb"))
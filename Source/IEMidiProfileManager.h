@@ -5,23 +5,104 @@
 #pragma once
 
 #include <filesystem>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
 
 #include "IELog.h"
 
+#include "IEMidiProfilePersister.h"
 #include "IEMidiTypes.h"
 
+// Adds, updates and removes committed together by IEMidiProfileManager::CommitProfileBatch. Saved
+// profiles are serialized on commit and must outlive it, removes are applied after saves.
+struct IEMidiProfileBatch
+{
+    void SaveProfile(const IEMidiDeviceProfile& MidiDeviceProfile) { SavedProfiles.emplace_back(&MidiDeviceProfile); }
+    void RemoveProfile(const std::string& MidiDeviceName) { RemovedMidiDeviceNames.emplace_back(MidiDeviceName); }
+    bool IsEmpty() const { return SavedProfiles.empty() && RemovedMidiDeviceNames.empty(); }
+
+    std::vector<const IEMidiDeviceProfile*> SavedProfiles;
+    std::vector<std::string> RemovedMidiDeviceNames;
+};
+
+// Stores every device profile in its own file under the profiles folder, with an index of device
+// name to file name. Profiles are only read when their device is activated, and saves are written
+// behind by IEMidiProfilePersister. Safe to call from any thread, batches commit one at a time.
 class IEMidiProfileManager
 {
 public:
     IEMidiProfileManager();
-    
+    ~IEMidiProfileManager();
+
 public:
-    std::filesystem::path GetIEMidiProfilesFilePath() const;
-    bool HasProfile(const IEMidiDeviceProfile& MidiDeviceProfile) const;
-    IEResult SaveProfile(const IEMidiDeviceProfile& MidiDeviceProfile) const;
-    IEResult LoadProfile(IEMidiDeviceProfile& MidiDeviceProfile) const;
-    IEResult RemoveProfile(const IEMidiDeviceProfile& MidiDeviceProfile) const;
+    std::filesystem::path GetIEMidiProfilesFolderPath() const;
+    std::filesystem::path GetIEMidiProfileFilePath(const std::string& MidiDeviceName);
+    bool HasProfile(const IEMidiDeviceProfile& MidiDeviceProfile);
+    IEResult SaveProfile(const IEMidiDeviceProfile& MidiDeviceProfile);
+    IEResult LoadProfile(IEMidiDeviceProfile& MidiDeviceProfile);
+    IEResult RemoveProfile(const IEMidiDeviceProfile& MidiDeviceProfile);
+
+    // Written before returning. Either every change of the batch is visible on disk or none is. Blocks
+    // until the batch is on disk, the UI thread commits through CommitProfileBatchAsync.
+    IEResult CommitProfileBatch(const IEMidiProfileBatch& ProfileBatch);
+
+    // Serializes the batch on the calling thread and commits it on a background thread after the batches
+    // passed before it. The callback runs on that thread.
+    void CommitProfileBatchAsync(const IEMidiProfileBatch& ProfileBatch, std::function<void(const IEResult&)> OnCommitted);
+
+public:
+    // Saves are written in the background, the callback runs on the persister thread once they are on disk
+    void SetOnProfilesSavedCallback(std::function<void(const IEResult&)> Func);
+    void FlushPendingSaves();
+
+private:
+    struct IESerializedProfileBatch
+    {
+        std::unordered_map<std::string, std::string> SavedProfileContents;
+        std::vector<std::string> RemovedMidiDeviceNames;
+    };
+
+private:
+    IEResult CommitSerializedProfileBatch(const IESerializedProfileBatch& SerializedProfileBatch);
+    void WaitForProfileBatchCommits() const;
+    void MigrateLegacyProfilesFile(const std::filesystem::path& LegacyProfilesFilePath);
+    void ValidateProfileFiles();
+    std::filesystem::path GetProfileFilePath(const std::string& ProfileFileName) const;
+
+private:
+    // Called with m_Mutex held
+    void RefreshProfileIndex();
+    std::string SerializeProfileIndex() const;
+    void ScheduleProfileIndexSave();
+
+private:
+    static IESerializedProfileBatch SerializeProfileBatch(const IEMidiProfileBatch& ProfileBatch);
+    static IEResult LoadProfileFile(const std::filesystem::path& ProfileFilePath, IEMidiDeviceProfile& MidiDeviceProfile);
+    static IEResult LoadProfileContent(const std::string& Content, const std::filesystem::path& ProfileFilePath, IEMidiDeviceProfile& MidiDeviceProfile);
+    static std::string MakeProfileFileName(const std::string& MidiDeviceName, uint32_t Revision = 0);
+    static std::string ExtractFileContent(const std::filesystem::path& FilePath);
+
+private:
+    std::filesystem::path m_ProfilesFolderPath;
+    std::filesystem::path m_ProfileIndexFilePath;
+
+private:
+    // Guards the index, never held while waiting for the disk
+    mutable std::mutex m_Mutex;
+    IEMidiFileStamp m_ProfileIndexFileStamp;
+    std::unordered_map<std::string, std::string> m_ProfileFileNames;
+    // While a batch is undecided, saves to its devices also go to the file the other outcome would use
+    std::unordered_map<std::string, std::filesystem::path> m_UndecidedProfileFilePaths;
+    std::shared_future<void> m_LastProfileBatchCommit;
+
+private:
+    std::mutex m_CommitMutex;
 
 private:
-    std::string ExtractFileContent(const std::filesystem::path& FilePath) const;
+    // Destroyed first, which writes out any pending save
+    IEMidiProfilePersister m_ProfilePersister;
 };
\ No newline at end of file
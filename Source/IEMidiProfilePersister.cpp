@@ -0,0 +1,293 @@
+// SPDX-License-Identifier: GPL-2.0-only
+// Copyright © Interactive Echoes. All rights reserved.
+// Author: mozahzah
+
+#include "IEMidiProfilePersister.h"
+
+#include <cstdio>
+
+#if defined(_WIN32)
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+static constexpr char TEMPORARY_FILE_EXTENSION[] = ".tmp";
+
+IEMidiProfilePersister::IEMidiProfilePersister(IEMidiFsyncPolicy FsyncPolicy, std::chrono::milliseconds DebounceInterval) :
+    m_FsyncPolicy(FsyncPolicy),
+    m_DebounceInterval(DebounceInterval)
+{
+    m_PersisterThread = std::thread(&IEMidiProfilePersister::Run, this);
+}
+
+IEMidiProfilePersister::~IEMidiProfilePersister()
+{
+    {
+        std::scoped_lock Lock(m_Mutex);
+        m_bStopRequested = true;
+    }
+    m_WakeCondition.notify_one();
+
+    // Pending saves are written before the thread exits
+    if (m_PersisterThread.joinable())
+    {
+        m_PersisterThread.join();
+    }
+}
+
+IEMidiProfilePersister::IEWriteToken IEMidiProfilePersister::Schedule(const std::filesystem::path& FilePath, std::string Content, bool bReportCompletion)
+{
+    IEPendingWrite ScheduledWrite;
+    ScheduledWrite.Content = std::move(Content);
+    ScheduledWrite.bReportCompletion = bReportCompletion;
+    return SchedulePendingWrite(FilePath, std::move(ScheduledWrite));
+}
+
+IEMidiProfilePersister::IEWriteToken IEMidiProfilePersister::ScheduleNow(const std::filesystem::path& FilePath, std::string Content)
+{
+    IEPendingWrite ScheduledWrite;
+    ScheduledWrite.Content = std::move(Content);
+    ScheduledWrite.bIsDebounced = false;
+    return SchedulePendingWrite(FilePath, std::move(ScheduledWrite));
+}
+
+IEMidiProfilePersister::IEWriteToken IEMidiProfilePersister::ScheduleRemoval(const std::filesystem::path& FilePath)
+{
+    IEPendingWrite ScheduledWrite;
+    ScheduledWrite.bIsRemoval = true;
+    return SchedulePendingWrite(FilePath, std::move(ScheduledWrite));
+}
+
+void IEMidiProfilePersister::Flush()
+{
+    std::unique_lock Lock(m_Mutex);
+    m_bFlushRequested = true;
+    m_WakeCondition.notify_one();
+    m_IdleCondition.wait(Lock, [this]() { return m_PendingWrites.empty() && m_InFlightWrites.empty(); });
+    m_bFlushRequested = false;
+}
+
+bool IEMidiProfilePersister::HasPendingWrites() const
+{
+    std::scoped_lock Lock(m_Mutex);
+    return !m_PendingWrites.empty() || !m_InFlightWrites.empty();
+}
+
+bool IEMidiProfilePersister::HasPendingWrite(const std::filesystem::path& FilePath) const
+{
+    std::scoped_lock Lock(m_Mutex);
+    return m_PendingWrites.contains(FilePath) || m_InFlightWrites.contains(FilePath);
+}
+
+std::optional<std::string> IEMidiProfilePersister::GetPendingContent(const std::filesystem::path& FilePath) const
+{
+    std::scoped_lock Lock(m_Mutex);
+    // A pending write is always newer than the one in flight to the same file
+    for (const std::map<std::filesystem::path, IEPendingWrite>* const Writes : {&m_PendingWrites, &m_InFlightWrites})
+    {
+        if (const auto WriteIt = Writes->find(FilePath); WriteIt != Writes->end())
+        {
+            return WriteIt->second.Content;
+        }
+    }
+    return std::nullopt;
+}
+
+std::optional<IEMidiFileStamp> IEMidiProfilePersister::GetLastWrittenStamp(const std::filesystem::path& FilePath) const
+{
+    std::scoped_lock Lock(m_Mutex);
+    if (const auto StampIt = m_LastWrittenStamps.find(FilePath); StampIt != m_LastWrittenStamps.end())
+    {
+        return StampIt->second;
+    }
+    return std::nullopt;
+}
+
+void IEMidiProfilePersister::SetCompletionCallback(IECompletionFunc CompletionFunc)
+{
+    std::scoped_lock Lock(m_Mutex);
+    m_CompletionFunc = std::move(CompletionFunc);
+}
+
+IEMidiProfilePersister::IEWriteToken IEMidiProfilePersister::SchedulePendingWrite(const std::filesystem::path& FilePath, IEPendingWrite ScheduledWrite)
+{
+    const std::chrono::steady_clock::time_point Now = std::chrono::steady_clock::now();
+    IEWriteToken WriteToken;
+    {
+        std::scoped_lock Lock(m_Mutex);
+        auto [PendingWriteIt, bIsNew] = m_PendingWrites.try_emplace(FilePath);
+        IEPendingWrite& PendingWrite = PendingWriteIt->second;
+        PendingWrite.Content = std::move(ScheduledWrite.Content);
+        PendingWrite.bIsRemoval = ScheduledWrite.bIsRemoval;
+        PendingWrite.bIsDebounced = PendingWrite.bIsDebounced && ScheduledWrite.bIsDebounced;
+        // A removal is not reported as the save it replaced
+        PendingWrite.bReportCompletion = !ScheduledWrite.bIsRemoval && (PendingWrite.bReportCompletion || ScheduledWrite.bReportCompletion);
+        PendingWrite.LastScheduledTime = Now;
+        if (bIsNew)
+        {
+            PendingWrite.ResultPromise = std::make_shared<std::promise<IEResult>>();
+            PendingWrite.WriteToken = PendingWrite.ResultPromise->get_future().share();
+            PendingWrite.FirstScheduledTime = Now;
+        }
+        WriteToken = PendingWrite.WriteToken;
+    }
+    m_WakeCondition.notify_one();
+    return WriteToken;
+}
+
+void IEMidiProfilePersister::Run()
+{
+    std::unique_lock Lock(m_Mutex);
+    while (true)
+    {
+        // A file is written once saves to it pause for the debounce interval, or after a bounded delay
+        // when they keep coming
+        const std::chrono::steady_clock::time_point Now = std::chrono::steady_clock::now();
+        std::chrono::steady_clock::time_point NextDeadline = std::chrono::steady_clock::time_point::max();
+        for (auto PendingWriteIt = m_PendingWrites.begin(); PendingWriteIt != m_PendingWrites.end();)
+        {
+            const IEPendingWrite& PendingWrite = PendingWriteIt->second;
+            const std::chrono::steady_clock::time_point Deadline = std::min(PendingWrite.LastScheduledTime + m_DebounceInterval,
+                PendingWrite.FirstScheduledTime + m_DebounceInterval * MAX_DEBOUNCE_INTERVAL_COUNT);
+            if (m_bStopRequested || m_bFlushRequested || !PendingWrite.bIsDebounced || Deadline <= Now)
+            {
+                m_InFlightWrites.insert(m_PendingWrites.extract(PendingWriteIt++));
+            }
+            else
+            {
+                NextDeadline = std::min(NextDeadline, Deadline);
+                ++PendingWriteIt;
+            }
+        }
+
+        if (!m_InFlightWrites.empty())
+        {
+            for (auto InFlightWriteIt = m_InFlightWrites.begin(); InFlightWriteIt != m_InFlightWrites.end();)
+            {
+                const std::filesystem::path& FilePath = InFlightWriteIt->first;
+                const IEPendingWrite& InFlightWrite = InFlightWriteIt->second;
+                Lock.unlock();
+                const IEResult Result = InFlightWrite.bIsRemoval ? RemoveFile(FilePath) : WriteFile(FilePath, InFlightWrite.Content);
+                std::error_code ErrorCode;
+                IEMidiFileStamp FileStamp;
+                FileStamp.WriteTime = std::filesystem::last_write_time(FilePath, ErrorCode);
+                FileStamp.Size = ErrorCode ? 0 : std::filesystem::file_size(FilePath, ErrorCode);
+                Lock.lock();
+
+                if (InFlightWrite.bIsRemoval)
+                {
+                    m_LastWrittenStamps.erase(FilePath);
+                }
+                else if (Result && !ErrorCode)
+                {
+                    m_LastWrittenStamps[FilePath] = FileStamp;
+                }
+                InFlightWrite.ResultPromise->set_value(Result);
+
+                const IECompletionFunc CompletionFunc = InFlightWrite.bReportCompletion ? m_CompletionFunc : nullptr;
+                InFlightWriteIt = m_InFlightWrites.erase(InFlightWriteIt);
+                if (CompletionFunc)
+                {
+                    Lock.unlock();
+                    CompletionFunc(Result);
+                    Lock.lock();
+                }
+            }
+            continue;
+        }
+
+        m_IdleCondition.notify_all();
+        if (m_bStopRequested)
+        {
+            break;
+        }
+
+        if (NextDeadline == std::chrono::steady_clock::time_point::max())
+        {
+            m_WakeCondition.wait(Lock);
+        }
+        else
+        {
+            m_WakeCondition.wait_until(Lock, NextDeadline);
+        }
+    }
+}
+
+IEResult IEMidiProfilePersister::WriteFile(const std::filesystem::path& FilePath, const std::string& Content) const
+{
+    IEResult Result(IEResult::Type::Fail);
+    Result.Message = std::format("Failed to write {}", FilePath.string());
+
+    std::filesystem::path TemporaryFilePath = FilePath;
+    TemporaryFilePath += TEMPORARY_FILE_EXTENSION;
+    if (std::FILE* const TemporaryFile = std::fopen(TemporaryFilePath.string().c_str(), "wb"))
+    {
+        bool bIsWritten = std::fwrite(Content.data(), 1, Content.size(), TemporaryFile) == Content.size();
+        bIsWritten = std::fflush(TemporaryFile) == 0 && bIsWritten;
+        if (bIsWritten && m_FsyncPolicy != IEMidiFsyncPolicy::None)
+        {
+            bIsWritten = SyncFile(TemporaryFile);
+        }
+        bIsWritten = std::fclose(TemporaryFile) == 0 && bIsWritten;
+
+        std::error_code ErrorCode;
+        if (bIsWritten)
+        {
+            // Replaces the previous file in a single step, readers see either the old or the new content
+            std::filesystem::rename(TemporaryFilePath, FilePath, ErrorCode);
+        }
+
+        if (bIsWritten && !ErrorCode)
+        {
+            if (m_FsyncPolicy == IEMidiFsyncPolicy::FileAndDirectory)
+            {
+                SyncDirectory(FilePath.parent_path());
+            }
+            Result.Type = IEResult::Type::Success;
+            Result.Message = std::format("Successfully saved {}", FilePath.string());
+        }
+        else
+        {
+            std::filesystem::remove(TemporaryFilePath, ErrorCode);
+        }
+    }
+    return Result;
+}
+
+IEResult IEMidiProfilePersister::RemoveFile(const std::filesystem::path& FilePath)
+{
+    IEResult Result(IEResult::Type::Fail);
+    Result.Message = std::format("Failed to remove {}", FilePath.string());
+
+    std::error_code ErrorCode;
+    std::filesystem::remove(FilePath, ErrorCode);
+    if (!ErrorCode)
+    {
+        Result.Type = IEResult::Type::Success;
+        Result.Message = std::format("Successfully removed {}", FilePath.string());
+    }
+    return Result;
+}
+
+bool IEMidiProfilePersister::SyncFile(std::FILE* File)
+{
+#if defined(_WIN32)
+    return _commit(_fileno(File)) == 0;
+#else
+    return fsync(fileno(File)) == 0;
+#endif
+}
+
+void IEMidiProfilePersister::SyncDirectory(const std::filesystem::path& DirectoryPath)
+{
+#if !defined(_WIN32)
+    const int DirectoryDescriptor = open(DirectoryPath.string().c_str(), O_RDONLY);
+    if (DirectoryDescriptor >= 0)
+    {
+        fsync(DirectoryDescriptor);
+        close(DirectoryDescriptor);
+    }
+#endif
+}
\ No newline at end of file
@@ -0,0 +1,115 @@
+// SPDX-License-Identifier: GPL-2.0-only
+// Copyright © Interactive Echoes. All rights reserved.
+// Author: mozahzah
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+
+#include "IELog.h"
+
+enum class IEMidiFsyncPolicy : uint8_t
+{
+    None,               // Leaves flushing to the OS, a power loss can lose the latest save
+    File,               // Flushes the temporary file before it replaces the previous one
+    FileAndDirectory    // Also flushes the parent directory so the rename itself is durable
+};
+
+struct IEMidiFileStamp
+{
+    std::filesystem::file_time_type WriteTime;
+    uintmax_t Size = 0;
+
+    bool operator==(const IEMidiFileStamp& Other) const = default;
+};
+
+// Write-behind persistence on a background thread. Saves to the same file are debounced, only the
+// latest content is written, to a temporary file that atomically replaces the target, so a crash
+// mid-write never leaves a partial file behind.
+class IEMidiProfilePersister
+{
+public:
+    using IECompletionFunc = std::function<void(const IEResult&)>;
+
+    // Result of the write that carries a scheduled content to disk. Content that is replaced before it
+    // is written shares the result of the write that replaced it.
+    using IEWriteToken = std::shared_future<IEResult>;
+
+public:
+    explicit IEMidiProfilePersister(IEMidiFsyncPolicy FsyncPolicy = IEMidiFsyncPolicy::File,
+        std::chrono::milliseconds DebounceInterval = std::chrono::milliseconds(250));
+    ~IEMidiProfilePersister();
+    IEMidiProfilePersister(const IEMidiProfilePersister&) = delete;
+    IEMidiProfilePersister& operator=(const IEMidiProfilePersister&) = delete;
+
+public:
+    IEWriteToken Schedule(const std::filesystem::path& FilePath, std::string Content, bool bReportCompletion = true);
+    // Written on the next pass of the persister thread instead of once saves to the file pause
+    IEWriteToken ScheduleNow(const std::filesystem::path& FilePath, std::string Content);
+    // Deletes the file after the writes scheduled to it before, a write still pending is dropped
+    IEWriteToken ScheduleRemoval(const std::filesystem::path& FilePath);
+    void Flush();
+    bool HasPendingWrites() const;
+    bool HasPendingWrite(const std::filesystem::path& FilePath) const;
+
+    // The newest content scheduled for the file that may not be on disk yet, a pending removal reads as empty
+    std::optional<std::string> GetPendingContent(const std::filesystem::path& FilePath) const;
+
+    // The stamp of the last file written by the persister, lets owners recognise their own writes
+    std::optional<IEMidiFileStamp> GetLastWrittenStamp(const std::filesystem::path& FilePath) const;
+
+    // Called on the persister thread once per written file that was scheduled to report completion
+    void SetCompletionCallback(IECompletionFunc CompletionFunc);
+
+private:
+    struct IEPendingWrite
+    {
+        std::string Content;
+        bool bIsRemoval = false;
+        bool bIsDebounced = true;
+        bool bReportCompletion = false;
+        std::shared_ptr<std::promise<IEResult>> ResultPromise;
+        IEWriteToken WriteToken;
+        std::chrono::steady_clock::time_point FirstScheduledTime;
+        std::chrono::steady_clock::time_point LastScheduledTime;
+    };
+
+private:
+    IEWriteToken SchedulePendingWrite(const std::filesystem::path& FilePath, IEPendingWrite ScheduledWrite);
+    void Run();
+    IEResult WriteFile(const std::filesystem::path& FilePath, const std::string& Content) const;
+    static IEResult RemoveFile(const std::filesystem::path& FilePath);
+    static bool SyncFile(std::FILE* File);
+    static void SyncDirectory(const std::filesystem::path& DirectoryPath);
+
+private:
+    static constexpr uint32_t MAX_DEBOUNCE_INTERVAL_COUNT = 8;
+
+private:
+    const IEMidiFsyncPolicy m_FsyncPolicy;
+    const std::chrono::milliseconds m_DebounceInterval;
+
+private:
+    mutable std::mutex m_Mutex;
+    std::condition_variable m_WakeCondition;
+    std::condition_variable m_IdleCondition;
+    std::map<std::filesystem::path, IEPendingWrite> m_PendingWrites;
+    // Only the persister thread adds or erases, so it writes their content without holding the lock
+    std::map<std::filesystem::path, IEPendingWrite> m_InFlightWrites;
+    std::map<std::filesystem::path, IEMidiFileStamp> m_LastWrittenStamps;
+    IECompletionFunc m_CompletionFunc;
+    bool m_bFlushRequested = false;
+    bool m_bStopRequested = false;
+    std::thread m_PersisterThread;
+};
\ No newline at end of file
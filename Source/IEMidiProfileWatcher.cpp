@@ -0,0 +1,217 @@
+// SPDX-License-Identifier: GPL-2.0-only
+// Copyright © Interactive Echoes. All rights reserved.
+// Author: mozahzah
+
+#include "IEMidiProfileWatcher.h"
+
+#include <map>
+
+IEMidiProfileWatcher::IEMidiProfileWatcher(IEMidiProcessor& MidiProcessor, IEMidiProfileManager& MidiProfileManager, QObject* Parent) :
+    QObject(Parent),
+    m_MidiProcessor(MidiProcessor),
+    m_MidiProfileManager(MidiProfileManager),
+    m_FileSystemWatcher(new QFileSystemWatcher(this)),
+    m_ReloadTimer(new QTimer(this))
+{
+    m_ReloadTimer->setSingleShot(true);
+    m_ReloadTimer->setInterval(RELOAD_DEBOUNCE_INTERVAL_MS);
+    connect(m_ReloadTimer, &QTimer::timeout, this, &IEMidiProfileWatcher::OnReloadTimeout);
+
+    // Files replaced by a rename only show up as a change of their folder
+    connect(m_FileSystemWatcher, &QFileSystemWatcher::fileChanged, this, &IEMidiProfileWatcher::OnFileSystemChanged);
+    connect(m_FileSystemWatcher, &QFileSystemWatcher::directoryChanged, this, &IEMidiProfileWatcher::OnFileSystemChanged);
+
+    const std::filesystem::path ProfilesFolderPath = m_MidiProfileManager.GetIEMidiProfilesFolderPath();
+    if (!ProfilesFolderPath.empty())
+    {
+        m_FileSystemWatcher->addPath(QString::fromStdString(ProfilesFolderPath.string()));
+    }
+}
+
+void IEMidiProfileWatcher::WatchActiveMidiDeviceProfiles()
+{
+    std::unordered_map<std::string, IEMidiFileStamp> WatchedFileStamps;
+    for (const std::string& MidiDeviceName : m_MidiProcessor.GetActiveMidiDeviceNames())
+    {
+        const std::filesystem::path ProfileFilePath = m_MidiProfileManager.GetIEMidiProfileFilePath(MidiDeviceName);
+        if (!ProfileFilePath.empty())
+        {
+            // A device seen for the first time starts from what is on disk now
+            const auto WatchedFileStampIt = m_WatchedFileStamps.find(MidiDeviceName);
+            WatchedFileStamps[MidiDeviceName] = WatchedFileStampIt != m_WatchedFileStamps.end() ?
+                WatchedFileStampIt->second : GetFileStamp(ProfileFilePath);
+
+            const QString ProfileFilePathString = QString::fromStdString(ProfileFilePath.string());
+            if (!m_FileSystemWatcher->files().contains(ProfileFilePathString))
+            {
+                m_FileSystemWatcher->addPath(ProfileFilePathString);
+            }
+        }
+    }
+    m_WatchedFileStamps = std::move(WatchedFileStamps);
+}
+
+void IEMidiProfileWatcher::OnFileSystemChanged()
+{
+    m_ReloadTimer->start();
+}
+
+void IEMidiProfileWatcher::OnReloadTimeout()
+{
+    const std::unordered_map<std::string, IEMidiFileStamp> PreviousFileStamps = m_WatchedFileStamps;
+    WatchActiveMidiDeviceProfiles();
+
+    for (auto& [MidiDeviceName, WatchedFileStamp] : m_WatchedFileStamps)
+    {
+        const std::filesystem::path ProfileFilePath = m_MidiProfileManager.GetIEMidiProfileFilePath(MidiDeviceName);
+        const IEMidiFileStamp FileStamp = GetFileStamp(ProfileFilePath);
+        if (PreviousFileStamps.contains(MidiDeviceName) && FileStamp != WatchedFileStamp && FileStamp.Size != 0)
+        {
+            WatchedFileStamp = FileStamp;
+            const IEResult Result = ReloadMidiDeviceProfile(MidiDeviceName);
+            if (Result)
+            {
+                IELOG_SUCCESS("%s", Result.Message.c_str());
+            }
+            else
+            {
+                IELOG_ERROR("%s", Result.Message.c_str());
+            }
+        }
+    }
+}
+
+IEResult IEMidiProfileWatcher::ReloadMidiDeviceProfile(const std::string& MidiDeviceName)
+{
+    IEResult Result(IEResult::Type::Fail);
+    Result.Message = std::format("Failed to reload profile {}", MidiDeviceName);
+
+    if (IEMidiDeviceProfile* const MidiDeviceProfile = m_MidiProcessor.FindMidiDeviceProfile(MidiDeviceName))
+    {
+        IEMidiDeviceProfile SourceMidiDeviceProfile(MidiDeviceName, MidiDeviceProfile->InputPortNumber, MidiDeviceProfile->OutputPortNumber);
+        if (m_MidiProfileManager.LoadProfile(SourceMidiDeviceProfile))
+        {
+            std::vector<IEMidiMessage> ChangedOutputMessages;
+            const IEMidiProfileReloadStats ReloadStats = ApplyMidiDeviceProfile(SourceMidiDeviceProfile, *MidiDeviceProfile, ChangedOutputMessages);
+            if (ReloadStats.HasChanges())
+            {
+                // Publishing a new snapshot is all the midi threads see, ports and queues are untouched
+                m_MidiProcessor.CompileMidiDeviceProfile(MidiDeviceName);
+                for (const IEMidiMessage& MidiMessage : ChangedOutputMessages)
+                {
+                    m_MidiProcessor.SendMidiOutputMessage(MidiDeviceName, MidiMessage);
+                }
+                emit OnMidiDeviceProfileReloaded(QString::fromStdString(MidiDeviceName));
+            }
+
+            Result.Type = IEResult::Type::Success;
+            Result.Message = std::format("Reloaded profile {}, {} updated, {} added, {} removed mapping(s)", MidiDeviceName,
+                ReloadStats.UpdatedCount, ReloadStats.AddedCount, ReloadStats.RemovedCount);
+        }
+    }
+    return Result;
+}
+
+IEMidiProfileReloadStats IEMidiProfileWatcher::ApplyMidiDeviceProfile(const IEMidiDeviceProfile& SourceMidiDeviceProfile,
+    IEMidiDeviceProfile& MidiDeviceProfile, std::vector<IEMidiMessage>& ChangedOutputMessages)
+{
+    IEMidiProfileReloadStats ReloadStats;
+
+    // Mappings are matched by message bytes and action wherever they moved in the file, a matched one
+    // keeps its runtime state such as toggles. A key bound twice is matched in file order.
+    {
+        std::multimap<std::string, IEMidiDeviceInputProperty*> UnmatchedInputProperties;
+        for (IEMidiDeviceInputProperty& MidiDeviceInputProperty : MidiDeviceProfile.InputProperties)
+        {
+            UnmatchedInputProperties.emplace(MakeMappingKey(MidiDeviceInputProperty.MidiMessage, MidiDeviceInputProperty.MidiActionType),
+                &MidiDeviceInputProperty);
+        }
+
+        std::vector<const IEMidiDeviceInputProperty*> AddedInputProperties;
+        for (const IEMidiDeviceInputProperty& SourceMidiDeviceInputProperty : SourceMidiDeviceProfile.InputProperties)
+        {
+            const std::string MappingKey = MakeMappingKey(SourceMidiDeviceInputProperty.MidiMessage, SourceMidiDeviceInputProperty.MidiActionType);
+            const auto UnmatchedInputPropertyIt = UnmatchedInputProperties.lower_bound(MappingKey);
+            if (UnmatchedInputPropertyIt == UnmatchedInputProperties.end() || UnmatchedInputPropertyIt->first != MappingKey)
+            {
+                AddedInputProperties.emplace_back(&SourceMidiDeviceInputProperty);
+                continue;
+            }
+
+            IEMidiDeviceInputProperty& MidiDeviceInputProperty = *UnmatchedInputPropertyIt->second;
+            if (!MidiDeviceInputProperty.HasSameMapping(SourceMidiDeviceInputProperty))
+            {
+                MidiDeviceInputProperty.CopyMapping(SourceMidiDeviceInputProperty);
+                ReloadStats.UpdatedCount++;
+            }
+            UnmatchedInputProperties.erase(UnmatchedInputPropertyIt);
+        }
+
+        // Removing leaves the other properties in place, only appending moves them
+        for (const auto& [MappingKey, MidiDeviceInputProperty] : UnmatchedInputProperties)
+        {
+            MidiDeviceInputProperty->Delete();
+            ReloadStats.RemovedCount++;
+        }
+
+        for (const IEMidiDeviceInputProperty* const SourceMidiDeviceInputProperty : AddedInputProperties)
+        {
+            MidiDeviceProfile.MakeInputProperty().CopyMapping(*SourceMidiDeviceInputProperty);
+            ReloadStats.AddedCount++;
+        }
+    }
+
+    // Output properties are only their message, a changed message is a remove and an add
+    {
+        std::multimap<std::string, IEMidiDeviceOutputProperty*> UnmatchedOutputProperties;
+        for (IEMidiDeviceOutputProperty& MidiDeviceOutputProperty : MidiDeviceProfile.OutputProperties)
+        {
+            UnmatchedOutputProperties.emplace(MakeMappingKey(MidiDeviceOutputProperty.MidiMessage, IEMidiActionType::None),
+                &MidiDeviceOutputProperty);
+        }
+
+        std::vector<const IEMidiDeviceOutputProperty*> AddedOutputProperties;
+        for (const IEMidiDeviceOutputProperty& SourceMidiDeviceOutputProperty : SourceMidiDeviceProfile.OutputProperties)
+        {
+            const std::string MappingKey = MakeMappingKey(SourceMidiDeviceOutputProperty.MidiMessage, IEMidiActionType::None);
+            const auto UnmatchedOutputPropertyIt = UnmatchedOutputProperties.lower_bound(MappingKey);
+            if (UnmatchedOutputPropertyIt == UnmatchedOutputProperties.end() || UnmatchedOutputPropertyIt->first != MappingKey)
+            {
+                AddedOutputProperties.emplace_back(&SourceMidiDeviceOutputProperty);
+                continue;
+            }
+            UnmatchedOutputProperties.erase(UnmatchedOutputPropertyIt);
+        }
+
+        for (const auto& [MappingKey, MidiDeviceOutputProperty] : UnmatchedOutputProperties)
+        {
+            MidiDeviceOutputProperty->Delete();
+            ReloadStats.RemovedCount++;
+        }
+
+        for (const IEMidiDeviceOutputProperty* const SourceMidiDeviceOutputProperty : AddedOutputProperties)
+        {
+            IEMidiDeviceOutputProperty& NewMidiDeviceOutputProperty = MidiDeviceProfile.MakeOutputProperty();
+            NewMidiDeviceOutputProperty.MidiMessage = SourceMidiDeviceOutputProperty->MidiMessage;
+            ChangedOutputMessages.emplace_back(NewMidiDeviceOutputProperty.MidiMessage);
+            ReloadStats.AddedCount++;
+        }
+    }
+    return ReloadStats;
+}
+
+std::string IEMidiProfileWatcher::MakeMappingKey(const IEMidiMessage& MidiMessage, IEMidiActionType MidiActionType)
+{
+    std::string MappingKey(reinterpret_cast<const char*>(MidiMessage.data()), MidiMessage.size());
+    MappingKey.push_back(static_cast<char>(MidiActionType));
+    return MappingKey;
+}
+
+IEMidiFileStamp IEMidiProfileWatcher::GetFileStamp(const std::filesystem::path& FilePath)
+{
+    std::error_code ErrorCode;
+    IEMidiFileStamp FileStamp;
+    FileStamp.WriteTime = std::filesystem::last_write_time(FilePath, ErrorCode);
+    FileStamp.Size = ErrorCode ? 0 : std::filesystem::file_size(FilePath, ErrorCode);
+    return ErrorCode ? IEMidiFileStamp() : FileStamp;
+}
\ No newline at end of file
@@ -0,0 +1,68 @@
+// SPDX-License-Identifier: GPL-2.0-only
+// Copyright © Interactive Echoes. All rights reserved.
+// Author: mozahzah
+
+#pragma once
+
+#include <filesystem>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "qfilesystemwatcher.h"
+#include "qobject.h"
+#include "qtimer.h"
+
+#include "IELog.h"
+
+#include "IEMidiProcessor.h"
+#include "IEMidiProfileManager.h"
+
+struct IEMidiProfileReloadStats
+{
+    uint32_t UpdatedCount = 0;
+    uint32_t AddedCount = 0;
+    uint32_t RemovedCount = 0;
+
+    bool HasChanges() const { return UpdatedCount != 0 || AddedCount != 0 || RemovedCount != 0; }
+};
+
+// Watches the profile files of the active devices and applies edits made outside the app while
+// their ports stay open. The file is diffed against the live profile, only changed mappings are
+// touched and only changed output messages are sent again.
+class IEMidiProfileWatcher : public QObject
+{
+    Q_OBJECT
+
+public:
+    IEMidiProfileWatcher(IEMidiProcessor& MidiProcessor, IEMidiProfileManager& MidiProfileManager, QObject* Parent = nullptr);
+
+public:
+    // Picks up devices that were activated or deactivated since the last call
+    void WatchActiveMidiDeviceProfiles();
+
+Q_SIGNALS:
+    void OnMidiDeviceProfileReloaded(const QString& MidiDeviceName) const;
+
+private Q_SLOTS:
+    void OnFileSystemChanged();
+    void OnReloadTimeout();
+
+private:
+    IEResult ReloadMidiDeviceProfile(const std::string& MidiDeviceName);
+    static IEMidiProfileReloadStats ApplyMidiDeviceProfile(const IEMidiDeviceProfile& SourceMidiDeviceProfile,
+        IEMidiDeviceProfile& MidiDeviceProfile, std::vector<IEMidiMessage>& ChangedOutputMessages);
+    static std::string MakeMappingKey(const IEMidiMessage& MidiMessage, IEMidiActionType MidiActionType);
+    static IEMidiFileStamp GetFileStamp(const std::filesystem::path& FilePath);
+
+private:
+    // Editors and the persister touch the file more than once per save
+    static constexpr int RELOAD_DEBOUNCE_INTERVAL_MS = 100;
+
+private:
+    IEMidiProcessor& m_MidiProcessor;
+    IEMidiProfileManager& m_MidiProfileManager;
+    QFileSystemWatcher* m_FileSystemWatcher;
+    QTimer* m_ReloadTimer;
+    std::unordered_map<std::string, IEMidiFileStamp> m_WatchedFileStamps;
+};
\ No newline at end of file
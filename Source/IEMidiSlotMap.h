@@ -0,0 +1,225 @@
+// SPDX-License-Identifier: GPL-2.0-only
+// Copyright © Interactive Echoes. All rights reserved.
+// Author: mozahzah
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <algorithm>
+#include <iterator>
+#include <limits>
+#include <optional>
+#include <utility>
+#include <vector>
+
+struct IEMidiSlotHandle
+{
+    static constexpr uint32_t INVALID_SLOT_INDEX = std::numeric_limits<uint32_t>::max();
+
+    uint32_t SlotIndex = INVALID_SLOT_INDEX;
+    uint32_t Generation = 0;
+
+    bool IsValid() const { return SlotIndex != INVALID_SLOT_INDEX; }
+    bool operator==(const IEMidiSlotHandle& Other) const = default;
+};
+
+// Values stored contiguously in insertion order with O(1) append, lookup and removal. Removal leaves
+// a hole that a later append compacts away, handles stay valid across compactions and stop resolving
+// once their value is removed.
+template<typename T>
+class IEMidiSlotMap
+{
+public:
+    template<typename ValueType, typename ValueIteratorType>
+    class IEIterator
+    {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using pointer = ValueType*;
+        using reference = ValueType&;
+
+    public:
+        IEIterator() = default;
+        IEIterator(ValueIteratorType ValueIt, ValueIteratorType ValueEndIt) :
+            m_ValueIt(ValueIt),
+            m_ValueEndIt(ValueEndIt)
+        {
+            SkipHoles();
+        }
+
+    public:
+        reference operator*() const { return **m_ValueIt; }
+        pointer operator->() const { return &**m_ValueIt; }
+        IEIterator& operator++() { ++m_ValueIt; SkipHoles(); return *this; }
+        IEIterator operator++(int) { IEIterator Previous = *this; ++*this; return Previous; }
+        bool operator==(const IEIterator& Other) const { return m_ValueIt == Other.m_ValueIt; }
+
+    private:
+        void SkipHoles()
+        {
+            while (m_ValueIt != m_ValueEndIt && !m_ValueIt->has_value())
+            {
+                ++m_ValueIt;
+            }
+        }
+
+    private:
+        ValueIteratorType m_ValueIt;
+        ValueIteratorType m_ValueEndIt;
+    };
+
+    using Iterator = IEIterator<T, typename std::vector<std::optional<T>>::iterator>;
+    using ConstIterator = IEIterator<const T, typename std::vector<std::optional<T>>::const_iterator>;
+
+public:
+    IEMidiSlotMap() = default;
+    IEMidiSlotMap(const IEMidiSlotMap&) = delete;
+    IEMidiSlotMap& operator=(const IEMidiSlotMap&) = delete;
+
+public:
+    // May move every value, references are only stable until the next emplace, handles always are
+    template<typename... ArgTypes>
+    std::pair<IEMidiSlotHandle, T&> Emplace(ArgTypes&&... Args);
+    void Remove(IEMidiSlotHandle Handle);
+    void Reserve(size_t Count);
+    void Clear();
+
+public:
+    T* Find(IEMidiSlotHandle Handle);
+    const T* Find(IEMidiSlotHandle Handle) const;
+    size_t Size() const { return m_Values.size() - m_HoleCount; }
+    bool IsEmpty() const { return Size() == 0; }
+
+public:
+    Iterator begin() { return Iterator(m_Values.begin(), m_Values.end()); }
+    Iterator end() { return Iterator(m_Values.end(), m_Values.end()); }
+    ConstIterator begin() const { return ConstIterator(m_Values.cbegin(), m_Values.cend()); }
+    ConstIterator end() const { return ConstIterator(m_Values.cend(), m_Values.cend()); }
+
+private:
+    void Compact();
+
+private:
+    struct IESlot
+    {
+        uint32_t ValueIndex = IEMidiSlotHandle::INVALID_SLOT_INDEX;
+        uint32_t Generation = 0;
+    };
+
+private:
+    std::vector<std::optional<T>> m_Values;
+    std::vector<uint32_t> m_ValueSlotIndices;
+    std::vector<IESlot> m_Slots;
+    std::vector<uint32_t> m_FreeSlotIndices;
+    size_t m_HoleCount = 0;
+};
+
+template<typename T>
+template<typename... ArgTypes>
+inline std::pair<IEMidiSlotHandle, T&> IEMidiSlotMap<T>::Emplace(ArgTypes&&... Args)
+{
+    if (m_HoleCount > 0 && m_HoleCount * 2 >= m_Values.size())
+    {
+        Compact();
+    }
+
+    uint32_t SlotIndex = 0;
+    if (!m_FreeSlotIndices.empty())
+    {
+        SlotIndex = m_FreeSlotIndices.back();
+        m_FreeSlotIndices.pop_back();
+    }
+    else
+    {
+        SlotIndex = static_cast<uint32_t>(m_Slots.size());
+        m_Slots.emplace_back();
+    }
+
+    IESlot& Slot = m_Slots[SlotIndex];
+    Slot.ValueIndex = static_cast<uint32_t>(m_Values.size());
+    m_ValueSlotIndices.emplace_back(SlotIndex);
+    T& Value = m_Values.emplace_back(std::in_place, std::forward<ArgTypes>(Args)...).value();
+    return {IEMidiSlotHandle{SlotIndex, Slot.Generation}, Value};
+}
+
+template<typename T>
+inline void IEMidiSlotMap<T>::Remove(IEMidiSlotHandle Handle)
+{
+    if (Find(Handle))
+    {
+        // Iterators stay valid, only Emplace moves values
+        IESlot& Slot = m_Slots[Handle.SlotIndex];
+        m_ValueSlotIndices[Slot.ValueIndex] = IEMidiSlotHandle::INVALID_SLOT_INDEX;
+        std::optional<T>& Value = m_Values[Slot.ValueIndex];
+        Slot.ValueIndex = IEMidiSlotHandle::INVALID_SLOT_INDEX;
+        Slot.Generation++;
+        m_FreeSlotIndices.emplace_back(Handle.SlotIndex);
+        m_HoleCount++;
+        Value.reset();
+    }
+}
+
+template<typename T>
+inline void IEMidiSlotMap<T>::Reserve(size_t Count)
+{
+    m_Values.reserve(Count);
+    m_ValueSlotIndices.reserve(Count);
+    m_Slots.reserve(Count);
+}
+
+template<typename T>
+inline void IEMidiSlotMap<T>::Clear()
+{
+    for (uint32_t SlotIndex : m_ValueSlotIndices)
+    {
+        if (SlotIndex != IEMidiSlotHandle::INVALID_SLOT_INDEX)
+        {
+            Remove(IEMidiSlotHandle{SlotIndex, m_Slots[SlotIndex].Generation});
+        }
+    }
+    Compact();
+}
+
+template<typename T>
+inline T* IEMidiSlotMap<T>::Find(IEMidiSlotHandle Handle)
+{
+    return const_cast<T*>(std::as_const(*this).Find(Handle));
+}
+
+template<typename T>
+inline const T* IEMidiSlotMap<T>::Find(IEMidiSlotHandle Handle) const
+{
+    if (Handle.SlotIndex < m_Slots.size())
+    {
+        const IESlot& Slot = m_Slots[Handle.SlotIndex];
+        if (Slot.Generation == Handle.Generation && Slot.ValueIndex != IEMidiSlotHandle::INVALID_SLOT_INDEX)
+        {
+            return &*m_Values[Slot.ValueIndex];
+        }
+    }
+    return nullptr;
+}
+
+template<typename T>
+inline void IEMidiSlotMap<T>::Compact()
+{
+    std::vector<std::optional<T>> Values;
+    std::vector<uint32_t> ValueSlotIndices;
+    Values.reserve(std::max(m_Values.capacity(), Size() + 1));
+    ValueSlotIndices.reserve(Values.capacity());
+    for (size_t i = 0; i < m_Values.size(); i++)
+    {
+        if (m_Values[i].has_value())
+        {
+            m_Slots[m_ValueSlotIndices[i]].ValueIndex = static_cast<uint32_t>(Values.size());
+            Values.emplace_back(std::in_place, std::move(*m_Values[i]));
+            ValueSlotIndices.emplace_back(m_ValueSlotIndices[i]);
+        }
+    }
+    m_Values = std::move(Values);
+    m_ValueSlotIndices = std::move(ValueSlotIndices);
+    m_HoleCount = 0;
+}
\ No newline at end of file
@@ -0,0 +1,49 @@
+// SPDX-License-Identifier: GPL-2.0-only
+// Copyright © Interactive Echoes. All rights reserved.
+// Author: mozahzah
+
+#include "IEMidiStartupStats.h"
+
+#include <chrono>
+
+#if defined(_WIN32)
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+#include "IELog.h"
+
+// Initialized with the other statics before main, the closest portable reading of process start
+static const std::chrono::steady_clock::time_point PROCESS_START_TIME = std::chrono::steady_clock::now();
+
+void IEMidiStartupStats::Log(const char* HostName, size_t ActiveMidiDeviceCount)
+{
+    const std::chrono::duration<double, std::milli> StartupTime = std::chrono::steady_clock::now() - PROCESS_START_TIME;
+    IELOG_SUCCESS("%s started with %zu active midi device(s) in %.1f ms, peak resident set size %.1f MB",
+        HostName, ActiveMidiDeviceCount, StartupTime.count(), GetPeakResidentSetSize() / (1024.0 * 1024.0));
+}
+
+size_t IEMidiStartupStats::GetPeakResidentSetSize()
+{
+#if defined(_WIN32)
+    PROCESS_MEMORY_COUNTERS ProcessMemoryCounters = {};
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &ProcessMemoryCounters, sizeof(ProcessMemoryCounters)))
+    {
+        return ProcessMemoryCounters.PeakWorkingSetSize;
+    }
+    return 0;
+#else
+    rusage ResourceUsage = {};
+    if (getrusage(RUSAGE_SELF, &ResourceUsage) == 0)
+    {
+#if defined(__APPLE__)
+        return static_cast<size_t>(ResourceUsage.ru_maxrss);
+#else
+        return static_cast<size_t>(ResourceUsage.ru_maxrss) * 1024;
+#endif
+    }
+    return 0;
+#endif
+}
\ No newline at end of file
@@ -0,0 +1,15 @@
+// SPDX-License-Identifier: GPL-2.0-only
+// Copyright © Interactive Echoes. All rights reserved.
+// Author: mozahzah
+
+#pragma once
+
+#include <cstddef>
+
+// Logged the same way by the app and the daemon once they are up, so their startup cost can be compared
+class IEMidiStartupStats
+{
+public:
+    static void Log(const char* HostName, size_t ActiveMidiDeviceCount);
+    static size_t GetPeakResidentSetSize();
+};
\ No newline at end of file
@@ -0,0 +1,94 @@
+// SPDX-License-Identifier: GPL-2.0-only
+// Copyright © Interactive Echoes. All rights reserved.
+// Author: mozahzah
+
+#include "IEMidiSubscriberTable.h"
+
+uint32_t IEMidiSubscriberTable::Subscribe(IEMidiSubscriberFunc Func, void* Object)
+{
+    if (Func)
+    {
+        for (uint32_t SlotIndex = 0; SlotIndex < MAX_SUBSCRIBER_COUNT; SlotIndex++)
+        {
+            IESlot& Slot = m_Slots[SlotIndex];
+            uint32_t State = Slot.State.load(std::memory_order_relaxed);
+            if (GetSlotState(State) == IESlotState::Free)
+            {
+                // A new generation per subscription, wrapping past zero so the handle is never invalid
+                uint32_t Generation = (GetSlotGeneration(State) + 1) & (UINT32_MAX >> (SLOT_STATE_BITS + SLOT_INDEX_BITS));
+                Generation = Generation == 0 ? 1 : Generation;
+                if (Slot.State.compare_exchange_strong(State, MakeSlotState(Generation, IESlotState::Reserved), std::memory_order_acquire))
+                {
+                    Slot.Func = Func;
+                    Slot.Object = Object;
+                    Slot.State.store(MakeSlotState(Generation, IESlotState::Active), std::memory_order_release);
+                    return (Generation << SLOT_INDEX_BITS) | SlotIndex;
+                }
+            }
+        }
+    }
+    return INVALID_HANDLE;
+}
+
+bool IEMidiSubscriberTable::Unsubscribe(uint32_t Handle)
+{
+    const uint32_t SlotIndex = Handle & SLOT_INDEX_MASK;
+    const uint32_t Generation = Handle >> SLOT_INDEX_BITS;
+    if (Handle != INVALID_HANDLE && SlotIndex < MAX_SUBSCRIBER_COUNT)
+    {
+        IESlot& Slot = m_Slots[SlotIndex];
+        uint32_t ActiveState = MakeSlotState(Generation, IESlotState::Active);
+        if (Slot.State.compare_exchange_strong(ActiveState, MakeSlotState(Generation, IESlotState::Removing), std::memory_order_seq_cst))
+        {
+            // Dispatchers that entered before the state change finish with the old subscriber
+            uint32_t DispatchCount = Slot.DispatchCount.load(std::memory_order_seq_cst);
+            while (DispatchCount != 0)
+            {
+                Slot.DispatchCount.wait(DispatchCount, std::memory_order_seq_cst);
+                DispatchCount = Slot.DispatchCount.load(std::memory_order_seq_cst);
+            }
+
+            Slot.Func = nullptr;
+            Slot.Object = nullptr;
+            Slot.State.store(MakeSlotState(Generation, IESlotState::Free), std::memory_order_release);
+            return true;
+        }
+    }
+    return false;
+}
+
+void IEMidiSubscriberTable::Dispatch(double TimeStamp, const IEMidiMessage& MidiMessage)
+{
+    for (IESlot& Slot : m_Slots)
+    {
+        const uint32_t State = Slot.State.load(std::memory_order_acquire);
+        if (GetSlotState(State) == IESlotState::Active)
+        {
+            Slot.DispatchCount.fetch_add(1, std::memory_order_seq_cst);
+
+            // Confirms the subscriber was not removed or replaced between the load and the announcement
+            if (Slot.State.load(std::memory_order_seq_cst) == State)
+            {
+                Slot.Func(Slot.Object, TimeStamp, MidiMessage);
+            }
+
+            if (Slot.DispatchCount.fetch_sub(1, std::memory_order_seq_cst) == 1)
+            {
+                Slot.DispatchCount.notify_all();
+            }
+        }
+    }
+}
+
+uint32_t IEMidiSubscriberTable::GetSubscriberCount() const
+{
+    uint32_t SubscriberCount = 0;
+    for (const IESlot& Slot : m_Slots)
+    {
+        if (GetSlotState(Slot.State.load(std::memory_order_relaxed)) == IESlotState::Active)
+        {
+            SubscriberCount++;
+        }
+    }
+    return SubscriberCount;
+}
\ No newline at end of file
@@ -0,0 +1,70 @@
+// SPDX-License-Identifier: GPL-2.0-only
+// Copyright © Interactive Echoes. All rights reserved.
+// Author: mozahzah
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+#include "IEMidiMessage.h"
+
+using IEMidiSubscriberFunc = void(*)(void* Object, double TimeStamp, const IEMidiMessage& MidiMessage);
+
+// Fixed capacity subscriber table, subscribing and unsubscribing is safe from any thread while the
+// midi threads dispatch. Subscribers are a plain function and object pair, so dispatching never
+// allocates. Handles carry the slot generation, a stale handle can never remove a newer subscriber.
+class IEMidiSubscriberTable
+{
+public:
+    static constexpr uint32_t MAX_SUBSCRIBER_COUNT = 32;
+    static constexpr uint32_t INVALID_HANDLE = 0;
+
+public:
+    IEMidiSubscriberTable() = default;
+    IEMidiSubscriberTable(const IEMidiSubscriberTable&) = delete;
+    IEMidiSubscriberTable& operator=(const IEMidiSubscriberTable&) = delete;
+
+public:
+    // Returns INVALID_HANDLE when the table is full
+    uint32_t Subscribe(IEMidiSubscriberFunc Func, void* Object);
+
+    // Blocks until a dispatch running the subscriber has returned, must not be called from within it
+    bool Unsubscribe(uint32_t Handle);
+
+    void Dispatch(double TimeStamp, const IEMidiMessage& MidiMessage);
+    uint32_t GetSubscriberCount() const;
+
+private:
+    enum class IESlotState : uint32_t
+    {
+        Free = 0,
+        Reserved,
+        Active,
+        Removing
+    };
+
+    struct IESlot
+    {
+        // Generation in the upper bits, IESlotState in the lower two
+        std::atomic<uint32_t> State = 0;
+        std::atomic<uint32_t> DispatchCount = 0;
+        IEMidiSubscriberFunc Func = nullptr;
+        void* Object = nullptr;
+    };
+
+private:
+    static constexpr uint32_t SLOT_STATE_BITS = 2;
+    static constexpr uint32_t SLOT_STATE_MASK = (1u << SLOT_STATE_BITS) - 1;
+    static constexpr uint32_t SLOT_INDEX_BITS = 8;
+    static constexpr uint32_t SLOT_INDEX_MASK = (1u << SLOT_INDEX_BITS) - 1;
+    static_assert(MAX_SUBSCRIBER_COUNT <= SLOT_INDEX_MASK);
+
+    static IESlotState GetSlotState(uint32_t State) { return static_cast<IESlotState>(State & SLOT_STATE_MASK); }
+    static uint32_t GetSlotGeneration(uint32_t State) { return State >> SLOT_STATE_BITS; }
+    static uint32_t MakeSlotState(uint32_t Generation, IESlotState SlotState) { return (Generation << SLOT_STATE_BITS) | static_cast<uint32_t>(SlotState); }
+
+private:
+    std::array<IESlot, MAX_SUBSCRIBER_COUNT> m_Slots;
+};
\ No newline at end of file
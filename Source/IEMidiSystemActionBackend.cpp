@@ -0,0 +1,57 @@
+// SPDX-License-Identifier: GPL-2.0-only
+// Copyright © Interactive Echoes. All rights reserved.
+// Author: mozahzah
+
+#include "IEMidiSystemActionBackend.h"
+
+IEMidiSystemActionBackend::IEMidiSystemActionBackend(IEMidiCommandRunner& CommandRunner) :
+    m_CommandRunner(CommandRunner),
+    m_VolumeAction(IEAction::GetVolumeAction()),
+    m_MuteAction(IEAction::GetMuteAction()),
+    m_ConsoleCommandAction(IEAction::GetConsoleCommandAction()),
+    m_OpenFileAction(IEAction::GetOpenFileAction())
+{}
+
+bool IEMidiSystemActionBackend::IsSupported(IEMidiActionType MidiActionType) const
+{
+    switch (MidiActionType)
+    {
+        case IEMidiActionType::Volume: return m_VolumeAction != nullptr;
+        case IEMidiActionType::Mute: return m_MuteAction != nullptr;
+        case IEMidiActionType::ConsoleCommand: return IEMidiCommandRunner::IsSupported() || m_ConsoleCommandAction != nullptr;
+        case IEMidiActionType::OpenFile: return m_OpenFileAction != nullptr;
+        default: return false;
+    }
+}
+
+void IEMidiSystemActionBackend::SetVolume(float Volume)
+{
+    m_VolumeAction->SetVolume(Volume);
+}
+
+bool IEMidiSystemActionBackend::GetMute() const
+{
+    return m_MuteAction->GetMute();
+}
+
+void IEMidiSystemActionBackend::SetMute(bool bIsMuted)
+{
+    m_MuteAction->SetMute(bIsMuted);
+}
+
+void IEMidiSystemActionBackend::ExecuteConsoleCommand(const std::shared_ptr<const IEMidiCompiledCommand>& CompiledCommand, float Value)
+{
+    if (IEMidiCommandRunner::IsSupported())
+    {
+        m_CommandRunner.Submit(CompiledCommand, Value);
+    }
+    else
+    {
+        m_ConsoleCommandAction->ExecuteConsoleCommand(CompiledCommand->ConsoleCommand, Value);
+    }
+}
+
+void IEMidiSystemActionBackend::OpenFile(const std::filesystem::path& OpenFilePath)
+{
+    m_OpenFileAction->OpenFile(OpenFilePath);
+}
\ No newline at end of file
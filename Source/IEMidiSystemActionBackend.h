@@ -0,0 +1,35 @@
+// SPDX-License-Identifier: GPL-2.0-only
+// Copyright © Interactive Echoes. All rights reserved.
+// Author: mozahzah
+
+#pragma once
+
+#include <memory>
+
+#include "IEActions.h"
+
+#include "IEMidiActionBackend.h"
+#include "IEMidiCommandRunner.h"
+
+// Applies actions to the system through IEActions, console commands go through the processor's
+// IEMidiCommandRunner where it is supported
+class IEMidiSystemActionBackend : public IEMidiActionBackend
+{
+public:
+    explicit IEMidiSystemActionBackend(IEMidiCommandRunner& CommandRunner);
+
+public:
+    bool IsSupported(IEMidiActionType MidiActionType) const override;
+    void SetVolume(float Volume) override;
+    bool GetMute() const override;
+    void SetMute(bool bIsMuted) override;
+    void ExecuteConsoleCommand(const std::shared_ptr<const IEMidiCompiledCommand>& CompiledCommand, float Value) override;
+    void OpenFile(const std::filesystem::path& OpenFilePath) override;
+
+private:
+    IEMidiCommandRunner& m_CommandRunner;
+    std::unique_ptr<IEAction_Volume> m_VolumeAction;
+    std::unique_ptr<IEAction_Mute> m_MuteAction;
+    std::unique_ptr<IEAction_ConsoleCommand> m_ConsoleCommandAction;
+    std::unique_ptr<IEAction_OpenFile> m_OpenFileAction;
+};
\ No newline at end of file
@@ -4,94 +4,99 @@
 
 #include "IEMidiTypes.h"
 
+#include <algorithm>
+
 IEMidiDeviceInputProperty& IEMidiDeviceProfile::MakeInputProperty()
 {
-    if (std::shared_ptr<IEMidiDeviceInputProperty> PropPtr = InputPropertiesHead)
-    {
-        while (PropPtr->Next())
-        {
-            PropPtr = PropPtr->m_NextProperty;
-        }
-        PropPtr->m_NextProperty = std::shared_ptr<IEMidiDeviceInputProperty>(new IEMidiDeviceInputProperty(*this, PropPtr));
-        return *(PropPtr->m_NextProperty);
-    }
-    else
-    {
-        InputPropertiesHead = std::shared_ptr<IEMidiDeviceInputProperty>(new IEMidiDeviceInputProperty(*this, nullptr));
-        return *InputPropertiesHead;
-    }
+    auto [Handle, MidiDeviceInputProperty] = InputProperties.Emplace(*this);
+    MidiDeviceInputProperty.m_Handle = Handle;
+    return MidiDeviceInputProperty;
 }
 
 IEMidiDeviceOutputProperty& IEMidiDeviceProfile::MakeOutputProperty()
 {
-    if (std::shared_ptr<IEMidiDeviceOutputProperty> PropPtr = OutputPropertiesHead)
+    auto [Handle, MidiDeviceOutputProperty] = OutputProperties.Emplace(*this);
+    MidiDeviceOutputProperty.m_Handle = Handle;
+    return MidiDeviceOutputProperty;
+}
+
+std::chrono::steady_clock::duration IEMidiDeviceInputProperty::GetCoalesceInterval() const
+{
+    const uint32_t RateHz = std::max<uint32_t>(CoalesceRateHz, 1);
+    return std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::nanoseconds(1'000'000'000 / RateHz));
+}
+
+bool IEMidiDeviceInputProperty::IsRecording() const
+{
+    return RuntimeState->bIsRecording.load(std::memory_order_acquire);
+}
+
+void IEMidiDeviceInputProperty::SetRecording(bool bIsRecording)
+{
+    if (RuntimeState->bIsRecording.exchange(bIsRecording, std::memory_order_acq_rel) != bIsRecording)
     {
-        while (PropPtr->Next())
+        if (bIsRecording)
         {
-            PropPtr = PropPtr->m_NextProperty;
+            // Only this thread raises the count, so a zero here is the start of a new learn session
+            if (MidiDeviceProfile.RuntimeState->RecordingCount.load(std::memory_order_acquire) == 0)
+            {
+                MidiDeviceProfile.RuntimeState->LearnSessionID.fetch_add(1, std::memory_order_release);
+            }
+            MidiDeviceProfile.RuntimeState->RecordingCount.fetch_add(1, std::memory_order_release);
+        }
+        else
+        {
+            MidiDeviceProfile.RuntimeState->RecordingCount.fetch_sub(1, std::memory_order_release);
         }
-        PropPtr->m_NextProperty = std::shared_ptr<IEMidiDeviceOutputProperty>(new IEMidiDeviceOutputProperty(*this, PropPtr));
-        return *(PropPtr->m_NextProperty);
-    }
-    else
-    {
-        OutputPropertiesHead = std::shared_ptr<IEMidiDeviceOutputProperty>(new IEMidiDeviceOutputProperty(*this, nullptr));
-        return *OutputPropertiesHead;
     }
 }
 
-IEMidiDeviceInputProperty::~IEMidiDeviceInputProperty()
+bool IEMidiDeviceInputProperty::HasSameMapping(const IEMidiDeviceInputProperty& Other) const
 {
-    m_PreviousProperty.reset();
-    m_NextProperty.reset();
+    return MidiMessageType == Other.MidiMessageType &&
+        MidiActionType == Other.MidiActionType &&
+        ConsoleCommand == Other.ConsoleCommand &&
+        OpenFilePath == Other.OpenFilePath &&
+        MidiMessage == Other.MidiMessage &&
+        bIsMidiToggle == Other.bIsMidiToggle &&
+        bIsCoalesced == Other.bIsCoalesced &&
+        CoalesceRateHz == Other.CoalesceRateHz &&
+        bIsConsoleCommandPersistent == Other.bIsConsoleCommandPersistent;
 }
 
-IEMidiDeviceInputProperty* IEMidiDeviceInputProperty::Next() const
+void IEMidiDeviceInputProperty::CopyMapping(const IEMidiDeviceInputProperty& Other)
 {
-    return m_NextProperty.get();
+    MidiMessageType = Other.MidiMessageType;
+    MidiActionType = Other.MidiActionType;
+    ConsoleCommand = Other.ConsoleCommand;
+    OpenFilePath = Other.OpenFilePath;
+    MidiMessage = Other.MidiMessage;
+    bIsMidiToggle = Other.bIsMidiToggle;
+    bIsCoalesced = Other.bIsCoalesced;
+    CoalesceRateHz = Other.CoalesceRateHz;
+    bIsConsoleCommandPersistent = Other.bIsConsoleCommandPersistent;
 }
 
-IEMidiDeviceOutputProperty::~IEMidiDeviceOutputProperty()
+void IEMidiDeviceInputProperty::CopyMapping(IEMidiDeviceInputProperty&& Other)
 {
-    m_PreviousProperty.reset();
-    m_NextProperty.reset();
-}
-
-IEMidiDeviceOutputProperty* IEMidiDeviceOutputProperty::Next() const
-{
-    return m_NextProperty.get();
+    MidiMessageType = Other.MidiMessageType;
+    MidiActionType = Other.MidiActionType;
+    ConsoleCommand = std::move(Other.ConsoleCommand);
+    OpenFilePath = std::move(Other.OpenFilePath);
+    MidiMessage = std::move(Other.MidiMessage);
+    bIsMidiToggle = Other.bIsMidiToggle;
+    bIsCoalesced = Other.bIsCoalesced;
+    CoalesceRateHz = Other.CoalesceRateHz;
+    bIsConsoleCommandPersistent = Other.bIsConsoleCommandPersistent;
 }
 
 void IEMidiDeviceInputProperty::Delete()
 {
-    if (m_NextProperty)
-    {
-        m_NextProperty->m_PreviousProperty = m_PreviousProperty;
-    }
-
-    if (std::shared_ptr<IEMidiDeviceInputProperty> const PreviousProperty = m_PreviousProperty.lock())
-    {
-        PreviousProperty->m_NextProperty = m_NextProperty;
-    }
-    else
-    {
-        MidiDeviceProfile.InputPropertiesHead = m_NextProperty;
-    }
+    SetRecording(false);
+    MidiDeviceProfile.InputProperties.Remove(m_Handle);
 }
 
 void IEMidiDeviceOutputProperty::Delete()
 {
-    if (m_NextProperty)
-    {
-        m_NextProperty->m_PreviousProperty = m_PreviousProperty;
-    }
-
-    if (std::shared_ptr<IEMidiDeviceOutputProperty> const PreviousProperty = m_PreviousProperty.lock())
-    {
-        PreviousProperty->m_NextProperty = m_NextProperty;
-    }
-    else
-    {
-        MidiDeviceProfile.OutputPropertiesHead = m_NextProperty;
-    }
+    MidiDeviceProfile.OutputProperties.Remove(m_Handle);
 }
\ No newline at end of file
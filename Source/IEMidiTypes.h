@@ -5,6 +5,8 @@
 #pragma once
 
 #include <array>
+#include <atomic>
+#include <chrono>
 #include <cstdint>
 #include <filesystem>
 #include <memory>
@@ -13,17 +15,40 @@
 
 #include "IELog.h"
 
-static constexpr size_t MIDI_MESSAGE_BYTE_COUNT = 3;
+#include "IEMidiMessage.h"
+#include "IEMidiSlotMap.h"
+
+struct IEMidiCompiledCommand;
+
+static constexpr uint32_t DEFAULT_COALESCE_RATE_HZ = 60;
 
 enum class IEMidiMessageType : uint8_t
 {
     None,
     NoteOnOff,
     ControlChange,
+    ProgramChange,
+    ChannelAftertouch,
+    PolyAftertouch,
 
     Count,
 };
 
+// Message types whose value is a position (faders, knobs, pressure) rather than a press
+constexpr bool IsContinuousMidiMessageType(IEMidiMessageType MidiMessageType)
+{
+    return MidiMessageType == IEMidiMessageType::ControlChange ||
+        MidiMessageType == IEMidiMessageType::ChannelAftertouch ||
+        MidiMessageType == IEMidiMessageType::PolyAftertouch;
+}
+
+// Message types that act like a button press
+constexpr bool IsTriggerMidiMessageType(IEMidiMessageType MidiMessageType)
+{
+    return MidiMessageType == IEMidiMessageType::NoteOnOff ||
+        MidiMessageType == IEMidiMessageType::ProgramChange;
+}
+
 enum class IEMidiActionType : uint8_t
 {
     None,
@@ -35,59 +60,97 @@ enum class IEMidiActionType : uint8_t
     Count,
 };
 
-struct IEMidiDeviceInputProperty;
-struct IEMidiDeviceOutputProperty;
-    
-struct IEMidiDeviceProfile
+inline const char* GetMidiActionTypeName(IEMidiActionType MidiActionType)
 {
-public:
-    explicit IEMidiDeviceProfile(const std::string& _NameID, uint32_t _InputPortNumber, uint32_t _OutputPortNumer) :
-        NameID(_NameID),
-        InputPortNumber(_InputPortNumber),
-        OutputPortNumber(_OutputPortNumer)
+    switch (MidiActionType)
+    {
+        case IEMidiActionType::Volume: return "Volume";
+        case IEMidiActionType::Mute: return "Mute";
+        case IEMidiActionType::ConsoleCommand: return "ConsoleCommand";
+        case IEMidiActionType::OpenFile: return "OpenFile";
+        default: return "None";
+    }
+}
+
+// Compact copy of a message for the midi logger, it never holds on to a SysEx pool slot
+struct IEMidiLogEntry
+{
+    IEMidiLogEntry() = default;
+    explicit IEMidiLogEntry(const IEMidiMessage& MidiMessage) :
+        Bytes({MidiMessage[0], MidiMessage[1], MidiMessage[2]}),
+        Size(static_cast<uint32_t>(MidiMessage.size()))
     {}
-    IEMidiDeviceProfile(const IEMidiDeviceProfile&) = delete;
-    IEMidiDeviceProfile& operator=(const IEMidiDeviceProfile&) = delete;
-    IEMidiDeviceProfile(IEMidiDeviceProfile&&) = delete;
-    IEMidiDeviceProfile& operator=(IEMidiDeviceProfile&&) = delete;
 
-    IEMidiDeviceInputProperty& MakeInputProperty();
-    IEMidiDeviceOutputProperty& MakeOutputProperty();
+    bool IsSysEx() const { return Bytes[0] == 0xF0; }
 
-public:
-    const std::string NameID;
-    const uint32_t InputPortNumber;
-    const uint32_t OutputPortNumber;
+    std::array<uint8_t, MIDI_MESSAGE_BYTE_COUNT> Bytes = {0, 0, 0};
+    uint32_t Size = 0;
+};
 
-public:
-    std::shared_ptr<IEMidiDeviceInputProperty> InputPropertiesHead;
-    std::shared_ptr<IEMidiDeviceOutputProperty> OutputPropertiesHead;
+// Published by a midi input thread when an armed input property learned a message
+struct IEMidiLearnEvent
+{
+    IEMidiSlotHandle PropertyHandle;
+    IEMidiMessage MidiMessage;
+};
+
+struct IEMidiDeviceProfile;
+
+// Runtime state shared between a profile and its compiled snapshots so it survives recompiles
+struct IEMidiDeviceProfileState
+{
+    std::atomic<uint32_t> RecordingCount = 0;
+
+    // Bumped when the first property of a learn session is armed
+    std::atomic<uint32_t> LearnSessionID = 0;
+};
+
+struct IEMidiInputPropertyState
+{
+    // Midi learn, armed by the UI and claimed by the midi input thread
+    std::atomic<bool> bIsRecording = false;
+
+    // Only touched by the action worker except for the counter
+    bool bIsConsoleCommandActive = false;
+    IEMidiMessage PendingMidiMessage;
+    std::chrono::steady_clock::time_point PendingReceivedTime;
+    bool bHasPendingMidiMessage = false;
+    std::chrono::steady_clock::time_point LastAppliedTime;
+    std::atomic<uint64_t> CoalescedUpdateCount = 0;
 };
 
+// Made through IEMidiDeviceProfile::MakeInputProperty. Lives in the profile's slot map, so widgets
+// keep its handle rather than a reference.
 struct IEMidiDeviceInputProperty
 {
-private:
-    IEMidiDeviceInputProperty(IEMidiDeviceProfile& _MidiDeviceProfile, const std::shared_ptr<IEMidiDeviceInputProperty>& PreviousProperty) :
-        MidiDeviceProfile(_MidiDeviceProfile),
-        m_PreviousProperty(PreviousProperty)
+public:
+    explicit IEMidiDeviceInputProperty(IEMidiDeviceProfile& _MidiDeviceProfile) :
+        MidiDeviceProfile(_MidiDeviceProfile)
     {}
     IEMidiDeviceInputProperty(const IEMidiDeviceInputProperty&) = delete;
     IEMidiDeviceInputProperty& operator=(const IEMidiDeviceInputProperty&) = delete;
-    IEMidiDeviceInputProperty(IEMidiDeviceInputProperty&&) = delete;
+    IEMidiDeviceInputProperty(IEMidiDeviceInputProperty&&) = default;
     IEMidiDeviceInputProperty& operator=(IEMidiDeviceInputProperty&&) = delete;
 
 public:
-    ~IEMidiDeviceInputProperty();
+    IEMidiSlotHandle GetHandle() const { return m_Handle; }
 
 public:
-    IEMidiDeviceInputProperty* Next() const;
+    // Destroys this property, must be the last use of it
+    void Delete();
+    std::chrono::steady_clock::duration GetCoalesceInterval() const;
+    bool IsRecording() const;
+    void SetRecording(bool bIsRecording);
 
 public:
-    void Delete();
+    // Compare, copy or move the serialized variables only, the runtime state is left as is
+    bool HasSameMapping(const IEMidiDeviceInputProperty& Other) const;
+    void CopyMapping(const IEMidiDeviceInputProperty& Other);
+    void CopyMapping(IEMidiDeviceInputProperty&& Other);
 
 public:
     IEMidiDeviceProfile& MidiDeviceProfile;
-    friend IEMidiDeviceInputProperty& IEMidiDeviceProfile::MakeInputProperty();
+    friend struct IEMidiDeviceProfile;
 
 public:
     // Serialized variables
@@ -95,49 +158,85 @@ public:
     IEMidiActionType MidiActionType = IEMidiActionType::None;
     std::string ConsoleCommand = std::string();
     std::filesystem::path OpenFilePath = std::filesystem::path();
-    std::array<uint8_t, MIDI_MESSAGE_BYTE_COUNT> MidiMessage = {0, 0, 0};
+    IEMidiMessage MidiMessage = IEMidiMessage({0, 0, 0});
     bool bIsMidiToggle = false;
+    bool bIsCoalesced = false;
+    uint32_t CoalesceRateHz = DEFAULT_COALESCE_RATE_HZ;
+    bool bIsConsoleCommandPersistent = false;
 
 public:
     // Runtime
-    bool bIsRecording = false;
-    bool bIsConsoleCommandActive = false;
+    const std::shared_ptr<IEMidiInputPropertyState> RuntimeState = std::make_shared<IEMidiInputPropertyState>();
 
 private:
-    std::weak_ptr<IEMidiDeviceInputProperty> m_PreviousProperty;
-    std::shared_ptr<IEMidiDeviceInputProperty> m_NextProperty;
+    IEMidiSlotHandle m_Handle;
 };
 
 struct IEMidiDeviceOutputProperty
 {
-private:
-    IEMidiDeviceOutputProperty(IEMidiDeviceProfile& _MidiDeviceProfile, const std::shared_ptr<IEMidiDeviceOutputProperty>& PreviousProperty) :
-        MidiDeviceProfile(_MidiDeviceProfile),
-        m_PreviousProperty(PreviousProperty)
+public:
+    explicit IEMidiDeviceOutputProperty(IEMidiDeviceProfile& _MidiDeviceProfile) :
+        MidiDeviceProfile(_MidiDeviceProfile)
     {}
     IEMidiDeviceOutputProperty(const IEMidiDeviceOutputProperty&) = delete;
     IEMidiDeviceOutputProperty& operator=(const IEMidiDeviceOutputProperty&) = delete;
-    IEMidiDeviceOutputProperty(IEMidiDeviceOutputProperty&&) = delete;
+    IEMidiDeviceOutputProperty(IEMidiDeviceOutputProperty&&) = default;
     IEMidiDeviceOutputProperty& operator=(IEMidiDeviceOutputProperty&&) = delete;
 
 public:
-    ~IEMidiDeviceOutputProperty();
-
-public:
-    IEMidiDeviceOutputProperty* Next() const;
+    IEMidiSlotHandle GetHandle() const { return m_Handle; }
 
 public:
+    // Destroys this property, must be the last use of it
     void Delete();
 
 public:
     IEMidiDeviceProfile& MidiDeviceProfile;
-    friend IEMidiDeviceOutputProperty& IEMidiDeviceProfile::MakeOutputProperty();
+    friend struct IEMidiDeviceProfile;
 
 public:
     // Serialized variables
-    std::array<uint8_t, MIDI_MESSAGE_BYTE_COUNT> MidiMessage = { 0, 0, 0 };
+    IEMidiMessage MidiMessage = IEMidiMessage({0, 0, 0});
 
 private:
-    std::weak_ptr<IEMidiDeviceOutputProperty> m_PreviousProperty;
-    std::shared_ptr<IEMidiDeviceOutputProperty> m_NextProperty;
+    IEMidiSlotHandle m_Handle;
+};
+    
+struct IEMidiDeviceProfile
+{
+public:
+    explicit IEMidiDeviceProfile(const std::string& _NameID, uint32_t _InputPortNumber, uint32_t _OutputPortNumer) :
+        NameID(_NameID),
+        InputPortNumber(_InputPortNumber),
+        OutputPortNumber(_OutputPortNumer)
+    {}
+    IEMidiDeviceProfile(const IEMidiDeviceProfile&) = delete;
+    IEMidiDeviceProfile& operator=(const IEMidiDeviceProfile&) = delete;
+    IEMidiDeviceProfile(IEMidiDeviceProfile&&) = delete;
+    IEMidiDeviceProfile& operator=(IEMidiDeviceProfile&&) = delete;
+
+    // Appending may move the existing properties, see IEMidiSlotMap
+    IEMidiDeviceInputProperty& MakeInputProperty();
+    IEMidiDeviceOutputProperty& MakeOutputProperty();
+
+public:
+    const std::string NameID;
+    const uint32_t InputPortNumber;
+    const uint32_t OutputPortNumber;
+    const std::shared_ptr<IEMidiDeviceProfileState> RuntimeState = std::make_shared<IEMidiDeviceProfileState>();
+
+public:
+    IEMidiSlotMap<IEMidiDeviceInputProperty> InputProperties;
+    IEMidiSlotMap<IEMidiDeviceOutputProperty> OutputProperties;
+};
+
+// Cold part of an input property taken when a profile is compiled, read by the midi threads once a
+// message matched. The fields needed for matching live in the profile's IEMidiDispatchTable.
+struct IEMidiCompiledInputProperty
+{
+    IEMidiSlotHandle PropertyHandle;
+    std::shared_ptr<const IEMidiCompiledCommand> CompiledCommand;
+    std::filesystem::path OpenFilePath = std::filesystem::path();
+    std::chrono::steady_clock::duration CoalesceInterval = std::chrono::steady_clock::duration::zero();
+    std::shared_ptr<IEMidiInputPropertyState> RuntimeState;
 };
\ No newline at end of file
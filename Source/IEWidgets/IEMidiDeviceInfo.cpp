@@ -5,10 +5,17 @@
 #include "IEMidiDeviceInfo.h"
 
 #include "qboxlayout.h"
+#include "qclipboard.h"
+#include "qguiapplication.h"
 #include "qheaderview.h"
 #include "qlabel.h"
+#include "qpushbutton.h"
 
-IEMidiDeviceInfo::IEMidiDeviceInfo(const IEMidiProcessor& MidiProcessor, QWidget* Parent) :
+#include "IELog.h"
+
+static constexpr int LATENCY_REFRESH_INTERVAL_MS = 500;
+
+IEMidiDeviceInfo::IEMidiDeviceInfo(IEMidiProcessor& MidiProcessor, QWidget* Parent) :
     QFrame(Parent),
     m_MidiProcessor(MidiProcessor)
 {
@@ -26,7 +33,7 @@ IEMidiDeviceInfo::IEMidiDeviceInfo(const IEMidiProcessor& MidiProcessor, QWidget
             }
         )");
 
-        QTableWidget* const MidiDeviceInfoTableWidget = new QTableWidget(5, 2, this);
+        QTableWidget* const MidiDeviceInfoTableWidget = new QTableWidget(6, 2, this);
         MidiDeviceInfoTableWidget->setSizePolicy(QSizePolicy::Minimum, QSizePolicy::Minimum);
         MidiDeviceInfoTableWidget->setEditTriggers(QAbstractItemView::NoEditTriggers);
         MidiDeviceInfoTableWidget->setSelectionMode(QAbstractItemView::NoSelection);
@@ -70,12 +77,123 @@ IEMidiDeviceInfo::IEMidiDeviceInfo(const IEMidiProcessor& MidiProcessor, QWidget
         MidiDeviceInfoTableWidget->setItem(4, 0, CreateCenteredTableWidgetItem("Version:", true));
         MidiDeviceInfoTableWidget->setItem(4, 1, CreateCenteredTableWidgetItem("2"));
 
+        MidiDeviceInfoTableWidget->setItem(5, 0, CreateCenteredTableWidgetItem("Active Devices:", true));
+        MidiDeviceInfoTableWidget->setItem(5, 1, CreateCenteredTableWidgetItem(
+            std::to_string(m_MidiProcessor.GetActiveMidiDeviceNames().size()).c_str()));
+
+        // Completion latency per action type, measured from the RtMidi callback entry
+        const int LatencyRowCount = static_cast<int>(IEMidiActionType::Count) - 1;
+        m_LatencyTableWidget = new QTableWidget(LatencyRowCount + 1, 4, this);
+        m_LatencyTableWidget->setSizePolicy(QSizePolicy::Minimum, QSizePolicy::Minimum);
+        m_LatencyTableWidget->setEditTriggers(QAbstractItemView::NoEditTriggers);
+        m_LatencyTableWidget->setSelectionMode(QAbstractItemView::NoSelection);
+        m_LatencyTableWidget->setFocusPolicy(Qt::NoFocus);
+        m_LatencyTableWidget->setMouseTracking(false);
+        m_LatencyTableWidget->setAutoFillBackground(false);
+        m_LatencyTableWidget->setShowGrid(false);
+        m_LatencyTableWidget->setHorizontalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
+        m_LatencyTableWidget->setVerticalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
+        m_LatencyTableWidget->setContentsMargins(0, 0, 0, 0);
+
+        if (QHeaderView* const HHeader = m_LatencyTableWidget->horizontalHeader())
+        {
+            HHeader->setVisible(false);
+            HHeader->setSectionResizeMode(QHeaderView::Stretch);
+        }
+
+        if (QHeaderView* const VHeader = m_LatencyTableWidget->verticalHeader())
+        {
+            VHeader->setVisible(false);
+            VHeader->setSectionResizeMode(QHeaderView::Stretch);
+        }
+
+        m_LatencyTableWidget->setItem(0, 0, CreateCenteredTableWidgetItem("Latency:", true));
+        m_LatencyTableWidget->setItem(0, 1, CreateCenteredTableWidgetItem("P50", true));
+        m_LatencyTableWidget->setItem(0, 2, CreateCenteredTableWidgetItem("P99", true));
+        m_LatencyTableWidget->setItem(0, 3, CreateCenteredTableWidgetItem("Max", true));
+        for (int Row = 1; Row <= LatencyRowCount; Row++)
+        {
+            m_LatencyTableWidget->setItem(Row, 0, CreateCenteredTableWidgetItem(GetMidiActionTypeName(static_cast<IEMidiActionType>(Row))));
+            for (int Column = 1; Column < 4; Column++)
+            {
+                m_LatencyTableWidget->setItem(Row, Column, CreateCenteredTableWidgetItem("-"));
+            }
+        }
+
+        QWidget* const LatencyButtonsWidget = new QWidget(this);
+        QHBoxLayout* const LatencyButtonsLayout = new QHBoxLayout(LatencyButtonsWidget);
+        LatencyButtonsLayout->setContentsMargins(0, 0, 0, 0);
+
+        QPushButton* const LatencyResetButton = new QPushButton("Reset", LatencyButtonsWidget);
+        LatencyResetButton->connect(LatencyResetButton, &QPushButton::pressed, this, &IEMidiDeviceInfo::OnLatencyResetButtonPressed);
+        LatencyButtonsLayout->addWidget(LatencyResetButton);
+
+        QPushButton* const LatencyDumpButton = new QPushButton("Dump", LatencyButtonsWidget);
+        LatencyDumpButton->connect(LatencyDumpButton, &QPushButton::pressed, this, &IEMidiDeviceInfo::OnLatencyDumpButtonPressed);
+        LatencyButtonsLayout->addWidget(LatencyDumpButton);
+
+        m_LatencyRefreshTimer = new QTimer(this);
+        m_LatencyRefreshTimer->connect(m_LatencyRefreshTimer, &QTimer::timeout, this, &IEMidiDeviceInfo::OnLatencyRefreshTimeout);
+        m_LatencyRefreshTimer->start(LATENCY_REFRESH_INTERVAL_MS);
+
         QVBoxLayout* const Layout = new QVBoxLayout(this);
         Layout->setContentsMargins(30, 30, 30, 20);
         Layout->addWidget(MidiDeviceInfoLabel);
         Layout->addSpacing(30);
         Layout->addWidget(MidiDeviceInfoTableWidget, 1);
+        Layout->addSpacing(10);
+        Layout->addWidget(m_LatencyTableWidget, 1);
+        Layout->addWidget(LatencyButtonsWidget);
+    }
+}
+
+void IEMidiDeviceInfo::OnLatencyRefreshTimeout() const
+{
+    if (m_LatencyTableWidget && isVisible())
+    {
+        for (int Row = 1; Row < m_LatencyTableWidget->rowCount(); Row++)
+        {
+            const IEMidiLatencySnapshot LatencySnapshot = m_MidiProcessor.GetLatencySnapshot(static_cast<IEMidiActionType>(Row), IEMidiLatencyStage::Completion);
+            if (LatencySnapshot.Count > 0)
+            {
+                m_LatencyTableWidget->item(Row, 1)->setText(GetLatencyText(LatencySnapshot.GetPercentile(50.0)));
+                m_LatencyTableWidget->item(Row, 2)->setText(GetLatencyText(LatencySnapshot.GetPercentile(99.0)));
+                m_LatencyTableWidget->item(Row, 3)->setText(GetLatencyText(LatencySnapshot.GetMax()));
+            }
+            else
+            {
+                for (int Column = 1; Column < 4; Column++)
+                {
+                    m_LatencyTableWidget->item(Row, Column)->setText("-");
+                }
+            }
+        }
+    }
+}
+
+void IEMidiDeviceInfo::OnLatencyResetButtonPressed() const
+{
+    m_MidiProcessor.ResetLatencyHistograms();
+    OnLatencyRefreshTimeout();
+}
+
+void IEMidiDeviceInfo::OnLatencyDumpButtonPressed() const
+{
+    const std::string LatencyDump = m_MidiProcessor.DumpLatencyHistograms();
+    IELOG_SUCCESS("Midi latency histograms\n%s", LatencyDump.c_str());
+    if (QClipboard* const Clipboard = QGuiApplication::clipboard())
+    {
+        Clipboard->setText(QString::fromStdString(LatencyDump));
+    }
+}
+
+QString IEMidiDeviceInfo::GetLatencyText(std::chrono::nanoseconds Latency) const
+{
+    if (Latency < std::chrono::milliseconds(1))
+    {
+        return QString("%1 us").arg(Latency.count() / 1000.0, 0, 'f', 0);
     }
+    return QString("%1 ms").arg(Latency.count() / 1000000.0, 0, 'f', 1);
 }
 
 QTableWidgetItem* IEMidiDeviceInfo::CreateCenteredTableWidgetItem(const QString& Text, bool bBold) const
@@ -6,6 +6,7 @@
 
 #include "qframe.h"
 #include "qtablewidget.h"
+#include "qtimer.h"
 #include "qwidget.h"
 
 #include "IEMidiProcessor.h"
@@ -15,11 +16,19 @@ class IEMidiDeviceInfo : public QFrame
     Q_OBJECT
 
 public:
-    explicit IEMidiDeviceInfo(const IEMidiProcessor& MidiProcessor, QWidget* Parent = nullptr);
+    explicit IEMidiDeviceInfo(IEMidiProcessor& MidiProcessor, QWidget* Parent = nullptr);
+
+private:
+    void OnLatencyRefreshTimeout() const;
+    void OnLatencyResetButtonPressed() const;
+    void OnLatencyDumpButtonPressed() const;
 
 private:
     QTableWidgetItem* CreateCenteredTableWidgetItem(const QString& Text, bool bBold = false) const;
+    QString GetLatencyText(std::chrono::nanoseconds Latency) const;
 
 private:
-    const IEMidiProcessor& m_MidiProcessor;
+    IEMidiProcessor& m_MidiProcessor;
+    QTableWidget* m_LatencyTableWidget = nullptr;
+    QTimer* m_LatencyRefreshTimer = nullptr;
 };
\ No newline at end of file
@@ -7,7 +7,6 @@
 #include "IELog.h"
 #include "qboxlayout.h"
 #include "qcheckbox.h"
-#include "qcoreevent.h"
 #include "qlineedit.h"
 #include "qmetaobject.h"
 #include "qpushbutton.h"
@@ -15,61 +14,77 @@
 #include "IEDeletePropertyButton.h"
 #include "IEFileBrowserWidget.h"
 #include "IEMidiActionTypeDropdown.h"
+#include "IEMidiCommandRunner.h"
 #include "IEMidiMessageEditor.h"
 #include "IEMidiMessageTypeDropdown.h"
 #include "IERecordButton.h"
 
 IEMidiDeviceInputPropertyEditor::IEMidiDeviceInputPropertyEditor(IEMidiDeviceInputProperty& MidiDeviceInputProperty, QWidget* Parent) :
     QWidget(Parent),
-    m_MidiDeviceInputProperty(MidiDeviceInputProperty)
+    m_MidiDeviceProfile(MidiDeviceInputProperty.MidiDeviceProfile),
+    m_MidiDeviceInputPropertyHandle(MidiDeviceInputProperty.GetHandle())
 {
     QWidget* const SubWidget1 = new QWidget(this);
 
     m_MidiMessageTypeDropdownWidget = new IEMidiMessageTypeDropdown(SubWidget1);
-    m_MidiMessageTypeDropdownWidget->SetValue(m_MidiDeviceInputProperty.MidiMessageType);
+    m_MidiMessageTypeDropdownWidget->SetValue(MidiDeviceInputProperty.MidiMessageType);
     m_MidiMessageTypeDropdownWidget->connect(m_MidiMessageTypeDropdownWidget, &IEMidiMessageTypeDropdown::OnMidiMessageTypeChanged,
         this, &IEMidiDeviceInputPropertyEditor::OnMidiMessageTypeChanged);
 
     m_MidiToggleCheckboxWidget = new QCheckBox("Toggle", SubWidget1);
-    m_MidiToggleCheckboxWidget->setChecked(m_MidiDeviceInputProperty.bIsMidiToggle);
+    m_MidiToggleCheckboxWidget->setChecked(MidiDeviceInputProperty.bIsMidiToggle);
     m_MidiToggleCheckboxWidget->hide(); // Start hidden
     m_MidiToggleCheckboxWidget->connect(m_MidiToggleCheckboxWidget, &QCheckBox::checkStateChanged, this, &IEMidiDeviceInputPropertyEditor::OnMidiToggleChanged);
 
+    m_MidiCoalesceCheckboxWidget = new QCheckBox("Coalesce", SubWidget1);
+    m_MidiCoalesceCheckboxWidget->setChecked(MidiDeviceInputProperty.bIsCoalesced);
+    m_MidiCoalesceCheckboxWidget->setToolTip(QString("Apply at most %1 updates per second, keeping only the latest value").arg(MidiDeviceInputProperty.CoalesceRateHz));
+    m_MidiCoalesceCheckboxWidget->hide(); // Start hidden
+    m_MidiCoalesceCheckboxWidget->connect(m_MidiCoalesceCheckboxWidget, &QCheckBox::checkStateChanged, this, &IEMidiDeviceInputPropertyEditor::OnMidiCoalesceChanged);
+
     m_MidiActionTypeDropdownWidget = new IEMidiActionTypeDropdown(SubWidget1);
-    m_MidiActionTypeDropdownWidget->SetValue(m_MidiDeviceInputProperty.MidiActionType);
+    m_MidiActionTypeDropdownWidget->SetValue(MidiDeviceInputProperty.MidiActionType);
     m_MidiActionTypeDropdownWidget->connect(m_MidiActionTypeDropdownWidget, &IEMidiActionTypeDropdown::OnMidiActionTypeChanged,
         this, &IEMidiDeviceInputPropertyEditor::OnMidiActionTypeChanged);
 
     m_OpenFileBrowserWidget = new IEFileBrowserWidget(SubWidget1);
-    m_OpenFileBrowserWidget->SetFilePath(m_MidiDeviceInputProperty.OpenFilePath);
+    m_OpenFileBrowserWidget->SetFilePath(MidiDeviceInputProperty.OpenFilePath);
     m_OpenFileBrowserWidget->hide(); // Start hidden
     m_OpenFileBrowserWidget->connect(m_OpenFileBrowserWidget, &IEFileBrowserWidget::OnFilePathCommitted, this, &IEMidiDeviceInputPropertyEditor::OnOpenFilePathCommited);
 
     m_ConsoleCommandWidget = new QLineEdit(SubWidget1);
     m_ConsoleCommandWidget->setPlaceholderText("Command");
-    m_ConsoleCommandWidget->setText(QString::fromStdString(m_MidiDeviceInputProperty.ConsoleCommand));
+    m_ConsoleCommandWidget->setText(QString::fromStdString(MidiDeviceInputProperty.ConsoleCommand));
     m_ConsoleCommandWidget->hide(); // Start hidden
     m_ConsoleCommandWidget->connect(m_ConsoleCommandWidget, &QLineEdit::editingFinished, this, &IEMidiDeviceInputPropertyEditor::OnConsoleCommandTextCommited);
 
+    m_ConsoleCommandPersistentCheckboxWidget = new QCheckBox("Keep Running", SubWidget1);
+    m_ConsoleCommandPersistentCheckboxWidget->setChecked(MidiDeviceInputProperty.bIsConsoleCommandPersistent);
+    m_ConsoleCommandPersistentCheckboxWidget->setToolTip("Start the command once and write each value as a line to its standard input");
+    m_ConsoleCommandPersistentCheckboxWidget->hide(); // Start hidden
+    m_ConsoleCommandPersistentCheckboxWidget->connect(m_ConsoleCommandPersistentCheckboxWidget, &QCheckBox::checkStateChanged, this, &IEMidiDeviceInputPropertyEditor::OnConsoleCommandPersistentChanged);
+
     QHBoxLayout* const SubLayout1 = new QHBoxLayout(SubWidget1);
     SubLayout1->setContentsMargins(0, 0, 0, 0);
     SubLayout1->setSpacing(10);
     SubLayout1->addWidget(m_MidiMessageTypeDropdownWidget);
     SubLayout1->addWidget(m_MidiToggleCheckboxWidget);
+    SubLayout1->addWidget(m_MidiCoalesceCheckboxWidget);
     SubLayout1->addWidget(m_MidiActionTypeDropdownWidget);
     SubLayout1->addWidget(m_OpenFileBrowserWidget);
     SubLayout1->addWidget(m_ConsoleCommandWidget);
+    SubLayout1->addWidget(m_ConsoleCommandPersistentCheckboxWidget);
     SubLayout1->addStretch(1);
 
     QWidget* const SubWidget2 = new QWidget(this);
     SubWidget2->setSizePolicy(QSizePolicy::Fixed, QSizePolicy::Fixed);
 
-    m_MidiDeviceInputProperty.bIsRecording = false;
+    MidiDeviceInputProperty.SetRecording(false);
     m_RecordButtonWidget = new IERecordButton(SubWidget2);
     m_RecordButtonWidget->connect(m_RecordButtonWidget, &QPushButton::toggled, this, &IEMidiDeviceInputPropertyEditor::OnRecordButtonToggled);
 
-    m_MidiMessageEditorWidget = new IEMidiMessageEditor(m_MidiDeviceInputProperty.MidiMessage, SubWidget2);
-    m_MidiMessageEditorWidget->SetValues(m_MidiDeviceInputProperty.MidiMessage);
+    m_MidiMessageEditorWidget = new IEMidiMessageEditor(MidiDeviceInputProperty.MidiMessage, SubWidget2);
+    m_MidiMessageEditorWidget->SetValues(MidiDeviceInputProperty.MidiMessage);
     m_MidiMessageEditorWidget->HideByteWidget(2);
     m_MidiMessageEditorWidget->connect(m_MidiMessageEditorWidget, &IEMidiMessageEditor::OnMidiMessageCommitted, this, &IEMidiDeviceInputPropertyEditor::OnMidiMessageCommitted);
 
@@ -96,10 +111,14 @@ IEMidiDeviceInputPropertyEditor::IEMidiDeviceInputPropertyEditor(IEMidiDeviceInp
 
 void IEMidiDeviceInputPropertyEditor::OnMidiMessageTypeChanged(IEMidiMessageType OldMidiMessageType, IEMidiMessageType NewMidiMessageType) const
 {
-    m_MidiDeviceInputProperty.MidiMessageType = NewMidiMessageType;
+    if (IEMidiDeviceInputProperty* const MidiDeviceInputProperty = GetMidiDeviceInputProperty())
+    {
+        MidiDeviceInputProperty->MidiMessageType = NewMidiMessageType;
+        emit OnPropertyChanged();
+    }
     if (m_MidiToggleCheckboxWidget)
     {
-        if (NewMidiMessageType == IEMidiMessageType::NoteOnOff)
+        if (IsTriggerMidiMessageType(NewMidiMessageType))
         {
             m_MidiToggleCheckboxWidget->show();
         }
@@ -108,38 +127,66 @@ void IEMidiDeviceInputPropertyEditor::OnMidiMessageTypeChanged(IEMidiMessageType
             m_MidiToggleCheckboxWidget->hide();
         }
     }
+    if (m_MidiCoalesceCheckboxWidget)
+    {
+        if (IsContinuousMidiMessageType(NewMidiMessageType))
+        {
+            m_MidiCoalesceCheckboxWidget->show();
+        }
+        else
+        {
+            m_MidiCoalesceCheckboxWidget->hide();
+        }
+    }
 }
 
-void IEMidiDeviceInputPropertyEditor::paintEvent(QPaintEvent* event)
+void IEMidiDeviceInputPropertyEditor::OnMidiMessageLearned(const IEMidiDeviceProfile* MidiDeviceProfile, IEMidiSlotHandle MidiDeviceInputPropertyHandle) const
 {
-    if (event)
+    if (MidiDeviceProfile != &m_MidiDeviceProfile || !(MidiDeviceInputPropertyHandle == m_MidiDeviceInputPropertyHandle))
     {
-        if (m_RecordButtonWidget)
+        return;
+    }
+
+    if (IEMidiDeviceInputProperty* const MidiDeviceInputProperty = GetMidiDeviceInputProperty())
+    {
+        if (m_MidiMessageEditorWidget)
         {
-            m_RecordButtonWidget->setChecked(m_MidiDeviceInputProperty.bIsRecording);
+            m_MidiMessageEditorWidget->SetValues(MidiDeviceInputProperty->MidiMessage);
         }
 
-        // We need to poll for incoming midi messages when we are done recording
-        if (m_MidiMessageEditorWidget)
+        if (m_RecordButtonWidget)
         {
-            if (m_MidiMessageEditorWidget->GetValues() != m_MidiDeviceInputProperty.MidiMessage)
-            {
-                m_MidiMessageEditorWidget->SetValues(m_MidiDeviceInputProperty.MidiMessage);
-            }
+            m_RecordButtonWidget->setChecked(MidiDeviceInputProperty->IsRecording());
         }
+        emit OnPropertyChanged();
     }
-
-    QWidget::paintEvent(event);
 }
 
 void IEMidiDeviceInputPropertyEditor::OnMidiToggleChanged(Qt::CheckState CheckState) const
 {
-    m_MidiDeviceInputProperty.bIsMidiToggle = CheckState == Qt::CheckState::Checked;
+    if (IEMidiDeviceInputProperty* const MidiDeviceInputProperty = GetMidiDeviceInputProperty())
+    {
+        MidiDeviceInputProperty->bIsMidiToggle = CheckState == Qt::CheckState::Checked;
+        emit OnPropertyChanged();
+    }
+}
+
+void IEMidiDeviceInputPropertyEditor::OnMidiCoalesceChanged(Qt::CheckState CheckState) const
+{
+    if (IEMidiDeviceInputProperty* const MidiDeviceInputProperty = GetMidiDeviceInputProperty())
+    {
+        MidiDeviceInputProperty->bIsCoalesced = CheckState == Qt::CheckState::Checked;
+        emit OnPropertyChanged();
+    }
 }
 
 void IEMidiDeviceInputPropertyEditor::OnMidiActionTypeChanged(IEMidiActionType OldMidiActionType, IEMidiActionType NewMidiActionType) const
 {
-    m_MidiDeviceInputProperty.MidiActionType = NewMidiActionType;
+    if (IEMidiDeviceInputProperty* const MidiDeviceInputProperty = GetMidiDeviceInputProperty())
+    {
+        MidiDeviceInputProperty->MidiActionType = NewMidiActionType;
+        emit OnPropertyChanged();
+    }
 
     if (m_OpenFileBrowserWidget)
     {
@@ -149,6 +196,10 @@ void IEMidiDeviceInputPropertyEditor::OnMidiActionTypeChanged(IEMidiActionType O
     {
         m_ConsoleCommandWidget->hide();
     }
+    if (m_ConsoleCommandPersistentCheckboxWidget)
+    {
+        m_ConsoleCommandPersistentCheckboxWidget->hide();
+    }
 
     switch (NewMidiActionType)
     {
@@ -158,6 +209,10 @@ void IEMidiDeviceInputPropertyEditor::OnMidiActionTypeChanged(IEMidiActionType O
             {
                 m_ConsoleCommandWidget->show();
             }
+            if (m_ConsoleCommandPersistentCheckboxWidget && IEMidiCommandRunner::IsSupported())
+            {
+                m_ConsoleCommandPersistentCheckboxWidget->show();
+            }
             break;
         }
         case IEMidiActionType::OpenFile:
@@ -177,36 +232,62 @@ void IEMidiDeviceInputPropertyEditor::OnMidiActionTypeChanged(IEMidiActionType O
 
 void IEMidiDeviceInputPropertyEditor::OnOpenFilePathCommited() const
 {
-    if (m_OpenFileBrowserWidget)
+    IEMidiDeviceInputProperty* const MidiDeviceInputProperty = GetMidiDeviceInputProperty();
+    if (MidiDeviceInputProperty && m_OpenFileBrowserWidget)
     {
-        m_MidiDeviceInputProperty.OpenFilePath = m_OpenFileBrowserWidget->GetFilePath();
+        MidiDeviceInputProperty->OpenFilePath = m_OpenFileBrowserWidget->GetFilePath();
+        emit OnPropertyChanged();
     }
 }
 
 void IEMidiDeviceInputPropertyEditor::OnConsoleCommandTextCommited() const
 {
-    if (m_ConsoleCommandWidget)
+    IEMidiDeviceInputProperty* const MidiDeviceInputProperty = GetMidiDeviceInputProperty();
+    if (MidiDeviceInputProperty && m_ConsoleCommandWidget)
     {
-        m_MidiDeviceInputProperty.ConsoleCommand = m_ConsoleCommandWidget->text().toStdString();
+        MidiDeviceInputProperty->ConsoleCommand = m_ConsoleCommandWidget->text().toStdString();
+        emit OnPropertyChanged();
+    }
+}
+
+void IEMidiDeviceInputPropertyEditor::OnConsoleCommandPersistentChanged(Qt::CheckState CheckState) const
+{
+    if (IEMidiDeviceInputProperty* const MidiDeviceInputProperty = GetMidiDeviceInputProperty())
+    {
+        MidiDeviceInputProperty->bIsConsoleCommandPersistent = CheckState == Qt::CheckState::Checked;
+        emit OnPropertyChanged();
     }
 }
 
 void IEMidiDeviceInputPropertyEditor::OnRecordButtonToggled(bool bToggled) const
 {
-    m_MidiDeviceInputProperty.bIsRecording = bToggled;
-    emit OnRecording();
+    if (IEMidiDeviceInputProperty* const MidiDeviceInputProperty = GetMidiDeviceInputProperty())
+    {
+        MidiDeviceInputProperty->SetRecording(bToggled);
+    }
 }
 
 void IEMidiDeviceInputPropertyEditor::OnMidiMessageCommitted() const
 {
-    if (m_MidiMessageEditorWidget)
+    IEMidiDeviceInputProperty* const MidiDeviceInputProperty = GetMidiDeviceInputProperty();
+    if (MidiDeviceInputProperty && m_MidiMessageEditorWidget)
     {
-        m_MidiDeviceInputProperty.MidiMessage = m_MidiMessageEditorWidget->GetValues();
+        MidiDeviceInputProperty->MidiMessage = m_MidiMessageEditorWidget->GetValues();
+        emit OnPropertyChanged();
     }
 }
 
 void IEMidiDeviceInputPropertyEditor::OnDeleteButtonPressed()
 {
-    m_MidiDeviceInputProperty.Delete();
+    if (IEMidiDeviceInputProperty* const MidiDeviceInputProperty = GetMidiDeviceInputProperty())
+    {
+        MidiDeviceInputProperty->Delete();
+        emit OnPropertyChanged();
+    }
     deleteLater();
 }
+
+IEMidiDeviceInputProperty* IEMidiDeviceInputPropertyEditor::GetMidiDeviceInputProperty() const
+{
+    return m_MidiDeviceProfile.InputProperties.Find(m_MidiDeviceInputPropertyHandle);
+}
@@ -27,23 +27,30 @@ public:
     explicit IEMidiDeviceInputPropertyEditor(IEMidiDeviceInputProperty& MidiDeviceInputProperty, QWidget* Parent = nullptr);
 
 Q_SIGNALS:
-    void OnRecording() const;
+    void OnPropertyChanged() const;
 
-protected:
-    void paintEvent(QPaintEvent* event) override;
+public Q_SLOTS:
+    void OnMidiMessageLearned(const IEMidiDeviceProfile* MidiDeviceProfile, IEMidiSlotHandle MidiDeviceInputPropertyHandle) const;
 
 private Q_SLOTS:
     void OnMidiMessageTypeChanged(IEMidiMessageType OldMidiMessageType, IEMidiMessageType NewMidiMessageType) const;
     void OnMidiToggleChanged(Qt::CheckState CheckState) const;
+    void OnMidiCoalesceChanged(Qt::CheckState CheckState) const;
     void OnMidiActionTypeChanged(IEMidiActionType OldMidiActionType, IEMidiActionType NewMidiActionType) const;
     void OnOpenFilePathCommited() const;
     void OnConsoleCommandTextCommited() const;
+    void OnConsoleCommandPersistentChanged(Qt::CheckState CheckState) const;
     void OnRecordButtonToggled(bool bToggled) const;
     void OnMidiMessageCommitted() const;
     void OnDeleteButtonPressed();
 
 private:
-    IEMidiDeviceInputProperty& m_MidiDeviceInputProperty;
+    // Null once the property is deleted
+    IEMidiDeviceInputProperty* GetMidiDeviceInputProperty() const;
+
+private:
+    IEMidiDeviceProfile& m_MidiDeviceProfile;
+    const IEMidiSlotHandle m_MidiDeviceInputPropertyHandle;
 
 private:
     IEFileBrowserWidget* m_OpenFileBrowserWidget;
@@ -51,6 +58,8 @@ private:
     IEMidiMessageEditor* m_MidiMessageEditorWidget;
     IEMidiMessageTypeDropdown* m_MidiMessageTypeDropdownWidget;
     QCheckBox* m_MidiToggleCheckboxWidget;
+    QCheckBox* m_MidiCoalesceCheckboxWidget;
     QLineEdit* m_ConsoleCommandWidget;
+    QCheckBox* m_ConsoleCommandPersistentCheckboxWidget;
     QPushButton* m_RecordButtonWidget;
 };
\ No newline at end of file
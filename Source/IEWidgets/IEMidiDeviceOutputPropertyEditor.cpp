@@ -12,14 +12,15 @@
 
 IEMidiDeviceOutputPropertyEditor::IEMidiDeviceOutputPropertyEditor(IEMidiDeviceOutputProperty& MidiDeviceOutputProperty, QWidget* Parent) :
     QWidget(Parent),
-    m_MidiDeviceOutputProperty(MidiDeviceOutputProperty)
+    m_MidiDeviceProfile(MidiDeviceOutputProperty.MidiDeviceProfile),
+    m_MidiDeviceOutputPropertyHandle(MidiDeviceOutputProperty.GetHandle())
 {
     m_SendButtonWidget = new QPushButton(this);
     m_SendButtonWidget->setText("Send");
     m_SendButtonWidget->connect(m_SendButtonWidget, &QPushButton::pressed, this, &IEMidiDeviceOutputPropertyEditor::OnSendButtonPressed);
     
-    m_MidiMessageEditorWidget = new IEMidiMessageEditor(m_MidiDeviceOutputProperty.MidiMessage, this);
-    m_MidiMessageEditorWidget->SetValues(m_MidiDeviceOutputProperty.MidiMessage);
+    m_MidiMessageEditorWidget = new IEMidiMessageEditor(MidiDeviceOutputProperty.MidiMessage, this);
+    m_MidiMessageEditorWidget->SetValues(MidiDeviceOutputProperty.MidiMessage);
     m_MidiMessageEditorWidget->connect(m_MidiMessageEditorWidget, &IEMidiMessageEditor::OnMidiMessageCommitted, this, &IEMidiDeviceOutputPropertyEditor::OnMidiMessageCommitted);
     
     IEDeletePropertyButton* const DeleteButton = new IEDeletePropertyButton(this);
@@ -37,19 +38,31 @@ IEMidiDeviceOutputPropertyEditor::IEMidiDeviceOutputPropertyEditor(IEMidiDeviceO
 
 void IEMidiDeviceOutputPropertyEditor::OnMidiMessageCommitted() const
 {
-    if (m_MidiMessageEditorWidget)
+    IEMidiDeviceOutputProperty* const MidiDeviceOutputProperty = GetMidiDeviceOutputProperty();
+    if (MidiDeviceOutputProperty && m_MidiMessageEditorWidget)
     {
-        m_MidiDeviceOutputProperty.MidiMessage = m_MidiMessageEditorWidget->GetValues();
+        MidiDeviceOutputProperty->MidiMessage = m_MidiMessageEditorWidget->GetValues();
     }
 }
 
 void IEMidiDeviceOutputPropertyEditor::OnSendButtonPressed()const
 {
-    emit OnSendMidiButtonPressed(m_MidiDeviceOutputProperty.MidiMessage);
+    if (const IEMidiDeviceOutputProperty* const MidiDeviceOutputProperty = GetMidiDeviceOutputProperty())
+    {
+        emit OnSendMidiButtonPressed(MidiDeviceOutputProperty->MidiMessage);
+    }
 }
 
 void IEMidiDeviceOutputPropertyEditor::OnDeleteButtonPressed()
 {
-    m_MidiDeviceOutputProperty.Delete();
+    if (IEMidiDeviceOutputProperty* const MidiDeviceOutputProperty = GetMidiDeviceOutputProperty())
+    {
+        MidiDeviceOutputProperty->Delete();
+    }
     deleteLater();
+}
+
+IEMidiDeviceOutputProperty* IEMidiDeviceOutputPropertyEditor::GetMidiDeviceOutputProperty() const
+{
+    return m_MidiDeviceProfile.OutputProperties.Find(m_MidiDeviceOutputPropertyHandle);
 }
\ No newline at end of file
@@ -4,7 +4,6 @@
 
 #pragma once
 
-#include <array>
 #include <vector>
 
 #include "qwidget.h"
@@ -22,7 +21,7 @@ public:
     explicit IEMidiDeviceOutputPropertyEditor(IEMidiDeviceOutputProperty& MidiDeviceOutputProperty, QWidget* Parent = nullptr);
 
 Q_SIGNALS:
-    void OnSendMidiButtonPressed(const std::array<uint8_t, MIDI_MESSAGE_BYTE_COUNT>& MidiMessage) const;
+    void OnSendMidiButtonPressed(const IEMidiMessage& MidiMessage) const;
 
 private Q_SLOTS:
     void OnSendButtonPressed() const;
@@ -30,7 +29,12 @@ private Q_SLOTS:
     void OnDeleteButtonPressed();
 
 private:
-    IEMidiDeviceOutputProperty& m_MidiDeviceOutputProperty;
+    // Null once the property is deleted
+    IEMidiDeviceOutputProperty* GetMidiDeviceOutputProperty() const;
+
+private:
+    IEMidiDeviceProfile& m_MidiDeviceProfile;
+    const IEMidiSlotHandle m_MidiDeviceOutputPropertyHandle;
 
 private:
     IEMidiMessageEditor* m_MidiMessageEditorWidget;
@@ -0,0 +1,123 @@
+// SPDX-License-Identifier: GPL-2.0-only
+// Copyright © Interactive Echoes. All rights reserved.
+// Author: mozahzah
+
+#include "IEMidiLogModel.h"
+
+#include <algorithm>
+
+#include "qfont.h"
+
+IEMidiLogModel::IEMidiLogModel(size_t Capacity, QObject* Parent) :
+    QAbstractTableModel(Parent),
+    m_LogEntries(std::max<size_t>(Capacity, 1))
+{}
+
+int IEMidiLogModel::rowCount(const QModelIndex& Parent) const
+{
+    return Parent.isValid() ? 0 : static_cast<int>(m_Count);
+}
+
+int IEMidiLogModel::columnCount(const QModelIndex& Parent) const
+{
+    return Parent.isValid() ? 0 : COLUMN_COUNT;
+}
+
+QVariant IEMidiLogModel::data(const QModelIndex& Index, int Role) const
+{
+    if (Index.isValid() && Index.row() < static_cast<int>(m_Count))
+    {
+        if (Role == Qt::DisplayRole)
+        {
+            return GetMidiByteText(GetLogEntry(Index.row()), static_cast<size_t>(Index.column()));
+        }
+        else if (Role == Qt::TextAlignmentRole)
+        {
+            return static_cast<int>(Qt::AlignCenter);
+        }
+    }
+    return QVariant();
+}
+
+QVariant IEMidiLogModel::headerData(int Section, Qt::Orientation Orientation, int Role) const
+{
+    if (Orientation == Qt::Horizontal)
+    {
+        if (Role == Qt::DisplayRole)
+        {
+            switch (Section)
+            {
+                case 0: return QString("Status");
+                case 1: return QString("Data 1");
+                case 2: return QString("Data 2");
+                default: break;
+            }
+        }
+        else if (Role == Qt::FontRole)
+        {
+            QFont Font;
+            Font.setBold(true);
+            return Font;
+        }
+    }
+    return QVariant();
+}
+
+void IEMidiLogModel::Append(std::span<const IEMidiLogEntry> LogEntries)
+{
+    const size_t Capacity = m_LogEntries.size();
+    if (LogEntries.size() > Capacity)
+    {
+        // Older entries of the batch would be evicted by the newer ones right away
+        LogEntries = LogEntries.last(Capacity);
+    }
+    if (LogEntries.empty())
+    {
+        return;
+    }
+
+    if (m_Count + LogEntries.size() > Capacity)
+    {
+        const size_t EvictedCount = m_Count + LogEntries.size() - Capacity;
+        beginRemoveRows(QModelIndex(), static_cast<int>(m_Count - EvictedCount), static_cast<int>(m_Count - 1));
+        m_Count -= EvictedCount;
+        endRemoveRows();
+    }
+
+    // The evicted slots are the ones overwritten here
+    beginInsertRows(QModelIndex(), 0, static_cast<int>(LogEntries.size() - 1));
+    for (const IEMidiLogEntry& LogEntry : LogEntries)
+    {
+        m_LogEntries[m_NextIndex] = LogEntry;
+        m_NextIndex = (m_NextIndex + 1) % Capacity;
+    }
+    m_Count += LogEntries.size();
+    endInsertRows();
+}
+
+void IEMidiLogModel::Clear()
+{
+    beginResetModel();
+    m_NextIndex = 0;
+    m_Count = 0;
+    endResetModel();
+}
+
+const IEMidiLogEntry& IEMidiLogModel::GetLogEntry(int Row) const
+{
+    const size_t Capacity = m_LogEntries.size();
+    return m_LogEntries[(m_NextIndex + Capacity - 1 - static_cast<size_t>(Row)) % Capacity];
+}
+
+QString IEMidiLogModel::GetMidiByteText(const IEMidiLogEntry& LogEntry, size_t Index)
+{
+    if (LogEntry.IsSysEx() && Index == MIDI_MESSAGE_BYTE_COUNT - 1)
+    {
+        return QString("+%1 bytes").arg(LogEntry.Size - Index);
+    }
+    else if (Index < LogEntry.Size)
+    {
+        return QString::number(LogEntry.Bytes[Index]);
+    }
+    return QString("-");
+}
\ No newline at end of file
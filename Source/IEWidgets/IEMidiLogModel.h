@@ -0,0 +1,47 @@
+// SPDX-License-Identifier: GPL-2.0-only
+// Copyright © Interactive Echoes. All rights reserved.
+// Author: mozahzah
+
+#pragma once
+
+#include <span>
+#include <vector>
+
+#include "qabstractitemmodel.h"
+
+#include "IEMidiTypes.h"
+
+static constexpr size_t DEFAULT_MIDI_LOG_HISTORY_CAPACITY = 100000;
+
+// Logged messages kept in a ring buffer allocated up front, newest first. Cells are formatted when
+// the view asks for them, so only the visible rows ever cost anything.
+class IEMidiLogModel : public QAbstractTableModel
+{
+    Q_OBJECT
+
+public:
+    explicit IEMidiLogModel(size_t Capacity = DEFAULT_MIDI_LOG_HISTORY_CAPACITY, QObject* Parent = nullptr);
+
+public:
+    int rowCount(const QModelIndex& Parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex& Parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex& Index, int Role = Qt::DisplayRole) const override;
+    QVariant headerData(int Section, Qt::Orientation Orientation, int Role = Qt::DisplayRole) const override;
+
+public:
+    // One row insertion per call, and one removal of the oldest rows once the history is full
+    void Append(std::span<const IEMidiLogEntry> LogEntries);
+    void Clear();
+
+private:
+    const IEMidiLogEntry& GetLogEntry(int Row) const;
+    static QString GetMidiByteText(const IEMidiLogEntry& LogEntry, size_t Index);
+
+private:
+    static constexpr int COLUMN_COUNT = 3;
+
+private:
+    std::vector<IEMidiLogEntry> m_LogEntries;
+    size_t m_NextIndex = 0;
+    size_t m_Count = 0;
+};
\ No newline at end of file
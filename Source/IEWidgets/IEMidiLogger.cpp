@@ -9,7 +9,7 @@
 #include "qlabel.h"
 #include "qtimer.h"
 
-IEMidiLogger::IEMidiLogger(IESPSCQueue<std::array<uint8_t, MIDI_MESSAGE_BYTE_COUNT>>& IncomingMidiMessages, QWidget* Parent) :
+IEMidiLogger::IEMidiLogger(IESPSCQueue<IEMidiLogEntry>& IncomingMidiMessages, QWidget* Parent) :
     QFrame(Parent),
     m_MidiLogMessagesBuffer(IncomingMidiMessages)
 {
@@ -25,82 +25,71 @@ IEMidiLogger::IEMidiLogger(IESPSCQueue<std::array<uint8_t, MIDI_MESSAGE_BYTE_COU
         }
     )");
 
-    m_MidiLoggerTableWidget = new QTableWidget(IncomingMidiMessages.GetCapacity(), 3, this);
-    m_MidiLoggerTableWidget->setSizePolicy(QSizePolicy::Minimum, QSizePolicy::Minimum);
-    m_MidiLoggerTableWidget->setEditTriggers(QAbstractItemView::NoEditTriggers);
-    m_MidiLoggerTableWidget->setSelectionMode(QAbstractItemView::NoSelection);
-    m_MidiLoggerTableWidget->setFocusPolicy(Qt::NoFocus);
-    m_MidiLoggerTableWidget->setMouseTracking(false);
-    m_MidiLoggerTableWidget->setAutoFillBackground(false);
-    m_MidiLoggerTableWidget->setShowGrid(false);
-    m_MidiLoggerTableWidget->setHorizontalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
-    m_MidiLoggerTableWidget->setVerticalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
-    m_MidiLoggerTableWidget->setStyleSheet(R"(
-        QTableWidget 
+    m_PendingLogEntries.reserve(IncomingMidiMessages.GetCapacity());
+    m_MidiLogModel = new IEMidiLogModel(DEFAULT_MIDI_LOG_HISTORY_CAPACITY, this);
+
+    m_MidiLoggerTableView = new QTableView(this);
+    m_MidiLoggerTableView->setModel(m_MidiLogModel);
+    m_MidiLoggerTableView->setSizePolicy(QSizePolicy::Minimum, QSizePolicy::Minimum);
+    m_MidiLoggerTableView->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    m_MidiLoggerTableView->setSelectionMode(QAbstractItemView::NoSelection);
+    m_MidiLoggerTableView->setFocusPolicy(Qt::NoFocus);
+    m_MidiLoggerTableView->setMouseTracking(false);
+    m_MidiLoggerTableView->setAutoFillBackground(false);
+    m_MidiLoggerTableView->setShowGrid(false);
+    m_MidiLoggerTableView->setWordWrap(false);
+    m_MidiLoggerTableView->setHorizontalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
+    m_MidiLoggerTableView->setVerticalScrollBarPolicy(Qt::ScrollBarAsNeeded);
+    m_MidiLoggerTableView->setVerticalScrollMode(QAbstractItemView::ScrollPerPixel);
+    m_MidiLoggerTableView->setStyleSheet(R"(
+        QTableView 
+        {
+            background: transparent;
+            border: none;
+        }
+        QHeaderView::section
         {
             background: transparent;
             border: none;
         }
     )");
 
-    if (QHeaderView* const HHeader = m_MidiLoggerTableWidget->horizontalHeader())
+    if (QHeaderView* const HHeader = m_MidiLoggerTableView->horizontalHeader())
     {
-        HHeader->setVisible(false);
         HHeader->setSectionResizeMode(QHeaderView::Stretch);
+        HHeader->setHighlightSections(false);
     }
 
-    if (QHeaderView* const VHeader = m_MidiLoggerTableWidget->verticalHeader())
+    if (QHeaderView* const VHeader = m_MidiLoggerTableView->verticalHeader())
     {
+        // Fixed rows let the view map scroll positions to rows without measuring any of them
         VHeader->setVisible(false);
-        VHeader->setSectionResizeMode(QHeaderView::Stretch);
+        VHeader->setSectionResizeMode(QHeaderView::Fixed);
+        VHeader->setDefaultSectionSize(m_MidiLoggerTableView->fontMetrics().height() + 8);
     }
 
-    m_MidiLoggerTableWidget->setItem(0, 0, CreateCenteredTableWidgetItem("Status", true));
-    m_MidiLoggerTableWidget->setItem(0, 1, CreateCenteredTableWidgetItem("Data 1", true));
-    m_MidiLoggerTableWidget->setItem(0, 2, CreateCenteredTableWidgetItem("Data 2", true));
-
     QTimer* const UpdateTimer = new QTimer(this);
-    connect(UpdateTimer, &QTimer::timeout, this, &IEMidiLogger::FlushMidiMessagesToTable);
+    connect(UpdateTimer, &QTimer::timeout, this, &IEMidiLogger::FlushMidiMessagesToModel);
     UpdateTimer->start(25);
     
     QVBoxLayout* const Layout = new QVBoxLayout(this);
     Layout->setContentsMargins(20, 10, 20, 20);
     Layout->addWidget(MidiLoggerLabel);
     Layout->addSpacing(30);
-    Layout->addWidget(m_MidiLoggerTableWidget, 1);
+    Layout->addWidget(m_MidiLoggerTableView, 1);
 }
 
-void IEMidiLogger::FlushMidiMessagesToTable() const
+void IEMidiLogger::FlushMidiMessagesToModel()
 {
-    int Row = 1;
-    while (!m_MidiLogMessagesBuffer.IsEmpty())
+    m_PendingLogEntries.clear();
+    IEMidiLogEntry LogEntry;
+    while (m_PendingLogEntries.size() < m_PendingLogEntries.capacity() && m_MidiLogMessagesBuffer.Pop(LogEntry))
     {
-        std::array<uint8_t, MIDI_MESSAGE_BYTE_COUNT> MidiMessage;
-        if (m_MidiLogMessagesBuffer.Pop(MidiMessage))
-        {
-            m_MidiLoggerTableWidget->insertRow(Row);
-            m_MidiLoggerTableWidget->setItem(Row, 0, CreateCenteredTableWidgetItem(std::to_string(MidiMessage[0]).c_str(), false));
-            m_MidiLoggerTableWidget->setItem(Row, 1, CreateCenteredTableWidgetItem(std::to_string(MidiMessage[1]).c_str(), false));
-            m_MidiLoggerTableWidget->setItem(Row, 2, CreateCenteredTableWidgetItem(std::to_string(MidiMessage[2]).c_str(), false));
-            Row++;
-
-            const int RowCount = m_MidiLoggerTableWidget->rowCount();
-            if (RowCount > m_MidiLogMessagesBuffer.GetCapacity())
-            {
-                m_MidiLoggerTableWidget->removeRow(RowCount - 1);
-            }
-        }
+        m_PendingLogEntries.push_back(LogEntry);
     }
-}
 
-QTableWidgetItem* IEMidiLogger::CreateCenteredTableWidgetItem(const QString& Text, bool bBold) const
-{
-    QTableWidgetItem* const TableWidgetItem = new QTableWidgetItem(Text);
-    TableWidgetItem->setTextAlignment(Qt::AlignCenter);
-    QFont Font = TableWidgetItem->font();
-    bBold ? Font.setBold(true) : Font.setWeight(QFont::Weight::Normal);
-    TableWidgetItem->setFont(Font);
-    TableWidgetItem->setBackground(Qt::NoBrush);
-    TableWidgetItem->setFlags(TableWidgetItem->flags() & ~Qt::ItemIsSelectable & ~Qt::ItemIsEditable);
-    return TableWidgetItem;
-};
+    if (!m_PendingLogEntries.empty() && m_MidiLogModel)
+    {
+        m_MidiLogModel->Append(m_PendingLogEntries);
+    }
+}
\ No newline at end of file
@@ -4,29 +4,32 @@
 
 #pragma once
 
-#include <array>
+#include <vector>
 
 #include "qframe.h"
-#include "qtablewidget.h"
+#include "qtableview.h"
 #include "qwidget.h"
 
 #include "IEConcurrency.h"
 #include "IEMidiTypes.h"
 
+#include "IEMidiLogModel.h"
+
 class IEMidiLogger : public QFrame
 {
     Q_OBJECT
 
 public:
-    explicit IEMidiLogger(IESPSCQueue<std::array<uint8_t, MIDI_MESSAGE_BYTE_COUNT>>& IncomingMidiMessages, QWidget* Parent = nullptr);
+    explicit IEMidiLogger(IESPSCQueue<IEMidiLogEntry>& IncomingMidiMessages, QWidget* Parent = nullptr);
 
 private:
-    QTableWidgetItem* CreateCenteredTableWidgetItem(const QString& Text, bool bBold = false) const;
-    void FlushMidiMessagesToTable() const;
+    void FlushMidiMessagesToModel();
 
 private:
-    IESPSCQueue<std::array<uint8_t, MIDI_MESSAGE_BYTE_COUNT>>& m_MidiLogMessagesBuffer;
+    IESPSCQueue<IEMidiLogEntry>& m_MidiLogMessagesBuffer;
+    std::vector<IEMidiLogEntry> m_PendingLogEntries;
 
 private:
-    QTableWidget* m_MidiLoggerTableWidget;
+    IEMidiLogModel* m_MidiLogModel;
+    QTableView* m_MidiLoggerTableView;
 };
\ No newline at end of file
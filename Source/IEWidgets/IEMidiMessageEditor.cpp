@@ -11,7 +11,7 @@
 
 #include "IELog.h"
 
-IEMidiMessageEditor::IEMidiMessageEditor(const std::array<uint8_t, MIDI_MESSAGE_BYTE_COUNT>& MidiMessage, QWidget* Parent) :
+IEMidiMessageEditor::IEMidiMessageEditor(const IEMidiMessage& MidiMessage, QWidget* Parent) :
     QWidget(Parent)
 {
     QHBoxLayout* const Layout = new QHBoxLayout(this);
@@ -37,12 +37,12 @@ IEMidiMessageEditor::IEMidiMessageEditor(const std::array<uint8_t, MIDI_MESSAGE_
     }
 }
 
-const std::array<uint8_t, MIDI_MESSAGE_BYTE_COUNT>& IEMidiMessageEditor::GetValues() const
+const IEMidiMessage& IEMidiMessageEditor::GetValues() const
 {
     return m_MidiMessage;
 }
 
-void IEMidiMessageEditor::SetValues(const std::array<uint8_t, MIDI_MESSAGE_BYTE_COUNT>& MidiMessage)
+void IEMidiMessageEditor::SetValues(const IEMidiMessage& MidiMessage)
 {
     m_MidiMessage = MidiMessage;
     for (int i = 0; i < m_SpinBoxWidgets.size(); i++)
@@ -71,8 +71,18 @@ void IEMidiMessageEditor::HideByteWidget(size_t Index) const
 
 void IEMidiMessageEditor::OnMidiByteCommitted()
 {
-    m_MidiMessage = {   static_cast<uint8_t>(m_SpinBoxWidgets[0]->value()),
-                        static_cast<uint8_t>(m_SpinBoxWidgets[1]->value()),
-                        static_cast<uint8_t>(m_SpinBoxWidgets[2]->value()) };
+    const uint8_t Status = static_cast<uint8_t>(m_SpinBoxWidgets[0]->value());
+    const size_t ExpectedSize = IEMidiMessage::GetExpectedSize(Status);
+
+    // SysEx payloads can't be edited byte by byte here, keep the one we have
+    if (ExpectedSize != 0)
+    {
+        std::array<uint8_t, MIDI_MESSAGE_BYTE_COUNT> MidiBytes;
+        for (int i = 0; i < MIDI_MESSAGE_BYTE_COUNT; i++)
+        {
+            MidiBytes[i] = static_cast<uint8_t>(m_SpinBoxWidgets[i]->value());
+        }
+        m_MidiMessage = IEMidiMessage(MidiBytes.data(), ExpectedSize);
+    }
     emit OnMidiMessageCommitted();
 }
\ No newline at end of file
@@ -19,11 +19,11 @@ class IEMidiMessageEditor : public QWidget
     Q_OBJECT
 
 public:
-    explicit IEMidiMessageEditor(const std::array<uint8_t, MIDI_MESSAGE_BYTE_COUNT>& MidiMessage, QWidget* Parent = nullptr);
+    explicit IEMidiMessageEditor(const IEMidiMessage& MidiMessage, QWidget* Parent = nullptr);
 
 public:
-    const std::array<uint8_t, MIDI_MESSAGE_BYTE_COUNT>& GetValues() const;
-    void SetValues(const std::array<uint8_t, MIDI_MESSAGE_BYTE_COUNT>& MidiMessage);
+    const IEMidiMessage& GetValues() const;
+    void SetValues(const IEMidiMessage& MidiMessage);
     void ShowByteWidget(size_t Index) const;
     void HideByteWidget(size_t Index) const;
     
@@ -35,5 +35,5 @@ private Q_SLOTS:
 
 private:
     std::array<QSpinBox*, MIDI_MESSAGE_BYTE_COUNT> m_SpinBoxWidgets;
-    std::array<uint8_t, MIDI_MESSAGE_BYTE_COUNT> m_MidiMessage;
+    IEMidiMessage m_MidiMessage;
 };
\ No newline at end of file
@@ -20,6 +20,9 @@ IEMidiMessageTypeDropdown::IEMidiMessageTypeDropdown(QWidget* Parent) :
     addItem("-Message Type-");
     addItem("NoteOnOff");
     addItem("ControlChange");
+    addItem("ProgramChange");
+    addItem("ChannelAftertouch");
+    addItem("PolyAftertouch");
 }
 
 void IEMidiMessageTypeDropdown::SetValue(IEMidiMessageType MidiMessageType)
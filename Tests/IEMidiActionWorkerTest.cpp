@@ -0,0 +1,141 @@
+// SPDX-License-Identifier: GPL-2.0-only
+// Copyright © Interactive Echoes. All rights reserved.
+// Author: mozahzah
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#include "IEMidiActionWorker.h"
+
+// Floods every queue of the action worker from its own producer thread, as many devices sending CC
+// streams at once. Each queue must be processed in order, and once the producers stop and the
+// queues are drained the worker must go idle instead of waking for wakes it already served. A flush
+// handler holding values back must get its final call before the worker exits, every time it stops.
+
+static constexpr std::chrono::milliseconds IDLE_TIMEOUT = std::chrono::milliseconds(10000);
+static constexpr std::chrono::milliseconds IDLE_SAMPLE_INTERVAL = std::chrono::milliseconds(200);
+
+static std::atomic<uint64_t> FailureCount = 0;
+
+static void Check(bool bCondition, const char* Description)
+{
+    if (!bCondition)
+    {
+        std::printf("FAILED: %s\n", Description);
+        FailureCount.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+int main(int Argc, char* Argv[])
+{
+    const std::chrono::milliseconds Duration = std::chrono::milliseconds(Argc > 1 ? std::atoi(Argv[1]) : 2000);
+
+    IEMidiActionWorker ActionWorker;
+    std::array<double, MAX_EVENT_QUEUE_COUNT> LastSequences = {};
+    std::atomic<uint64_t> OutOfOrderCount = 0;
+    ActionWorker.Start([&](const IEMidiInputEvent& MidiInputEvent)
+        {
+            double& LastSequence = LastSequences[MidiInputEvent.QueueIndex];
+            if (MidiInputEvent.TimeStamp <= LastSequence)
+            {
+                OutOfOrderCount.fetch_add(1, std::memory_order_relaxed);
+            }
+            LastSequence = MidiInputEvent.TimeStamp;
+        });
+
+    std::vector<int32_t> QueueIndices;
+    for (size_t QueueCount = 0; QueueCount < MAX_EVENT_QUEUE_COUNT; QueueCount++)
+    {
+        QueueIndices.push_back(ActionWorker.OpenQueue());
+        Check(QueueIndices.back() >= 0, "Every queue opens");
+    }
+
+    std::atomic<bool> bIsRunning = true;
+    std::vector<std::thread> Threads;
+    for (const int32_t QueueIndex : QueueIndices)
+    {
+        Threads.emplace_back([&, QueueIndex]()
+            {
+                IEMidiInputEvent MidiInputEvent;
+                MidiInputEvent.MidiMessage = IEMidiMessage({0xB0, 7, 64});
+                MidiInputEvent.QueueIndex = static_cast<uint32_t>(QueueIndex);
+                for (uint64_t Sequence = 1; bIsRunning.load(std::memory_order_relaxed); Sequence++)
+                {
+                    // Dropped events leave a gap in the sequence, never a step back
+                    MidiInputEvent.TimeStamp = static_cast<double>(Sequence);
+                    ActionWorker.Enqueue(static_cast<uint32_t>(QueueIndex), MidiInputEvent);
+                }
+            });
+    }
+
+    std::this_thread::sleep_for(Duration);
+    bIsRunning.store(false, std::memory_order_relaxed);
+    for (std::thread& Thread : Threads)
+    {
+        Thread.join();
+    }
+
+    const std::chrono::steady_clock::time_point StartTime = std::chrono::steady_clock::now();
+    IEMidiActionWorkerStats ActionWorkerStats = ActionWorker.GetStats();
+    while (ActionWorkerStats.ProcessedCount < ActionWorkerStats.EnqueuedCount && std::chrono::steady_clock::now() - StartTime < IDLE_TIMEOUT)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        ActionWorkerStats = ActionWorker.GetStats();
+    }
+    Check(ActionWorkerStats.ProcessedCount == ActionWorkerStats.EnqueuedCount, "Every enqueued event is processed");
+
+    // Let a wake sent with the last events land, the worker may wake once more but must then stay asleep
+    std::this_thread::sleep_for(IDLE_SAMPLE_INTERVAL);
+    const uint64_t IdleWakeCount = ActionWorker.GetStats().WakeCount;
+    std::this_thread::sleep_for(IDLE_SAMPLE_INTERVAL);
+    const IEMidiActionWorkerStats IdleActionWorkerStats = ActionWorker.GetStats();
+
+    std::printf("Enqueued %llu, processed %llu, dropped %llu, peak queue depth %llu, %llu wakes\n",
+        static_cast<unsigned long long>(IdleActionWorkerStats.EnqueuedCount), static_cast<unsigned long long>(IdleActionWorkerStats.ProcessedCount),
+        static_cast<unsigned long long>(IdleActionWorkerStats.DroppedCount), static_cast<unsigned long long>(IdleActionWorkerStats.PeakQueueDepth),
+        static_cast<unsigned long long>(IdleActionWorkerStats.WakeCount));
+
+    Check(IdleActionWorkerStats.WakeCount == IdleWakeCount, "The worker goes idle once the queues are drained");
+    Check(IdleActionWorkerStats.WakeCount < IdleActionWorkerStats.ProcessedCount, "The worker wakes less often than once per event");
+    Check(OutOfOrderCount.load() == 0, "Every queue is processed in order");
+
+    // A wake after the idle period is still served
+    IEMidiInputEvent MidiInputEvent;
+    MidiInputEvent.MidiMessage = IEMidiMessage({0xB0, 7, 64});
+    MidiInputEvent.QueueIndex = static_cast<uint32_t>(QueueIndices.front());
+    MidiInputEvent.TimeStamp = 1.0e18;
+    Check(ActionWorker.Enqueue(MidiInputEvent.QueueIndex, MidiInputEvent), "An event is accepted after the flood");
+    std::this_thread::sleep_for(IDLE_SAMPLE_INTERVAL);
+    Check(ActionWorker.GetStats().ProcessedCount == IdleActionWorkerStats.ProcessedCount + 1, "An event after the flood wakes the worker");
+
+    for (const int32_t QueueIndex : QueueIndices)
+    {
+        ActionWorker.CloseQueue(QueueIndex);
+    }
+    ActionWorker.Stop();
+
+    // Restarting is how the processor brings the worker back after its last device was deactivated
+    for (uint32_t Run = 0; Run < 2; Run++)
+    {
+        std::atomic<uint32_t> FlushCount = 0;
+        std::atomic<uint32_t> FinalFlushCount = 0;
+        ActionWorker.Start([](const IEMidiInputEvent&) {}, [&](bool bIsFinal)
+            {
+                FlushCount.fetch_add(1, std::memory_order_relaxed);
+                FinalFlushCount.fetch_add(bIsFinal, std::memory_order_relaxed);
+                return std::chrono::steady_clock::now() + std::chrono::milliseconds(1);
+            });
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        Check(FinalFlushCount.load() == 0, "The flush handler is not final while the worker runs");
+        ActionWorker.Stop();
+        Check(FlushCount.load() > 1, "The flush handler runs while the worker waits");
+        Check(FinalFlushCount.load() == 1, "The flush handler runs final once as the worker stops");
+    }
+    return FailureCount.load() == 0 ? 0 : 1;
+}
\ No newline at end of file
@@ -0,0 +1,260 @@
+// SPDX-License-Identifier: GPL-2.0-only
+// Copyright © Interactive Echoes. All rights reserved.
+// Author: mozahzah
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <thread>
+#include <vector>
+
+#include "IEMidiCaptureWriter.h"
+
+// Floods the capture writer from one thread per device at a fixed rate, with a SysEx every so often
+// and every few of those larger than a SysEx pool slot. Nothing may be dropped, every truncated SysEx
+// is counted, and the rotated files must parse back to exactly the messages that were written. Queued
+// SysEx is copied into the capture's own bytes, so a burst of it must leave the SysEx pool free.
+
+static constexpr uint32_t DEVICE_COUNT = 2;
+static constexpr uint32_t MESSAGES_PER_SECOND_PER_DEVICE = 40000;
+static constexpr uint32_t SYSEX_INTERVAL = 2000;
+static constexpr uint32_t TRUNCATED_SYSEX_INTERVAL = 4;
+static constexpr size_t SYSEX_BYTE_COUNT = 16;
+static constexpr size_t TRUNCATED_SYSEX_BYTE_COUNT = MIDI_SYSEX_POOL_SLOT_BYTE_COUNT + 512;
+static constexpr uint64_t MAX_FILE_SIZE = 64 * 1024;
+
+static std::atomic<uint64_t> FailureCount = 0;
+
+static void Check(bool bCondition, const char* Description)
+{
+    if (!bCondition)
+    {
+        std::printf("FAILED: %s\n", Description);
+        FailureCount.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+struct IETestCaptureFile
+{
+    uint64_t MidiEventCount = 0;
+    uint64_t SysExCount = 0;
+    uint64_t TruncatedSysExCount = 0;
+    bool bIsValid = false;
+};
+
+static uint32_t ReadVariableLength(const std::vector<uint8_t>& Bytes, size_t& Offset)
+{
+    uint32_t Value = 0;
+    while (Offset < Bytes.size())
+    {
+        const uint8_t Byte = Bytes[Offset++];
+        Value = (Value << 7) | (Byte & 0x7F);
+        if (!(Byte & 0x80))
+        {
+            break;
+        }
+    }
+    return Value;
+}
+
+// Walks the single track of a capture file up to its end of track, which must close the file
+static IETestCaptureFile ReadCaptureFile(const std::filesystem::path& FilePath)
+{
+    IETestCaptureFile CaptureFile;
+    std::ifstream File(FilePath, std::ios::binary);
+    const std::vector<uint8_t> Bytes = std::vector<uint8_t>(std::istreambuf_iterator<char>(File), std::istreambuf_iterator<char>());
+    if (Bytes.size() < 22 || !std::equal(Bytes.begin(), Bytes.begin() + 4, "MThd") || !std::equal(Bytes.begin() + 14, Bytes.begin() + 18, "MTrk"))
+    {
+        return CaptureFile;
+    }
+
+    const size_t TrackByteCount = (size_t(Bytes[18]) << 24) | (size_t(Bytes[19]) << 16) | (size_t(Bytes[20]) << 8) | Bytes[21];
+    if (22 + TrackByteCount != Bytes.size())
+    {
+        return CaptureFile;
+    }
+
+    size_t Offset = 22;
+    uint8_t RunningStatus = 0;
+    while (Offset < Bytes.size())
+    {
+        ReadVariableLength(Bytes, Offset);
+        const uint8_t Status = Bytes[Offset] & 0x80 ? Bytes[Offset++] : RunningStatus;
+        if (Status == 0xFF)
+        {
+            const uint8_t MetaType = Bytes[Offset++];
+            const uint32_t Length = ReadVariableLength(Bytes, Offset);
+            Offset += Length;
+            if (MetaType == 0x2F)
+            {
+                CaptureFile.bIsValid = Offset == Bytes.size();
+                return CaptureFile;
+            }
+            RunningStatus = 0;
+        }
+        else if (Status == 0xF0 || Status == 0xF7)
+        {
+            const uint32_t Length = ReadVariableLength(Bytes, Offset);
+            if (Status == 0xF0)
+            {
+                CaptureFile.SysExCount++;
+                CaptureFile.TruncatedSysExCount += Length == MIDI_SYSEX_POOL_SLOT_BYTE_COUNT;
+                if (Length == 0 || Offset + Length > Bytes.size() || Bytes[Offset + Length - 1] != 0xF7)
+                {
+                    return CaptureFile;
+                }
+            }
+            Offset += Length;
+            CaptureFile.MidiEventCount++;
+            RunningStatus = 0;
+        }
+        else if (Status >= 0x80)
+        {
+            Offset += IEMidiMessage::GetExpectedSize(Status) - 1;
+            CaptureFile.MidiEventCount++;
+            RunningStatus = Status;
+        }
+        else
+        {
+            return CaptureFile;
+        }
+    }
+    return CaptureFile;
+}
+
+int main(int Argc, char* Argv[])
+{
+    const std::chrono::milliseconds Duration = std::chrono::milliseconds(Argc > 1 ? std::atoi(Argv[1]) : 2000);
+
+    const std::filesystem::path FolderPath = std::filesystem::temp_directory_path() / "IEMidiCaptureWriterTest";
+    std::error_code ErrorCode;
+    std::filesystem::remove_all(FolderPath, ErrorCode);
+
+    IEMidiCaptureWriter CaptureWriter;
+    for (uint32_t DeviceIndex = 0; DeviceIndex < DEVICE_COUNT; DeviceIndex++)
+    {
+        CaptureWriter.OpenQueue(DeviceIndex, "IEMidiCaptureWriterTest " + std::to_string(DeviceIndex));
+    }
+
+    IEMidiCaptureConfig CaptureConfig;
+    CaptureConfig.FolderPath = FolderPath;
+    CaptureConfig.MaxFileSize = MAX_FILE_SIZE;
+    if (const IEResult Result = CaptureWriter.Start(CaptureConfig); !Result)
+    {
+        std::printf("FAILED: %s\n", Result.Message.c_str());
+        return 1;
+    }
+
+    std::atomic<uint64_t> EnqueuedCount = 0;
+    std::atomic<uint64_t> RejectedCount = 0;
+    std::atomic<uint64_t> SentSysExCount = 0;
+    std::atomic<uint64_t> SentTruncatedCount = 0;
+
+    // Sent faster than the writer drains, every message is released before the next one is made
+    std::vector<uint8_t> BurstSysEx(SYSEX_BYTE_COUNT, 0x01);
+    BurstSysEx.front() = 0xF0;
+    BurstSysEx.back() = 0xF7;
+    for (size_t BurstIndex = 0; BurstIndex < MIDI_SYSEX_POOL_SLOT_COUNT * 2; BurstIndex++)
+    {
+        const bool bIsEnqueued = CaptureWriter.Enqueue(0, std::chrono::steady_clock::now(), IEMidiMessage(BurstSysEx.data(), BurstSysEx.size()));
+        EnqueuedCount.fetch_add(bIsEnqueued, std::memory_order_relaxed);
+        SentSysExCount.fetch_add(bIsEnqueued, std::memory_order_relaxed);
+        RejectedCount.fetch_add(!bIsEnqueued, std::memory_order_relaxed);
+    }
+    const uint8_t* const PoolBegin = IEMidiSysExPool::Get().GetData(0);
+    const IEMidiMessage PoolMidiMessage(BurstSysEx.data(), BurstSysEx.size());
+    Check(PoolMidiMessage.data() >= PoolBegin && PoolMidiMessage.data() < PoolBegin + MIDI_SYSEX_POOL_SLOT_COUNT * MIDI_SYSEX_POOL_SLOT_BYTE_COUNT,
+        "Queued captures hold no SysEx pool slot");
+
+    std::vector<std::thread> Threads;
+    for (uint32_t DeviceIndex = 0; DeviceIndex < DEVICE_COUNT; DeviceIndex++)
+    {
+        Threads.emplace_back([&, DeviceIndex]()
+            {
+                std::vector<uint8_t> SysEx(TRUNCATED_SYSEX_BYTE_COUNT, static_cast<uint8_t>(DeviceIndex));
+                SysEx.front() = 0xF0;
+
+                // Sends in one millisecond batches, the way a busy driver hands over its buffer
+                const std::chrono::steady_clock::time_point StartTime = std::chrono::steady_clock::now();
+                uint64_t MessageIndex = 0;
+                for (std::chrono::steady_clock::time_point BatchTime = StartTime; BatchTime - StartTime < Duration; BatchTime += std::chrono::milliseconds(1))
+                {
+                    std::this_thread::sleep_until(BatchTime);
+                    for (uint32_t BatchIndex = 0; BatchIndex < MESSAGES_PER_SECOND_PER_DEVICE / 1000; BatchIndex++, MessageIndex++)
+                    {
+                        IEMidiMessage MidiMessage({static_cast<uint8_t>(0xB0 | DeviceIndex), static_cast<uint8_t>(MessageIndex % 120), static_cast<uint8_t>(MessageIndex % 128)});
+                        if (MessageIndex % SYSEX_INTERVAL == 0)
+                        {
+                            const bool bIsOversized = (MessageIndex / SYSEX_INTERVAL) % TRUNCATED_SYSEX_INTERVAL == 0;
+                            const size_t Size = bIsOversized ? TRUNCATED_SYSEX_BYTE_COUNT : SYSEX_BYTE_COUNT;
+                            SysEx[Size - 1] = 0xF7;
+                            MidiMessage = IEMidiMessage(SysEx.data(), Size);
+                            SysEx[Size - 1] = static_cast<uint8_t>(DeviceIndex);
+                        }
+
+                        if (CaptureWriter.Enqueue(DeviceIndex, std::chrono::steady_clock::now(), MidiMessage))
+                        {
+                            EnqueuedCount.fetch_add(1, std::memory_order_relaxed);
+                            SentSysExCount.fetch_add(MidiMessage.IsSysEx(), std::memory_order_relaxed);
+                            SentTruncatedCount.fetch_add(MidiMessage.IsTruncated(), std::memory_order_relaxed);
+                        }
+                        else
+                        {
+                            RejectedCount.fetch_add(1, std::memory_order_relaxed);
+                        }
+                    }
+                }
+            });
+    }
+
+    for (std::thread& Thread : Threads)
+    {
+        Thread.join();
+    }
+    CaptureWriter.Stop();
+
+    const IEMidiCaptureStats CaptureStats = CaptureWriter.GetStats();
+    std::printf("Captured %llu, wrote %llu to %u file(s) in %.1f MB, dropped %llu, truncated %llu, peak queue depth %llu\n",
+        static_cast<unsigned long long>(CaptureStats.CapturedCount), static_cast<unsigned long long>(CaptureStats.WrittenCount),
+        CaptureStats.FileCount, CaptureStats.WrittenByteCount / (1024.0 * 1024.0), static_cast<unsigned long long>(CaptureStats.DroppedCount),
+        static_cast<unsigned long long>(CaptureStats.TruncatedCount), static_cast<unsigned long long>(CaptureStats.PeakQueueDepth));
+
+    Check(RejectedCount.load() == 0, "No message is rejected at the paced rate");
+    Check(CaptureStats.DroppedCount == 0, "No message is dropped");
+    Check(CaptureStats.CapturedCount == EnqueuedCount.load(), "Every enqueued message is captured");
+    Check(CaptureStats.WrittenCount == CaptureStats.CapturedCount, "Every captured message is written");
+    Check(SentTruncatedCount.load() > 0, "Oversized SysEx was truncated");
+    Check(CaptureStats.TruncatedCount == SentTruncatedCount.load(), "Every truncated SysEx is counted");
+    Check(CaptureStats.FileCount > 1, "The capture rotated files");
+
+    std::vector<std::filesystem::path> FilePaths;
+    for (const std::filesystem::directory_entry& DirectoryEntry : std::filesystem::directory_iterator(FolderPath, ErrorCode))
+    {
+        FilePaths.push_back(DirectoryEntry.path());
+    }
+    Check(FilePaths.size() == CaptureStats.FileCount, "Every capture file is kept");
+
+    uint64_t MidiEventCount = 0;
+    uint64_t SysExCount = 0;
+    uint64_t TruncatedSysExCount = 0;
+    for (const std::filesystem::path& FilePath : FilePaths)
+    {
+        const IETestCaptureFile CaptureFile = ReadCaptureFile(FilePath);
+        Check(CaptureFile.bIsValid, "Every capture file parses up to its end of track");
+        MidiEventCount += CaptureFile.MidiEventCount;
+        SysExCount += CaptureFile.SysExCount;
+        TruncatedSysExCount += CaptureFile.TruncatedSysExCount;
+    }
+    Check(MidiEventCount == CaptureStats.WrittenCount, "The files hold every written message");
+    Check(SysExCount == SentSysExCount.load(), "The files hold every SysEx, each closed with F7");
+    Check(TruncatedSysExCount == CaptureStats.TruncatedCount, "The files hold every truncated SysEx");
+
+    std::filesystem::remove_all(FolderPath, ErrorCode);
+    return FailureCount.load() == 0 ? 0 : 1;
+}
\ No newline at end of file
@@ -0,0 +1,160 @@
+// SPDX-License-Identifier: GPL-2.0-only
+// Copyright © Interactive Echoes. All rights reserved.
+// Author: mozahzah
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "IEMidiCommandRunner.h"
+
+// Turns a few knobs at once, each bound to a command that takes a different time per value to finish,
+// the way a mixer command sometimes stalls. Every command must apply its values in the order they were
+// sent, and end on the last one. A persistent command's helper must keep running while its mapping is
+// retained and exit once it is not.
+
+static constexpr uint32_t KNOB_COUNT = 3;
+static constexpr uint32_t VALUE_COUNT = 200;
+static constexpr char RECORD_SCRIPT[] =
+    "#!/bin/sh\n"
+    "sleep \"0.0$(( $2 * 7 % 5 ))\"\n"
+    "echo \"$2\" >> \"$1.log\"\n"
+    "echo \"$2\" > \"$1\"\n";
+static constexpr char PERSISTENT_RECORD_SCRIPT[] =
+    "#!/bin/sh\n"
+    "while read Value; do echo \"$Value\" > \"$1\"; done\n"
+    "echo exited > \"$1.exit\"\n";
+static constexpr std::chrono::seconds IDLE_TIMEOUT = std::chrono::seconds(30);
+
+static std::atomic<uint64_t> FailureCount = 0;
+
+static void Check(bool bCondition, const char* Description)
+{
+    if (!bCondition)
+    {
+        std::printf("FAILED: %s\n", Description);
+        FailureCount.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+static std::filesystem::path WriteScript(const std::filesystem::path& ScriptPath, const char* Script)
+{
+    std::ofstream(ScriptPath) << Script;
+    std::filesystem::permissions(ScriptPath, std::filesystem::perms::owner_all);
+    return ScriptPath;
+}
+
+// Idle once every accepted value either ran or was replaced by a newer one
+static IEMidiCommandRunnerStats WaitForIdle(const IEMidiCommandRunner& CommandRunner)
+{
+    const std::chrono::steady_clock::time_point StartTime = std::chrono::steady_clock::now();
+    IEMidiCommandRunnerStats CommandRunnerStats = CommandRunner.GetStats();
+    while (CommandRunnerStats.ExecutedCount + CommandRunnerStats.FailedCount + CommandRunnerStats.ReplacedCount + CommandRunnerStats.DroppedCount <
+        CommandRunnerStats.SubmittedCount && std::chrono::steady_clock::now() - StartTime < IDLE_TIMEOUT)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        CommandRunnerStats = CommandRunner.GetStats();
+    }
+    return CommandRunnerStats;
+}
+
+static bool WaitForFile(const std::filesystem::path& FilePath, std::chrono::milliseconds Timeout)
+{
+    const std::chrono::steady_clock::time_point StartTime = std::chrono::steady_clock::now();
+    while (!std::filesystem::exists(FilePath) && std::chrono::steady_clock::now() - StartTime < Timeout)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return std::filesystem::exists(FilePath);
+}
+
+static std::vector<int> ReadValues(const std::filesystem::path& FilePath)
+{
+    std::vector<int> Values;
+    std::ifstream File(FilePath);
+    for (int Value = 0; File >> Value;)
+    {
+        Values.push_back(Value);
+    }
+    return Values;
+}
+
+int main()
+{
+    if (!IEMidiCommandRunner::IsSupported())
+    {
+        std::printf("Console commands run through IEActions on this platform, nothing to test\n");
+        return 0;
+    }
+
+    const std::filesystem::path FolderPath = std::filesystem::temp_directory_path() / "IEMidiCommandRunnerTest";
+    std::error_code ErrorCode;
+    std::filesystem::remove_all(FolderPath, ErrorCode);
+    std::filesystem::create_directories(FolderPath);
+
+    const std::filesystem::path ScriptPath = WriteScript(FolderPath / "record.sh", RECORD_SCRIPT);
+
+    std::vector<std::shared_ptr<const IEMidiCompiledCommand>> CompiledCommands;
+    for (uint32_t KnobIndex = 0; KnobIndex < KNOB_COUNT; KnobIndex++)
+    {
+        const std::filesystem::path ValuePath = FolderPath / ("knob" + std::to_string(KnobIndex));
+        CompiledCommands.push_back(IEMidiCompiledCommand::Compile(ScriptPath.string() + " " + ValuePath.string(), false));
+    }
+
+    IEMidiCommandRunner CommandRunner;
+    for (uint32_t ValueIndex = 0; ValueIndex < VALUE_COUNT; ValueIndex++)
+    {
+        for (const std::shared_ptr<const IEMidiCompiledCommand>& CompiledCommand : CompiledCommands)
+        {
+            Check(CommandRunner.Submit(CompiledCommand, static_cast<float>(ValueIndex)), "Every value is accepted");
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    const IEMidiCommandRunnerStats CommandRunnerStats = WaitForIdle(CommandRunner);
+    std::printf("Submitted %llu, ran %llu, failed %llu, replaced %llu, dropped %llu, peak queue depth %llu\n",
+        static_cast<unsigned long long>(CommandRunnerStats.SubmittedCount), static_cast<unsigned long long>(CommandRunnerStats.ExecutedCount),
+        static_cast<unsigned long long>(CommandRunnerStats.FailedCount), static_cast<unsigned long long>(CommandRunnerStats.ReplacedCount),
+        static_cast<unsigned long long>(CommandRunnerStats.DroppedCount), static_cast<unsigned long long>(CommandRunnerStats.PeakQueueDepth));
+
+    Check(CommandRunnerStats.FailedCount == 0, "No command failed");
+    Check(CommandRunnerStats.DroppedCount == 0, "No value was dropped");
+    Check(CommandRunnerStats.ReplacedCount > 0, "Values sent while a command ran were collapsed");
+    for (uint32_t KnobIndex = 0; KnobIndex < KNOB_COUNT; KnobIndex++)
+    {
+        const std::filesystem::path ValuePath = FolderPath / ("knob" + std::to_string(KnobIndex));
+        const std::vector<int> AppliedValues = ReadValues(ValuePath.string() + ".log");
+        bool bIsInOrder = true;
+        for (size_t ValueIndex = 1; ValueIndex < AppliedValues.size(); ValueIndex++)
+        {
+            bIsInOrder = bIsInOrder && AppliedValues[ValueIndex] > AppliedValues[ValueIndex - 1];
+        }
+        Check(bIsInOrder, "Values are applied in the order they were sent");
+
+        const std::vector<int> FinalValues = ReadValues(ValuePath);
+        Check(FinalValues.size() == 1 && FinalValues.front() == static_cast<int>(VALUE_COUNT - 1), "The last value sent is the final value");
+    }
+
+    const std::filesystem::path PersistentScriptPath = WriteScript(FolderPath / "record_persistent.sh", PERSISTENT_RECORD_SCRIPT);
+    const std::filesystem::path PersistentValuePath = FolderPath / "persistent";
+    const std::string PersistentConsoleCommand = PersistentScriptPath.string() + " " + PersistentValuePath.string();
+    const std::shared_ptr<const IEMidiCompiledCommand> PersistentCompiledCommand = IEMidiCompiledCommand::Compile(PersistentConsoleCommand, true);
+    CommandRunner.RetainPersistentCommands({PersistentConsoleCommand});
+    Check(CommandRunner.Submit(PersistentCompiledCommand, 42.0f), "The persistent value is accepted");
+    WaitForIdle(CommandRunner);
+    Check(WaitForFile(PersistentValuePath, std::chrono::milliseconds(2000)), "The persistent command received its value");
+
+    CommandRunner.RetainPersistentCommands({PersistentConsoleCommand});
+    Check(!WaitForFile(PersistentValuePath.string() + ".exit", std::chrono::milliseconds(200)), "A retained helper keeps running");
+    CommandRunner.RetainPersistentCommands({});
+    Check(WaitForFile(PersistentValuePath.string() + ".exit", std::chrono::milliseconds(2000)), "A helper no profile maps is stopped");
+
+    std::filesystem::remove_all(FolderPath, ErrorCode);
+    return FailureCount.load() == 0 ? 0 : 1;
+}
\ No newline at end of file
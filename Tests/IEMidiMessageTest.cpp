@@ -0,0 +1,100 @@
+// SPDX-License-Identifier: GPL-2.0-only
+// Copyright © Interactive Echoes. All rights reserved.
+// Author: mozahzah
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+#include "IEMidiMessage.h"
+
+// Holds far more SysEx messages alive than the pool has slots, the way full action, capture and learn
+// queues do, from several threads copying and releasing them at once. No SysEx that fits a slot may be
+// truncated, every copy must keep its own bytes, and the pool must be whole again once they are gone.
+
+static constexpr uint32_t THREAD_COUNT = 4;
+static constexpr uint32_t HELD_MESSAGE_COUNT = MIDI_SYSEX_POOL_SLOT_COUNT * 4;
+static constexpr uint32_t ROUND_COUNT = 200;
+static constexpr size_t SYSEX_BYTE_COUNT = 32;
+
+static std::atomic<uint64_t> FailureCount = 0;
+
+static void Check(bool bCondition, const char* Description)
+{
+    if (!bCondition)
+    {
+        std::printf("FAILED: %s\n", Description);
+        FailureCount.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+static std::vector<uint8_t> MakeSysEx(uint32_t ThreadIndex, uint32_t MessageIndex)
+{
+    std::vector<uint8_t> SysEx(SYSEX_BYTE_COUNT, static_cast<uint8_t>((ThreadIndex * 31 + MessageIndex) & 0x7F));
+    SysEx.front() = 0xF0;
+    SysEx.back() = 0xF7;
+    return SysEx;
+}
+
+int main()
+{
+    std::atomic<uint64_t> TruncatedCount = 0;
+    std::atomic<uint64_t> WrongByteCount = 0;
+
+    std::vector<std::thread> Threads;
+    for (uint32_t ThreadIndex = 0; ThreadIndex < THREAD_COUNT; ThreadIndex++)
+    {
+        Threads.emplace_back([&, ThreadIndex]()
+            {
+                for (uint32_t Round = 0; Round < ROUND_COUNT; Round++)
+                {
+                    std::vector<IEMidiMessage> MidiMessages;
+                    std::vector<IEMidiMessage> MidiMessageCopies;
+                    for (uint32_t MessageIndex = 0; MessageIndex < HELD_MESSAGE_COUNT; MessageIndex++)
+                    {
+                        const std::vector<uint8_t> SysEx = MakeSysEx(ThreadIndex, MessageIndex);
+                        MidiMessages.emplace_back(SysEx.data(), SysEx.size());
+                        MidiMessageCopies.push_back(MidiMessages.back());
+                        TruncatedCount.fetch_add(MidiMessages.back().IsTruncated(), std::memory_order_relaxed);
+                    }
+
+                    // Releasing the originals must leave the copies intact
+                    MidiMessages.clear();
+                    for (uint32_t MessageIndex = 0; MessageIndex < HELD_MESSAGE_COUNT; MessageIndex++)
+                    {
+                        const std::vector<uint8_t> SysEx = MakeSysEx(ThreadIndex, MessageIndex);
+                        WrongByteCount.fetch_add(MidiMessageCopies[MessageIndex] != IEMidiMessage(SysEx.data(), SysEx.size()), std::memory_order_relaxed);
+                    }
+                }
+            });
+    }
+
+    for (std::thread& Thread : Threads)
+    {
+        Thread.join();
+    }
+
+    std::printf("Held %u SysEx messages per thread against %zu pool slots, %llu truncated, %llu with wrong bytes\n", HELD_MESSAGE_COUNT,
+        MIDI_SYSEX_POOL_SLOT_COUNT, static_cast<unsigned long long>(TruncatedCount.load()), static_cast<unsigned long long>(WrongByteCount.load()));
+    Check(TruncatedCount.load() == 0, "No SysEx that fits a slot is truncated when the pool is exhausted");
+    Check(WrongByteCount.load() == 0, "Every copy keeps its own bytes");
+
+    // Every slot must be free again, so as many messages as there are slots all land in the pool
+    std::vector<IEMidiMessage> MidiMessages;
+    const std::vector<uint8_t> SysEx = MakeSysEx(0, 0);
+    for (size_t MessageIndex = 0; MessageIndex < MIDI_SYSEX_POOL_SLOT_COUNT; MessageIndex++)
+    {
+        MidiMessages.emplace_back(SysEx.data(), SysEx.size());
+    }
+    const uint8_t* const PoolBegin = IEMidiSysExPool::Get().GetData(0);
+    const uint8_t* const PoolEnd = PoolBegin + MIDI_SYSEX_POOL_SLOT_COUNT * MIDI_SYSEX_POOL_SLOT_BYTE_COUNT;
+    bool bIsPoolWhole = true;
+    for (const IEMidiMessage& MidiMessage : MidiMessages)
+    {
+        bIsPoolWhole = bIsPoolWhole && MidiMessage.data() >= PoolBegin && MidiMessage.data() < PoolEnd;
+    }
+    Check(bIsPoolWhole, "Every pool slot is released");
+    return FailureCount.load() == 0 ? 0 : 1;
+}
\ No newline at end of file
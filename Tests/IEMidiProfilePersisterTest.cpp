@@ -0,0 +1,154 @@
+// SPDX-License-Identifier: GPL-2.0-only
+// Copyright © Interactive Echoes. All rights reserved.
+// Author: mozahzah
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "IEMidiProfilePersister.h"
+
+// Schedules saves from several threads, each to its own writable file and its own file that can not
+// be written because a folder is in the way, flushing now and then like a batch commit does. Every
+// write token must report the outcome of its own file, including after a file that was written fine
+// becomes unwritable, and every writable file must end with the last content scheduled for it. Content
+// that is still debounced must be readable before it lands, and a write scheduled now or a removal must
+// not wait for it.
+
+static constexpr uint32_t THREAD_COUNT = 4;
+static constexpr uint32_t SAVE_COUNT = 400;
+static constexpr uint32_t FLUSH_INTERVAL = 50;
+static constexpr std::chrono::seconds LONG_DEBOUNCE_INTERVAL = std::chrono::seconds(60);
+
+static std::atomic<uint64_t> FailureCount = 0;
+
+static void Check(bool bCondition, const char* Description)
+{
+    if (!bCondition)
+    {
+        std::printf("FAILED: %s\n", Description);
+        FailureCount.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+static std::string ReadFile(const std::filesystem::path& FilePath)
+{
+    std::ifstream File(FilePath, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(File), std::istreambuf_iterator<char>());
+}
+
+// Every content has the same size, so a file stamp alone could not tell two writes apart
+static std::string MakeContent(uint32_t ThreadIndex, uint32_t SaveIndex)
+{
+    char Content[32] = {};
+    std::snprintf(Content, sizeof(Content), "Profile: %02u-%06u\n", ThreadIndex, SaveIndex);
+    return Content;
+}
+
+int main()
+{
+    const std::filesystem::path FolderPath = std::filesystem::temp_directory_path() / "IEMidiProfilePersisterTest";
+    std::error_code ErrorCode;
+    std::filesystem::remove_all(FolderPath, ErrorCode);
+    std::filesystem::create_directories(FolderPath);
+
+    IEMidiProfilePersister ProfilePersister(IEMidiFsyncPolicy::None, std::chrono::milliseconds(1));
+    std::atomic<uint64_t> WrittenCount = 0;
+    std::atomic<uint64_t> WrongResultCount = 0;
+
+    std::vector<std::thread> Threads;
+    for (uint32_t ThreadIndex = 0; ThreadIndex < THREAD_COUNT; ThreadIndex++)
+    {
+        Threads.emplace_back([&, ThreadIndex]()
+            {
+                const std::filesystem::path FilePath = FolderPath / ("profile" + std::to_string(ThreadIndex) + ".yaml");
+                const std::filesystem::path BlockedFilePath = FolderPath / ("blocked" + std::to_string(ThreadIndex) + ".yaml");
+                std::filesystem::create_directories(BlockedFilePath / "occupied");
+
+                std::vector<IEMidiProfilePersister::IEWriteToken> WriteTokens;
+                std::vector<IEMidiProfilePersister::IEWriteToken> BlockedWriteTokens;
+                for (uint32_t SaveIndex = 0; SaveIndex < SAVE_COUNT; SaveIndex++)
+                {
+                    WriteTokens.push_back(ProfilePersister.Schedule(FilePath, MakeContent(ThreadIndex, SaveIndex), false));
+                    BlockedWriteTokens.push_back(ProfilePersister.Schedule(BlockedFilePath, MakeContent(ThreadIndex, SaveIndex), false));
+                    if (SaveIndex % FLUSH_INTERVAL == FLUSH_INTERVAL - 1)
+                    {
+                        ProfilePersister.Flush();
+                    }
+                }
+                ProfilePersister.Flush();
+
+                for (const IEMidiProfilePersister::IEWriteToken& WriteToken : WriteTokens)
+                {
+                    WrittenCount.fetch_add(static_cast<bool>(WriteToken.get()), std::memory_order_relaxed);
+                    WrongResultCount.fetch_add(!WriteToken.get(), std::memory_order_relaxed);
+                }
+                for (const IEMidiProfilePersister::IEWriteToken& BlockedWriteToken : BlockedWriteTokens)
+                {
+                    WrongResultCount.fetch_add(static_cast<bool>(BlockedWriteToken.get()), std::memory_order_relaxed);
+                }
+
+                if (ReadFile(FilePath) != MakeContent(ThreadIndex, SAVE_COUNT - 1))
+                {
+                    WrongResultCount.fetch_add(1, std::memory_order_relaxed);
+                }
+            });
+    }
+
+    for (std::thread& Thread : Threads)
+    {
+        Thread.join();
+    }
+
+    std::printf("Scheduled %u saves per file, %llu reported written, %llu wrong results\n", SAVE_COUNT,
+        static_cast<unsigned long long>(WrittenCount.load()), static_cast<unsigned long long>(WrongResultCount.load()));
+    Check(WrongResultCount.load() == 0, "Every write token reports the outcome of its own file");
+    Check(WrittenCount.load() == THREAD_COUNT * SAVE_COUNT, "Every save to a writable file is reported written");
+
+    // A file written before keeps its last written stamp, the token must still report the new failure
+    const std::filesystem::path FilePath = FolderPath / "profile0.yaml";
+    Check(ProfilePersister.GetLastWrittenStamp(FilePath).has_value(), "The last written stamp is kept");
+    std::filesystem::remove(FilePath, ErrorCode);
+    std::filesystem::create_directories(FilePath / "occupied");
+    const IEMidiProfilePersister::IEWriteToken WriteToken = ProfilePersister.Schedule(FilePath, MakeContent(0, SAVE_COUNT), false);
+    ProfilePersister.Flush();
+    Check(!WriteToken.get(), "A write that fails after earlier ones succeeded is reported failed");
+
+    // Content replaced before it is written shares the result of the write that replaced it
+    const std::filesystem::path ReplacedFilePath = FolderPath / "replaced.yaml";
+    const IEMidiProfilePersister::IEWriteToken FirstWriteToken = ProfilePersister.Schedule(ReplacedFilePath, MakeContent(0, 0), false);
+    const IEMidiProfilePersister::IEWriteToken SecondWriteToken = ProfilePersister.Schedule(ReplacedFilePath, MakeContent(0, 1), false);
+    ProfilePersister.Flush();
+    Check(FirstWriteToken.get() && SecondWriteToken.get(), "Replaced content is reported written with its replacement");
+    Check(ReadFile(ReplacedFilePath) == MakeContent(0, 1), "Only the replacing content is on disk");
+
+    {
+        IEMidiProfilePersister DebouncedProfilePersister(IEMidiFsyncPolicy::None, LONG_DEBOUNCE_INTERVAL);
+        const std::filesystem::path DebouncedFilePath = FolderPath / "debounced.yaml";
+        const std::filesystem::path ImmediateFilePath = FolderPath / "immediate.yaml";
+        DebouncedProfilePersister.Schedule(DebouncedFilePath, MakeContent(1, 0), false);
+        Check(DebouncedProfilePersister.GetPendingContent(DebouncedFilePath) == MakeContent(1, 0), "Debounced content is readable before it lands");
+        Check(!DebouncedProfilePersister.GetPendingContent(ImmediateFilePath).has_value(), "A file with nothing scheduled has no pending content");
+
+        Check(static_cast<bool>(DebouncedProfilePersister.ScheduleNow(ImmediateFilePath, MakeContent(1, 1)).get()), "A write scheduled now is written");
+        Check(ReadFile(ImmediateFilePath) == MakeContent(1, 1), "A write scheduled now is on disk");
+        Check(DebouncedProfilePersister.HasPendingWrite(DebouncedFilePath), "A write scheduled now does not flush other files");
+
+        const IEMidiProfilePersister::IEWriteToken RemovalToken = DebouncedProfilePersister.ScheduleRemoval(ImmediateFilePath);
+        DebouncedProfilePersister.ScheduleRemoval(DebouncedFilePath);
+        Check(DebouncedProfilePersister.GetPendingContent(DebouncedFilePath) == std::string(), "A pending removal reads as empty content");
+        DebouncedProfilePersister.Flush();
+        Check(RemovalToken.get() && !std::filesystem::exists(ImmediateFilePath), "A written file is removed");
+        Check(!std::filesystem::exists(DebouncedFilePath), "A removal drops the write it replaced");
+    }
+
+    std::filesystem::remove_all(FolderPath, ErrorCode);
+    return FailureCount.load() == 0 ? 0 : 1;
+}
\ No newline at end of file
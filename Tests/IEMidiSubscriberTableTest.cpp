@@ -0,0 +1,153 @@
+// SPDX-License-Identifier: GPL-2.0-only
+// Copyright © Interactive Echoes. All rights reserved.
+// Author: mozahzah
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "IEMidiSubscriberTable.h"
+
+// Subscribes and unsubscribes from several threads while others dispatch. Every subscriber is freed
+// right after Unsubscribe returns, so a dispatch that outlives its subscriber reads freed memory,
+// which the checks below and a sanitizer build catch.
+
+static constexpr uint32_t DISPATCH_THREAD_COUNT = 2;
+static constexpr uint32_t CHURN_THREAD_COUNT = 4;
+static constexpr uint32_t LIVE_SUBSCRIBER_MAGIC = 0x1E5B5C1B;
+static constexpr uint32_t DEAD_SUBSCRIBER_MAGIC = 0xDEADDEAD;
+
+struct IETestSubscriber
+{
+    std::atomic<uint32_t> Magic = LIVE_SUBSCRIBER_MAGIC;
+    std::atomic<uint64_t> CallCount = 0;
+};
+
+static std::atomic<uint64_t> TotalCallCount = 0;
+static std::atomic<uint64_t> FailureCount = 0;
+
+static void OnMidiMessage(void* Object, double TimeStamp, const IEMidiMessage& MidiMessage)
+{
+    IETestSubscriber* const TestSubscriber = static_cast<IETestSubscriber*>(Object);
+    if (TestSubscriber->Magic.load(std::memory_order_relaxed) != LIVE_SUBSCRIBER_MAGIC || MidiMessage[0] != 0xB0)
+    {
+        FailureCount.fetch_add(1, std::memory_order_relaxed);
+    }
+    TestSubscriber->CallCount.fetch_add(1, std::memory_order_relaxed);
+    TotalCallCount.fetch_add(1, std::memory_order_relaxed);
+}
+
+static void Check(bool bCondition, const char* Description)
+{
+    if (!bCondition)
+    {
+        std::printf("FAILED: %s\n", Description);
+        FailureCount.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+int main(int Argc, char* Argv[])
+{
+    const std::chrono::milliseconds Duration = std::chrono::milliseconds(Argc > 1 ? std::atoi(Argv[1]) : 2000);
+
+    IEMidiSubscriberTable SubscriberTable;
+    std::atomic<bool> bIsRunning = true;
+    std::atomic<uint64_t> DispatchCount = 0;
+    std::atomic<uint64_t> SubscriptionCount = 0;
+    std::atomic<uint64_t> FullTableCount = 0;
+
+    std::vector<std::thread> Threads;
+    for (uint32_t ThreadIndex = 0; ThreadIndex < DISPATCH_THREAD_COUNT; ThreadIndex++)
+    {
+        Threads.emplace_back([&]()
+            {
+                const IEMidiMessage MidiMessage({0xB0, 7, 64});
+                while (bIsRunning.load(std::memory_order_relaxed))
+                {
+                    SubscriberTable.Dispatch(0.0, MidiMessage);
+                    DispatchCount.fetch_add(1, std::memory_order_relaxed);
+                }
+            });
+    }
+
+    for (uint32_t ThreadIndex = 0; ThreadIndex < CHURN_THREAD_COUNT; ThreadIndex++)
+    {
+        Threads.emplace_back([&, ThreadIndex]()
+            {
+                uint32_t Iteration = 0;
+                while (bIsRunning.load(std::memory_order_relaxed))
+                {
+                    // Hold a varying number of subscriptions, up to the whole table between all threads
+                    const uint32_t HeldCount = 1 + (Iteration++ + ThreadIndex) % (IEMidiSubscriberTable::MAX_SUBSCRIBER_COUNT / CHURN_THREAD_COUNT);
+                    std::vector<std::pair<uint32_t, std::unique_ptr<IETestSubscriber>>> Subscriptions;
+                    for (uint32_t SubscriptionIndex = 0; SubscriptionIndex < HeldCount; SubscriptionIndex++)
+                    {
+                        std::unique_ptr<IETestSubscriber> TestSubscriber = std::make_unique<IETestSubscriber>();
+                        const uint32_t Handle = SubscriberTable.Subscribe(&OnMidiMessage, TestSubscriber.get());
+                        if (Handle == IEMidiSubscriberTable::INVALID_HANDLE)
+                        {
+                            FullTableCount.fetch_add(1, std::memory_order_relaxed);
+                            continue;
+                        }
+                        Subscriptions.emplace_back(Handle, std::move(TestSubscriber));
+                        SubscriptionCount.fetch_add(1, std::memory_order_relaxed);
+                    }
+
+                    if (Iteration % 8 == 0)
+                    {
+                        std::this_thread::yield();
+                    }
+
+                    for (std::pair<uint32_t, std::unique_ptr<IETestSubscriber>>& Subscription : Subscriptions)
+                    {
+                        Check(SubscriberTable.Unsubscribe(Subscription.first), "Unsubscribe of a live handle succeeds");
+                        Check(!SubscriberTable.Unsubscribe(Subscription.first), "Unsubscribe of a stale handle fails");
+
+                        // No dispatch may reach the subscriber from here on
+                        const uint64_t CallCount = Subscription.second->CallCount.load(std::memory_order_relaxed);
+                        Subscription.second->Magic.store(DEAD_SUBSCRIBER_MAGIC, std::memory_order_relaxed);
+                        std::this_thread::yield();
+                        Check(Subscription.second->CallCount.load(std::memory_order_relaxed) == CallCount, "No dispatch after Unsubscribe returned");
+                        Subscription.second.reset();
+                    }
+                }
+            });
+    }
+
+    std::this_thread::sleep_for(Duration);
+    bIsRunning.store(false, std::memory_order_relaxed);
+    for (std::thread& Thread : Threads)
+    {
+        Thread.join();
+    }
+
+    Check(SubscriberTable.GetSubscriberCount() == 0, "Table is empty once every subscriber left");
+    Check(TotalCallCount.load() > 0, "Subscribers were dispatched to");
+
+    // Slots freed by the churn are reusable and old handles stay dead
+    IETestSubscriber TestSubscriber;
+    std::vector<uint32_t> Handles;
+    for (uint32_t SubscriberIndex = 0; SubscriberIndex < IEMidiSubscriberTable::MAX_SUBSCRIBER_COUNT; SubscriberIndex++)
+    {
+        Handles.push_back(SubscriberTable.Subscribe(&OnMidiMessage, &TestSubscriber));
+        Check(Handles.back() != IEMidiSubscriberTable::INVALID_HANDLE, "Every slot can be subscribed again");
+    }
+    Check(SubscriberTable.Subscribe(&OnMidiMessage, &TestSubscriber) == IEMidiSubscriberTable::INVALID_HANDLE, "A full table rejects subscribers");
+    SubscriberTable.Dispatch(0.0, IEMidiMessage({0xB0, 7, 64}));
+    Check(TestSubscriber.CallCount.load() == IEMidiSubscriberTable::MAX_SUBSCRIBER_COUNT, "Dispatch reaches every subscriber once");
+    for (const uint32_t Handle : Handles)
+    {
+        Check(SubscriberTable.Unsubscribe(Handle), "Unsubscribe after refill succeeds");
+    }
+
+    std::printf("%llu dispatches, %llu subscriptions, %llu callbacks, %llu full table rejections, %llu failures\n",
+        static_cast<unsigned long long>(DispatchCount.load()), static_cast<unsigned long long>(SubscriptionCount.load()),
+        static_cast<unsigned long long>(TotalCallCount.load()), static_cast<unsigned long long>(FullTableCount.load()),
+        static_cast<unsigned long long>(FailureCount.load()));
+    return FailureCount.load() == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
\ No newline at end of file